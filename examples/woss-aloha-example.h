@@ -60,12 +60,21 @@ public:
   Time m_simTime;   //!< Simulation time per trial
 
   std::string m_databasePath; //!< The path to the WOSS databases.
+  std::string m_envSnapshotFile; //!< Environment snapshot used instead of the WOSS databases.
   bool m_useMultithread; //!< Enable/disable WOSS multithread feature.
   bool m_useThreadPool; //!< Enable/disable WOSS multithread thread pool feature.
   bool m_useTimeEvolution; //!< Enable/disable the WOSS time evolution feature.
+  bool m_useStubCreator; //!< Enable/disable the Bellhop-free WOSS stub channel simulator.
+  bool m_useProfiler; //!< Enable/disable the WossProfiler attached to the WossPropModel.
+  uint32_t m_totalThreads; //!< Number of WOSS concurrent threads (0 = auto).
   uint32_t m_bytesTotal; //!< Total number of bytes received in a simulation run.
   UanTxMode m_dataMode; //!< List of UanTxModes used for data channels.
 
+  double m_wallTime; //!< Wall clock time of the last Simulator::Run () in seconds.
+  uint64_t m_eventCount; //!< Number of events executed in the last simulation run.
+  uint64_t m_channelRequests; //!< Number of channel (time arrival) requests of the last simulation run, 0 without profiler.
+  uint64_t m_channelSimRuns; //!< Number of channel simulator runs of the last simulation run, only counted by the stub creator.
+
   /**
   * Callback to receive a packet.
   *
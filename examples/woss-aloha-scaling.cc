@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+/**
+ * \file woss-aloha-scaling.cc
+ * \ingroup WOSS
+ *
+ * Scaling benchmark built on the woss-aloha-example Experiment class.
+ * It sweeps node count, WOSS thread count, multithread / thread pool flags,
+ * position allocator and time evolution, and appends one CSV row per run with
+ * wall clock time, events per second, peak RSS and channel requests.
+ * With the stub creator, channel simulator runs and result cache hit rate
+ * are appended as well; Bellhop runs are not counted, so these columns are
+ * omitted.
+ * Lists are given as comma separated values, e.g. --NumberNodes=2,8,32
+ */
+
+#ifndef NS3_WOSS_SUPPORT
+int
+main (int argc, char *argv[])
+{
+  return 0;
+}
+#else
+
+#include "woss-aloha-example.h"
+#include "ns3/core-module.h"
+#include "ns3/log.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WossAlohaScaling");
+
+namespace {
+
+/**
+ * Parses a comma separated list of unsigned integers
+ * \param list the list string
+ * \returns the parsed values
+ */
+std::vector<uint32_t>
+ParseList (const std::string &list)
+{
+  std::vector<uint32_t> retVal;
+  std::istringstream iss (list);
+  std::string token;
+
+  while (std::getline (iss, token, ','))
+    {
+      if (token != "")
+        {
+          retVal.push_back (std::stoul (token));
+        }
+    }
+
+  if (retVal.empty ())
+    {
+      NS_FATAL_ERROR ("empty list provided: " << list);
+    }
+
+  return retVal;
+}
+
+/**
+ * \returns the peak resident set size of the process in KiB
+ */
+long
+GetPeakRssKb (void)
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    {
+      return -1;
+    }
+
+  return usage.ru_maxrss;
+}
+
+} // namespace
+
+
+int
+main (int argc, char *argv[])
+{
+  std::string nodesList = "2,8,32";
+  std::string threadsList = "0";
+  std::string multithreadList = "1";
+  std::string threadPoolList = "1";
+  std::string posAllocList = "0";
+  std::string timeEvolutionList = "0";
+  std::string outputFile = "woss-aloha-scaling.csv";
+  bool useStubCreator = true;
+  Time simTime = Seconds (100);
+
+  CommandLine cmd;
+  cmd.AddValue ("NumberNodes", "Comma separated list of node counts", nodesList);
+  cmd.AddValue ("TotalThreads", "Comma separated list of WOSS concurrent threads (0 = auto)", threadsList);
+  cmd.AddValue ("UseMultithread", "Comma separated list of WOSS multithread flags (0/1)", multithreadList);
+  cmd.AddValue ("UseThreadPool", "Comma separated list of WOSS thread pool flags (0/1)", threadPoolList);
+  cmd.AddValue ("PosAllocSelector", "Comma separated list of position allocators: 0 list, 1 grid, 2 random rectangle, 3 random disc", posAllocList);
+  cmd.AddValue ("UseTimeEvolution", "Comma separated list of WOSS time evolution flags (0/1)", timeEvolutionList);
+  cmd.AddValue ("UseStubCreator", "flag to replace Bellhop with the WOSS stub channel simulator", useStubCreator);
+  cmd.AddValue ("SimTime", "Simulation time per run", simTime);
+  cmd.AddValue ("OutputFile", "CSV output file", outputFile);
+  cmd.Parse (argc, argv);
+
+  std::ofstream csv (outputFile);
+
+  if (!csv.is_open ())
+    {
+      NS_FATAL_ERROR ("can't open output file " << outputFile);
+    }
+
+  csv << "nodes,threads,multithread,thread_pool,pos_alloc,time_evolution,stub,"
+      << "wall_time_s,events,events_per_s,peak_rss_kb,channel_requests,";
+
+  if (useStubCreator)
+    {
+      csv << "channel_sim_runs,cache_hit_rate,";
+    }
+
+  csv << "bytes_rx" << std::endl;
+
+  for (uint32_t nodes : ParseList (nodesList))
+    for (uint32_t threads : ParseList (threadsList))
+      for (uint32_t multithread : ParseList (multithreadList))
+        for (uint32_t threadPool : ParseList (threadPoolList))
+          for (uint32_t posAlloc : ParseList (posAllocList))
+            for (uint32_t timeEvolution : ParseList (timeEvolutionList))
+              {
+                Experiment exp;
+                exp.m_numNodes = nodes;
+                exp.m_totalThreads = threads;
+                exp.m_useMultithread = (multithread != 0);
+                exp.m_useThreadPool = (threadPool != 0);
+                exp.m_posAllocSelector = posAlloc;
+                exp.m_useTimeEvolution = (timeEvolution != 0);
+                exp.m_useStubCreator = useStubCreator;
+                exp.m_useProfiler = true;
+                exp.m_simTime = simTime;
+
+                uint32_t bytesRx = exp.Run (nodes);
+
+                double eventsPerSecond = (exp.m_wallTime > 0.0) ? exp.m_eventCount / exp.m_wallTime : 0.0;
+                // ru_maxrss is the peak of the whole process, hence it is monotonic across runs
+                csv << nodes << "," << threads << "," << multithread << "," << threadPool << ","
+                    << posAlloc << "," << timeEvolution << "," << useStubCreator << ","
+                    << exp.m_wallTime << "," << exp.m_eventCount << "," << eventsPerSecond << ","
+                    << GetPeakRssKb () << "," << exp.m_channelRequests << ",";
+
+                if (useStubCreator)
+                  {
+                    double cacheHitRate = (exp.m_channelRequests > 0) ? 1.0 - (double) exp.m_channelSimRuns / exp.m_channelRequests : 0.0;
+
+                    csv << exp.m_channelSimRuns << "," << cacheHitRate << ",";
+                  }
+
+                csv << bytesRx << std::endl;
+
+                NS_LOG_UNCOND ("nodes=" << nodes << " threads=" << threads << " wall time=" << exp.m_wallTime
+                               << "s events/s=" << eventsPerSecond);
+              }
+
+  return 0;
+}
+
+#endif // NS3_WOSS_SUPPORT
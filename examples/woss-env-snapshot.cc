@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+/**
+ * \file woss-env-snapshot.cc
+ * \ingroup WOSS
+ *
+ * Extracts bathymetry, SSP and sediment of a region of interest from the GEBCO, WOA and DECK41
+ * databases into a compact environment snapshot. The snapshot can then be loaded by any simulation through the
+ * WossHelper "WossDbSnapshotFile" attribute (e.g. woss-aloha-example --EnvSnapshot=...), without opening the databases.
+ * Tile sizes are set with the WossHelper attributes, e.g. --ns3::WossHelper::WossDbBathymetryTileSize=0.004166
+ */
+
+#ifndef NS3_WOSS_SUPPORT
+int
+main (int argc, char *argv[])
+{
+  return 0;
+}
+#else
+
+#include "ns3/core-module.h"
+#include "ns3/woss-helper.h"
+#include "ns3/woss-prop-model.h"
+#include "ns3/log.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WossEnvSnapshot");
+
+
+int
+main (int argc, char *argv[])
+{
+  std::string databasePath = "";
+  std::string outputFile = "woss-env-snapshot.bin";
+  std::string simTime = "1|10|2012|0|1|1|1|10|2012|0|1|1";
+  double minLatitude = 42.5;
+  double minLongitude = 10.0;
+  double maxLatitude = 42.7;
+  double maxLongitude = 10.3;
+
+  CommandLine cmd;
+  cmd.AddValue ("DatabasePath", "The path to the WOSS databases", databasePath);
+  cmd.AddValue ("OutputFile", "The snapshot file", outputFile);
+  cmd.AddValue ("SimTime", "WOSS simulation times, the SSP is sampled at the start time", simTime);
+  cmd.AddValue ("MinLatitude", "South boundary of the region [dec degrees]", minLatitude);
+  cmd.AddValue ("MinLongitude", "West boundary of the region [dec degrees]", minLongitude);
+  cmd.AddValue ("MaxLatitude", "North boundary of the region [dec degrees]", maxLatitude);
+  cmd.AddValue ("MaxLongitude", "East boundary of the region [dec degrees]", maxLongitude);
+  cmd.Parse (argc, argv);
+
+  if (databasePath == "")
+    {
+      NS_FATAL_ERROR ("DatabasePath is required");
+    }
+
+  Ptr<WossPropModel> wossProp = CreateObject<WossPropModel> ();
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+
+#if defined (WOSS_NETCDF_SUPPORT)
+  wossHelper->SetAttribute ("SedimDbCoordFilePath", StringValue (databasePath + "/seafloor_sediment/DECK41_V2_coordinates.nc"));
+  wossHelper->SetAttribute ("SedimDbMarsdenFilePath", StringValue (databasePath + "/seafloor_sediment/DECK41_V2_marsden_square.nc"));
+  wossHelper->SetAttribute ("SedimDbMarsdenOneFilePath", StringValue (databasePath + "/seafloor_sediment/DECK41_V2_marsden_one_degree.nc"));
+#if defined (WOSS_NETCDF4_SUPPORT)
+  wossHelper->SetAttribute ("BathyDbGebcoFormat", IntegerValue (4)); // 15 seconds, 2D netcdf format
+  wossHelper->SetAttribute ("BathyDbCoordFilePath", StringValue (databasePath + "/bathymetry/GEBCO_2025_sub_ice.nc"));
+  wossHelper->SetAttribute ("SspDbWoaDbType", IntegerValue (1)); // 2013 WOA DB Format
+  wossHelper->SetAttribute ("SspDbCoordFilePath", StringValue (databasePath + "/ssp/WOA2023/WOA2023_SSP_April.nc"));
+  wossHelper->SetAttribute ("SedimentDbDeck41DbType", IntegerValue (1)); // DECK41 V2 database data format
+#else
+  wossHelper->SetAttribute ("BathyDbGebcoFormat", IntegerValue (3)); // 30 seconds, 2D netcdf format
+  wossHelper->SetAttribute ("BathyDbCoordFilePath", StringValue (databasePath + "/bathymetry/GEBCO_2014_2D.nc"));
+  wossHelper->SetAttribute ("SspDbCoordFilePath", StringValue (databasePath + "/ssp/WOA2009/2WOA2009_SSP_April.nc"));
+#endif // defined (WOSS_NETCDF4_SUPPORT)
+#else
+  NS_FATAL_ERROR ("WOSS has been built without NetCDF support, no database can be read");
+#endif // defined (WOSS_NETCDF_SUPPORT)
+  wossHelper->SetAttribute ("WossSimTime", StringValue (simTime));
+  wossHelper->SetAttribute ("WossManagerUseMultithread", BooleanValue (false));
+
+  wossHelper->Initialize (wossProp);
+
+  double startTime = WossProfiler::GetWallTime ();
+
+  wossHelper->PreloadEnvironment (woss::Coord (minLatitude, minLongitude), woss::Coord (maxLatitude, maxLongitude));
+
+  double preloadTime = WossProfiler::GetWallTime () - startTime;
+
+  if (wossHelper->SaveEnvironmentSnapshot (outputFile) == false)
+    {
+      NS_FATAL_ERROR ("Can't write the snapshot " << outputFile);
+    }
+
+  NS_LOG_UNCOND ("snapshot " << outputFile << " written, databases sampled in " << preloadTime << " s");
+
+  Simulator::Destroy ();
+
+  return 0;
+}
+
+#endif // NS3_WOSS_SUPPORT
@@ -0,0 +1,521 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+/**
+ * \file woss-micro-benchmark.cc
+ * \ingroup WOSS
+ *
+ * Micro benchmarks of the WOSS integration hot paths. All inputs are synthetic:
+ * neither Bellhop nor the environmental databases are needed.
+ * Every benchmark is run with sizes (taps, receivers or positions) from 2 to MaxSize,
+ * the number of iterations is increased until MinTime seconds are spent, and the
+ * time per iteration is printed, google-benchmark style.
+ */
+
+#ifndef NS3_WOSS_SUPPORT
+int
+main (int argc, char *argv[])
+{
+  return 0;
+}
+#else
+
+#include <cmath>
+#include <complex>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/woss-channel.h"
+#include "ns3/woss-prop-model.h"
+#include "ns3/woss-position-allocator.h"
+#include "ns3/woss-profiler.h"
+#include "ns3/woss-helper.h"
+#include "ns3/woss-waypoint-mobility-model.h"
+#include "ns3/woss-geo-waypoint-mobility-model.h"
+#include <time-arr.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WossMicroBenchmark");
+
+namespace {
+
+/**
+ * WossPropModel exposing the protected conversion functions
+ */
+class BenchPropModel : public WossPropModel
+{
+public:
+  using WossPropModel::CreateUanPdp;
+  using WossPropModel::CreateUanPdpVector;
+  using WossPropModel::CreateCoordzPairVector;
+};
+
+/**
+ * WossChannel exposing the protected tap loop
+ */
+class BenchChannel : public WossChannel
+{
+public:
+  using WossChannel::ComputeRxPowerAndDelay;
+};
+
+const double BENCH_SYMBOL_TIME = 1.0 / 200.0; //!< synthetic symbol time [s]
+const double BENCH_LATITUDE = 42.59; //!< reference latitude [dec degrees]
+const double BENCH_LONGITUDE = 10.125; //!< reference longitude [dec degrees]
+const double BENCH_DEPTH = 70.0; //!< reference depth [m]
+
+double g_minTime = 0.5; //!< minimum time spent in each benchmark [s]
+std::string g_filter = ""; //!< only benchmarks whose name contains this string are run
+volatile double g_sink = 0.0; //!< prevents the compiler from optimizing out the measured code
+
+/**
+ * Runs a benchmark, doubling the number of iterations until g_minTime is reached
+ * \param name benchmark name
+ * \param size benchmark size
+ * \param body function executing one iteration
+ */
+template <typename F>
+void
+RunBenchmark (const std::string &name, uint32_t size, F body)
+{
+  std::string fullName = name + "/" + std::to_string (size);
+
+  if (g_filter != "" && fullName.find (g_filter) == std::string::npos)
+    {
+      return;
+    }
+
+  uint64_t iterations = 1;
+  double elapsed = 0.0;
+
+  while (true)
+    {
+      double start = WossProfiler::GetWallTime ();
+
+      for (uint64_t i = 0; i < iterations; ++i)
+        {
+          body ();
+        }
+
+      elapsed = WossProfiler::GetWallTime () - start;
+
+      if (elapsed >= g_minTime || iterations >= (1ULL << 32))
+        {
+          break;
+        }
+
+      iterations *= 2;
+    }
+
+  double timePerIter = elapsed / iterations;
+
+  std::cout << std::left << std::setw (48) << fullName
+            << std::right << std::setw (16) << std::fixed << std::setprecision (1) << timePerIter * 1.0E9 << " ns"
+            << std::setw (16) << std::setprecision (1) << timePerIter * 1.0E9 / size << " ns/item"
+            << std::setw (14) << iterations << std::endl;
+}
+
+/**
+ * Creates a synthetic woss::TimeArr whose coherent sum has nTaps taps at symbol time
+ * \param nTaps number of taps
+ * \returns the woss::TimeArr
+ */
+std::unique_ptr<woss::TimeArr>
+CreateSyntheticTimeArr (uint32_t nTaps)
+{
+  auto timeArr = std::make_unique<woss::TimeArr> ();
+
+  for (uint32_t i = 0; i < nTaps; ++i)
+    {
+      double delay = 1.0 + i * BENCH_SYMBOL_TIME;
+      double amp = 1.0E-3 * std::exp (-0.01 * i);
+      double phase = 0.7 * i;
+
+      timeArr->insertValue (delay, std::polar (amp, phase));
+    }
+
+  return timeArr;
+}
+
+/**
+ * Creates a synthetic UanPdp with nTaps taps at symbol time
+ * \param nTaps number of taps
+ * \returns the UanPdp
+ */
+UanPdp
+CreateSyntheticPdp (uint32_t nTaps)
+{
+  std::vector< Tap > taps;
+
+  for (uint32_t i = 0; i < nTaps; ++i)
+    {
+      taps.push_back (Tap (Seconds (1.0 + i * BENCH_SYMBOL_TIME), std::polar (1.0E-3 * std::exp (-0.01 * i), 0.7 * i)));
+    }
+
+  return UanPdp (taps, Seconds (BENCH_SYMBOL_TIME));
+}
+
+/**
+ * Creates nPos mobility models placed along a line starting from the reference position
+ * \param nPos number of mobility models
+ * \returns the mobility models
+ */
+WossPropModel::MobModelVector
+CreateSyntheticMobility (uint32_t nPos)
+{
+  WossPropModel::MobModelVector retVal;
+  woss::CoordZ refCoordZ (BENCH_LATITUDE, BENCH_LONGITUDE, BENCH_DEPTH);
+
+  for (uint32_t i = 0; i < nPos; ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+      woss::CoordZ coordZ (woss::Coord::getCoordFromBearing (refCoordZ, M_PI / 2.0, (i + 1) * 100.0), BENCH_DEPTH);
+
+      mob->SetPosition (CreateVectorFromCoordZ (coordZ));
+      retVal.push_back (mob);
+    }
+
+  return retVal;
+}
+
+void
+BenchCreateUanPdp (Ptr<BenchPropModel> propModel, uint32_t size)
+{
+  auto timeArr = CreateSyntheticTimeArr (size);
+
+  // clone cost, to be subtracted from the CreateUanPdp figures
+  RunBenchmark ("BM_TimeArrClone", size, [&] ()
+    {
+      std::unique_ptr<woss::TimeArr> copy (timeArr->clone ());
+      g_sink = g_sink + copy->size ();
+    });
+
+  RunBenchmark ("BM_CreateUanPdp", size, [&] ()
+    {
+      UanPdp pdp = propModel->CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr->clone ()), BENCH_SYMBOL_TIME);
+      g_sink = g_sink + pdp.GetNTaps ();
+    });
+}
+
+void
+BenchCreateUanPdpVector (Ptr<BenchPropModel> propModel, uint32_t size)
+{
+  const uint32_t nTaps = 16;
+  auto timeArr = CreateSyntheticTimeArr (nTaps);
+
+  RunBenchmark ("BM_CreateUanPdpVector", size, [&] ()
+    {
+      woss::TimeArrVector timeArrVector;
+
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          timeArrVector.push_back (std::unique_ptr<woss::TimeArr> (timeArr->clone ()));
+        }
+
+      WossPropModel::UanPdpVector pdpVector = propModel->CreateUanPdpVector (timeArrVector, BENCH_SYMBOL_TIME);
+      g_sink = g_sink + pdpVector.size ();
+    });
+}
+
+void
+BenchCreateCoordzPairVector (Ptr<BenchPropModel> propModel, uint32_t size)
+{
+  WossPropModel::MobModelVector rxs = CreateSyntheticMobility (size);
+  Ptr<MobilityModel> tx = CreateSyntheticMobility (1).front ();
+
+  RunBenchmark ("BM_CreateCoordzPairVector", size, [&] ()
+    {
+      const woss::CoordZPairVect &pairVector = propModel->CreateCoordzPairVector (tx, rxs);
+      g_sink = g_sink + pairVector.size ();
+    });
+}
+
+void
+BenchTxPacketTapLoop (Ptr<BenchChannel> channel, uint32_t size)
+{
+  UanPdp pdp = CreateSyntheticPdp (size);
+
+  RunBenchmark ("BM_TxPacketTapLoop", size, [&] ()
+    {
+      double rxPowerDb = 0.0;
+      Time delay;
+
+      // 120 dB attenuation threshold
+      channel->ComputeRxPowerAndDelay (pdp, 190.0, 1.0E-6, rxPowerDb, delay);
+      g_sink = g_sink + rxPowerDb;
+    });
+
+  RunBenchmark ("BM_NormalizeToSumNc", size, [&] ()
+    {
+      UanPdp normalizedPdp = pdp.NormalizeToSumNc ();
+      g_sink = g_sink + normalizedPdp.GetNTaps ();
+    });
+}
+
+void
+BenchCoordinateConversions (uint32_t size)
+{
+  std::vector<Vector> positions;
+  std::vector<woss::CoordZ> coordZs;
+
+  for (Ptr<MobilityModel> mob : CreateSyntheticMobility (size))
+    {
+      positions.push_back (mob->GetPosition ());
+      coordZs.push_back (CreateCoordZFromVector (positions.back ()));
+    }
+
+  RunBenchmark ("BM_CartesianToCoordZ", size, [&] ()
+    {
+      for (const Vector &pos : positions)
+        {
+          g_sink = g_sink + CreateCoordZFromVector (pos).getLatitude ();
+        }
+    });
+
+  RunBenchmark ("BM_CoordZToCartesian", size, [&] ()
+    {
+      for (const woss::CoordZ &coordZ : coordZs)
+        {
+          g_sink = g_sink + CreateVectorFromCoordZ (coordZ).x;
+        }
+    });
+}
+
+void
+BenchPositionAllocators (uint32_t size)
+{
+  Ptr<WossGridPositionAllocator> gridAlloc = CreateObject<WossGridPositionAllocator> ();
+  gridAlloc->SetMinLatitude (BENCH_LATITUDE);
+  gridAlloc->SetMinLongitude (BENCH_LONGITUDE);
+  gridAlloc->SetDepth (BENCH_DEPTH);
+  gridAlloc->SetDeltaLatitude (100.0);
+  gridAlloc->SetDeltaLongitude (100.0);
+  gridAlloc->SetN (std::max<uint32_t> (1, std::sqrt (size)));
+
+  RunBenchmark ("BM_WossGridPositionAllocator", size, [&] ()
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          g_sink = g_sink + gridAlloc->GetNext ().x;
+        }
+    });
+
+  RunBenchmark ("BM_WossGridPositionAllocatorN", size, [&] ()
+    {
+      g_sink = g_sink + gridAlloc->GetNextN (size).back ().x;
+    });
+
+  Ptr<WossListPositionAllocator> listAlloc = CreateObject<WossListPositionAllocator> ();
+  woss::CoordZ refCoordZ (BENCH_LATITUDE, BENCH_LONGITUDE, BENCH_DEPTH);
+
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      listAlloc->Add (woss::CoordZ (woss::Coord::getCoordFromBearing (refCoordZ, 0.0, i * 10.0), BENCH_DEPTH));
+    }
+
+  RunBenchmark ("BM_WossListPositionAllocator", size, [&] ()
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          g_sink = g_sink + listAlloc->GetNext ().x;
+        }
+    });
+
+  Ptr<WossRandomDiscPositionAllocator> discAlloc = CreateObject<WossRandomDiscPositionAllocator> ();
+  discAlloc->SetLatitude (BENCH_LATITUDE);
+  discAlloc->SetLongitude (BENCH_LONGITUDE);
+  discAlloc->SetDepth (BENCH_DEPTH);
+  discAlloc->AssignStreams (1);
+
+  RunBenchmark ("BM_WossRandomDiscPositionAllocator", size, [&] ()
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          g_sink = g_sink + discAlloc->GetNext ().x;
+        }
+    });
+}
+
+/**
+ * Creates the waypoints of an AUV moving on a zig-zag path, one leg every legTime
+ * \param auvId AUV index
+ * \param legCount number of legs
+ * \param legTime duration of each leg
+ * \returns the waypoint coordinates
+ */
+std::vector<woss::CoordZ>
+CreateAuvPath (uint32_t auvId, uint32_t legCount, Time legTime)
+{
+  woss::CoordZ startCoordZ (woss::Coord::getCoordFromBearing (woss::CoordZ (BENCH_LATITUDE, BENCH_LONGITUDE, BENCH_DEPTH),
+                                                              0.0, auvId * 50.0), BENCH_DEPTH);
+  std::vector<woss::CoordZ> retVal;
+  retVal.reserve (legCount + 1);
+  retVal.push_back (startCoordZ);
+
+  // 1.5 m/s AUV, alternating bearing and depth
+  double legLength = 1.5 * legTime.GetSeconds ();
+
+  for (uint32_t leg = 1; leg <= legCount; ++leg)
+    {
+      double bearing = (leg % 2 == 0) ? M_PI / 4.0 : 3.0 * M_PI / 4.0;
+      double depth = (leg % 2 == 0) ? BENCH_DEPTH : BENCH_DEPTH + 20.0;
+
+      retVal.push_back (woss::CoordZ (woss::Coord::getCoordFromBearing (retVal.back (), bearing, legLength), depth));
+    }
+
+  return retVal;
+}
+
+/**
+ * Interpolates positionCount positions across auvCount AUVs following waypoints.
+ * Positions are queried from scheduled events, one event per second of simulation time
+ * \param auvCount number of AUVs
+ * \param positionCount total number of interpolated positions
+ */
+void
+BenchWaypointInterpolation (uint32_t auvCount, uint64_t positionCount)
+{
+  const uint32_t steps = std::max<uint64_t> (1, positionCount / auvCount);
+  const Time stepTime = Seconds (1.0);
+  const Time legTime = Seconds (600.0);
+  const uint32_t legCount = steps / legTime.GetSeconds () + 1;
+
+  std::vector<Ptr<WossWaypointMobilityModel> > cartModels;
+  std::vector<Ptr<WossGeoWaypointMobilityModel> > geoModels;
+  cartModels.reserve (auvCount);
+  geoModels.reserve (auvCount);
+
+  for (uint32_t auv = 0; auv < auvCount; ++auv)
+    {
+      std::vector<woss::CoordZ> path = CreateAuvPath (auv, legCount, legTime);
+      Ptr<WossWaypointMobilityModel> cartModel = CreateObject<WossWaypointMobilityModel> ();
+      Ptr<WossGeoWaypointMobilityModel> geoModel = CreateObject<WossGeoWaypointMobilityModel> ();
+      Time waypointTime = Seconds (0.0);
+
+      for (const woss::CoordZ &coordZ : path)
+        {
+          cartModel->AddWaypoint (Waypoint (waypointTime, CreateVectorFromCoordZ (coordZ)));
+          geoModel->AddWaypoint (waypointTime, coordZ);
+          waypointTime += legTime;
+        }
+
+      cartModels.push_back (cartModel);
+      geoModels.push_back (geoModel);
+    }
+
+  auto runModels = [&] (const std::string &name, auto &models)
+    {
+      if (g_filter != "" && name.find (g_filter) == std::string::npos)
+        {
+          return;
+        }
+
+      // paths start at time zero, so each run must start from a fresh simulator
+      NS_ASSERT (Simulator::Now ().IsZero ());
+
+      for (uint32_t step = 1; step <= steps; ++step)
+        {
+          Simulator::Schedule (stepTime * step, [&models] ()
+            {
+              for (const auto &model : models)
+                {
+                  g_sink = g_sink + model->GetPosition ().x;
+                }
+            });
+        }
+
+      double start = WossProfiler::GetWallTime ();
+      Simulator::Run ();
+      double elapsed = WossProfiler::GetWallTime () - start;
+
+      NS_LOG_DEBUG (name << " simulated " << Simulator::Now ().GetSeconds () << "s");
+
+      // the next run starts again from time zero, on the same absolute waypoint times
+      Simulator::Destroy ();
+
+      uint64_t positions = (uint64_t) steps * models.size ();
+      std::string fullName = name + "/" + std::to_string (models.size ());
+
+      std::cout << std::left << std::setw (48) << fullName
+                << std::right << std::setw (16) << std::fixed << std::setprecision (1) << elapsed * 1.0E9 << " ns"
+                << std::setw (16) << std::setprecision (1) << elapsed * 1.0E9 / positions << " ns/item"
+                << std::setw (14) << 1 << std::endl;
+    };
+
+  // both models follow the same paths and are queried at the same simulation times
+  runModels ("BM_WossWaypointInterpolation", cartModels);
+  runModels ("BM_WossGeoWaypointInterpolation", geoModels);
+}
+
+} // namespace
+
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t maxSize = 10000;
+  uint32_t auvCount = 1000;
+  uint64_t positionCount = 10000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("MinTime", "Minimum time spent in each benchmark [s]", g_minTime);
+  cmd.AddValue ("MaxSize", "Maximum number of taps, receivers or positions", maxSize);
+  cmd.AddValue ("Filter", "Only benchmarks whose name contains this string are run", g_filter);
+  cmd.AddValue ("AuvCount", "Number of AUVs of the waypoint interpolation benchmark", auvCount);
+  cmd.AddValue ("PositionCount", "Total number of positions of the waypoint interpolation benchmark", positionCount);
+  cmd.Parse (argc, argv);
+
+  std::vector<uint32_t> sizes;
+
+  for (uint32_t size : {2, 10, 100, 1000, 10000})
+    {
+      if (size <= maxSize)
+        {
+          sizes.push_back (size);
+        }
+    }
+
+  Ptr<BenchPropModel> propModel = CreateObject<BenchPropModel> ();
+  Ptr<BenchChannel> channel = CreateObject<BenchChannel> ();
+
+  std::cout << std::left << std::setw (48) << "Benchmark" << std::right << std::setw (19) << "Time"
+            << std::setw (24) << "Time per item" << std::setw (14) << "Iterations" << std::endl;
+
+  for (uint32_t size : sizes)
+    {
+      BenchCreateUanPdp (propModel, size);
+      BenchCreateUanPdpVector (propModel, size);
+      BenchCreateCoordzPairVector (propModel, size);
+      BenchTxPacketTapLoop (channel, size);
+      BenchCoordinateConversions (size);
+      BenchPositionAllocators (size);
+    }
+
+  BenchWaypointInterpolation (auvCount, positionCount);
+
+  Simulator::Destroy ();
+
+  return 0;
+}
+
+#endif // NS3_WOSS_SUPPORT
@@ -26,6 +26,24 @@
 #include "ns3/boolean.h"
 #include "ns3/integer.h"
 #include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/mobility-model.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <sys/resource.h>
+#if defined (__linux__)
+#include <sched.h>
+#endif // defined (__linux__)
 
 
 #define WH_SPACE_SAMPLING_DEFAULT (0.0)
@@ -57,6 +75,13 @@
 #define WH_ALTIMETRY_TYPE_DEFAULT "L"
 #define WH_SIMULATION_TIMES_DEFAULT ()
 #define WH_CONCURRENT_THREADS_DEFAULT (0.0)
+#define WH_CPU_SET_DEFAULT ""
+#define WH_NUMA_NODE_DEFAULT (-1)
+#if defined (__linux__)
+#define WH_CPU_LIST_MAX_CPU (CPU_SETSIZE)
+#else
+#define WH_CPU_LIST_MAX_CPU (1024)
+#endif // defined (__linux__)
 #define WH_BELLHOP_BIN_NAME_DEFAULT "bellhop.exe"
 #define WH_BELLHOP_ARR_SYNTAX_DEFAULT (2)
 #define WH_BELLHOP_ARR_SYNTAX_MIN (0)
@@ -66,6 +91,15 @@
 #define WH_BELLHOP_SHD_SYNTAX_MAX (1)
 #define WH_BOX_DEPTH (-3000.0)
 #define WH_BOX_RANGE (-3000.0)
+#define WH_STUB_WATER_DEPTH_DEFAULT (WossStubCreator::DEFAULT_WATER_DEPTH)
+#define WH_STUB_SOUND_SPEED_DEFAULT (WossStubCreator::DEFAULT_SOUND_SPEED)
+#define WH_STUB_MAX_REFL_ORDER_DEFAULT (WossStubCreator::DEFAULT_MAX_REFL_ORDER)
+#define WH_STUB_BOTTOM_REFL_COEFF_DEFAULT (WossStubCreator::DEFAULT_BOTTOM_REFL_COEFF)
+#define WH_DB_BATHY_TILE_SIZE_DEFAULT (1.0 / 120.0)
+#define WH_DB_SSP_TILE_SIZE_DEFAULT (0.25)
+#define WH_DB_SEDIM_TILE_SIZE_DEFAULT (1.0 / 60.0)
+#define WH_DB_TRANSECT_QUANTUM_DEFAULT (0.0)
+#define WH_DB_TRANSECT_CACHE_SIZE_DEFAULT (1000000)
 #define WH_GEBCO_FORMAT_DEFAULT (3)
 #define WH_GEBCO_FORMAT_MIN (0)
 #define WH_GEBCO_FORMAT_MAX (4)
@@ -84,6 +118,282 @@ NS_LOG_COMPONENT_DEFINE ("WossHelper");
 
 ATTRIBUTE_HELPER_CPP (WossSimTime);
 
+namespace {
+
+/**
+ * \returns the wall clock time in seconds
+ */
+double
+GetWallTimeSeconds (void)
+{
+  return std::chrono::duration<double> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/**
+ * \returns the CPU time in seconds consumed so far by all the threads of the process
+ */
+double
+GetProcessCpuTimeSeconds (void)
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    {
+      return 0.0;
+    }
+
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+         + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1.0E6;
+}
+
+/**
+ * Single pass parser of the '|' separated strings of the custom environment setters.
+ * Tokens are std::string_view over the input string. Integers are converted in place with std::from_chars,
+ * floating point numbers with WossParseDouble, so no temporary string is created.
+ */
+class TokenParser
+{
+public:
+  /**
+   * \param str the string to be parsed, it must outlive the parser
+   */
+  explicit TokenParser (std::string_view str)
+    : m_str (str),
+      m_pos (0),
+      m_isExhausted (str.empty ())
+  {
+  }
+
+  /**
+   * \param token the next token, surrounding spaces removed
+   * \returns false if no token is left
+   */
+  bool NextToken (std::string_view &token)
+  {
+    if (m_isExhausted)
+      {
+        return false;
+      }
+
+    std::string_view::size_type end = m_str.find ('|', m_pos);
+
+    if (end == std::string_view::npos)
+      {
+        end = m_str.size ();
+        m_isExhausted = true;
+      }
+
+    token = m_str.substr (m_pos, end - m_pos);
+    m_pos = end + 1;
+
+    std::string_view::size_type first = token.find_first_not_of (" \t");
+    std::string_view::size_type last = token.find_last_not_of (" \t");
+    token = (first == std::string_view::npos) ? std::string_view () : token.substr (first, last - first + 1);
+
+    return true;
+  }
+
+  /**
+   * \param value the next token converted to a number
+   * \returns false if no token is left or the token is not a valid number
+   */
+  template <typename T>
+  bool NextNumber (T &value)
+  {
+    std::string_view token;
+
+    if (NextToken (token) == false || token.empty ())
+      {
+        return false;
+      }
+
+    if constexpr (std::is_floating_point<T>::value)
+      {
+        double parsed = 0.0;
+
+        if (WossParseDouble (token.data (), token.data () + token.size (), parsed) == false)
+          {
+            return false;
+          }
+
+        value = parsed;
+
+        return true;
+      }
+    else
+      {
+        // from_chars doesn't accept the leading '+' that atoi used to accept
+        if (token.front () == '+')
+          {
+            token.remove_prefix (1);
+          }
+
+        std::from_chars_result result = std::from_chars (token.data (), token.data () + token.size (), value);
+
+        return result.ec == std::errc () && result.ptr == token.data () + token.size ();
+      }
+  }
+
+  /**
+   * \returns the part of the string not yet parsed, empty if no token is left
+   */
+  std::string_view GetRemaining (void) const
+  {
+    return m_isExhausted ? std::string_view () : m_str.substr (m_pos);
+  }
+
+private:
+  std::string_view m_str; //!< the parsed string
+  std::string_view::size_type m_pos; //!< position of the next token
+  bool m_isExhausted; //!< true if no token is left
+};
+
+/**
+ * Parses a "name|p0|p1|...|pN-1" string, extra trailing tokens are ignored
+ * \param str the string
+ * \param name the parsed name
+ * \param params the N parsed parameters
+ * \returns true if successful
+ */
+template <std::size_t N>
+bool
+ParseNamedParams (const std::string &str, std::string &name, double (&params)[N])
+{
+  TokenParser parser (str);
+  std::string_view token;
+
+  if (parser.NextToken (token) == false || parser.GetRemaining ().empty ())
+    {
+      NS_LOG_ERROR ("separator | not found, string parsed:" << str);
+      return false;
+    }
+
+  for (std::size_t cnt = 0; cnt < N; ++cnt)
+    {
+      if (parser.NextNumber (params[cnt]) == false)
+        {
+          NS_LOG_ERROR ("cnt:" << cnt << "; invalid parameter, string parsed: " << str);
+          return false;
+        }
+
+      NS_LOG_DEBUG ("cnt:" << cnt << "; param:" << params[cnt]);
+    }
+
+  name.assign (token.data (), token.size ());
+
+  return true;
+}
+
+/**
+ * Parses a "total|a0|b0|...|aN-1|bN-1" string into value pairs, validated by
+ * checking that the second value of each pair is not negative.
+ * \param str the string
+ * \param what the name of the pair values, for error messages
+ * \param pairs the parsed pairs, the vector capacity is reused across calls
+ * \returns true if successful
+ */
+bool
+ParseValuePairs (const std::string &str, const char *what, std::vector<std::pair<double, double> > &pairs)
+{
+  TokenParser parser (str);
+  int total = 0;
+
+  pairs.clear ();
+
+  if (parser.NextNumber (total) == false || parser.GetRemaining ().empty ())
+    {
+      NS_LOG_ERROR ("invalid total number of " << what << ", string parsed:" << str);
+      return false;
+    }
+
+  NS_LOG_DEBUG ("total " << what << ": " << total);
+
+  if (total <= 0)
+    {
+      NS_LOG_ERROR ("total " << what << " given < 0:" << total);
+      return false;
+    }
+
+  pairs.reserve (total);
+
+  for (int cnt = 0; cnt < total; ++cnt)
+    {
+      double first = 0.0;
+      double second = 0.0;
+
+      if (parser.NextNumber (first) == false || parser.NextNumber (second) == false)
+        {
+          NS_LOG_ERROR ("cnt:" << cnt << "; invalid " << what << " value, string parsed: " << str);
+          return false;
+        }
+
+      NS_LOG_DEBUG ("cnt:" << cnt << "; first:" << first << "; second:" << second);
+
+      if (second < 0.0)
+        {
+          NS_LOG_ERROR ("cnt:" << cnt << " value:" << second << " < 0");
+          return false;
+        }
+
+      pairs.emplace_back (first, second);
+    }
+
+  return true;
+}
+
+/**
+ * Parses a CPU number, surrounding blanks are allowed
+ * \param str the CPU number
+ * \param cpu the parsed CPU number
+ * \returns true if str holds only a non negative integer lower than WH_CPU_LIST_MAX_CPU, false otherwise
+ */
+bool
+ParseCpuNumber (const std::string &str, int &cpu)
+{
+  std::string::size_type begin = str.find_first_not_of (" \t\n");
+  std::string::size_type end = str.find_last_not_of (" \t\n");
+
+  if (begin == std::string::npos || std::isdigit (static_cast<unsigned char> (str[begin])) == 0)
+    {
+      return false;
+    }
+
+  std::string number = str.substr (begin, end - begin + 1);
+  char *parseEnd = nullptr;
+
+  errno = 0;
+  long value = std::strtol (number.c_str (), &parseEnd, 10);
+
+  if (errno != 0 || parseEnd != number.c_str () + number.size () || value >= WH_CPU_LIST_MAX_CPU)
+    {
+      return false;
+    }
+
+  cpu = static_cast<int> (value);
+
+  return true;
+}
+
+#if defined (__linux__)
+/**
+ * Fills a cpu_set_t
+ * \param cpus the CPU numbers
+ * \param cpuSet the set to be filled
+ */
+void
+FillCpuSet (const std::vector<int> &cpus, cpu_set_t &cpuSet)
+{
+  CPU_ZERO (&cpuSet);
+
+  for (int cpu : cpus)
+    {
+      CPU_SET (cpu, &cpuSet);
+    }
+}
+#endif // defined (__linux__)
+
+} // unnamed namespace
+
 Vector
 CreateVectorFromCoords (double latitude, double longitude, double depth)
 {
@@ -114,9 +424,7 @@ CreateCoordZFromVector (Vector vect)
 woss::Coord
 CreateCoordFromVector (Vector vect)
 {
-  woss::CoordZ coordZtemp = woss::CoordZ::getCoordZFromCartesianCoords (vect.x, 
-                                                                        vect.y, 
-                                                                        vect.z, woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+  woss::CoordZ coordZtemp = CreateCoordZFromVector (vect);
   return (woss::Coord (coordZtemp.getLatitude (), coordZtemp.getLongitude ()));
 }
 
@@ -227,7 +535,13 @@ WossHelper::WossHelper ()
     m_bathyDbCreator (std::make_shared<woss::BathyGebcoDbCreator> ()),
 #endif // defined (WOSS_NETCDF_SUPPORT)
     m_wossDbManagerDebug (WH_DEBUG_DEFAULT),
-    m_wossDbManager (std::make_shared<woss::WossDbManager> ()),
+    m_wossDbBathyTileSize (WH_DB_BATHY_TILE_SIZE_DEFAULT),
+    m_wossDbSspTileSize (WH_DB_SSP_TILE_SIZE_DEFAULT),
+    m_wossDbSedimTileSize (WH_DB_SEDIM_TILE_SIZE_DEFAULT),
+    m_wossDbSnapshotFile (WH_STRING_DEFAULT),
+    m_wossDbTransectQuantum (WH_DB_TRANSECT_QUANTUM_DEFAULT),
+    m_wossDbTransectCacheSize (WH_DB_TRANSECT_CACHE_SIZE_DEFAULT),
+    m_wossDbManager (std::make_shared<WossTiledDbManager> ()),
     m_wossCreatorDebug (WH_DEBUG_DEFAULT),
     m_wossDebug (WH_DEBUG_DEFAULT),
     m_wossClearWorkDir (true),
@@ -263,12 +577,23 @@ WossHelper::WossHelper ()
     m_bellhopCreator (std::make_shared<woss::BellhopCreator> ()),
     m_boxDepth (WH_BOX_DEPTH),
     m_boxRange (WH_BOX_RANGE),
+    m_useStubCreator (false),
+    m_stubWaterDepth (WH_STUB_WATER_DEPTH_DEFAULT),
+    m_stubSoundSpeed (WH_STUB_SOUND_SPEED_DEFAULT),
+    m_stubMaxReflOrder (WH_STUB_MAX_REFL_ORDER_DEFAULT),
+    m_stubBottomReflCoeff (WH_STUB_BOTTOM_REFL_COEFF_DEFAULT),
+    m_stubCreator (nullptr),
     m_wossManagerDebug (WH_DEBUG_DEFAULT),
     m_isTimeEvolutionActive (false),
     m_concurrentThreads (WH_CONCURRENT_THREADS_DEFAULT),
     m_wossManagerSpaceSampling (WH_SPACE_SAMPLING_DEFAULT),
     m_wossManagerUseMultiThread (false),
     m_wossManagerUseThreadPool (true),
+    m_wossManagerCpuSet (WH_CPU_SET_DEFAULT),
+    m_wossManagerNumaNode (WH_NUMA_NODE_DEFAULT),
+    m_originalCpus (),
+    m_initWallTime (0.0),
+    m_initCpuTime (0.0),
     m_wossManagerSimple (std::make_shared< woss::WossManagerSimple<woss::WossManagerResDb> > ()),
     m_wossManagerMulti (std::make_shared< woss::WossManagerSimple<woss::WossManagerResDbMT> > ()),
     m_wossTransducerHndlDebug (WH_DEBUG_DEFAULT),
@@ -292,9 +617,189 @@ WossHelper::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_initialized == true && m_wossManagerUseMultiThread == true)
+    {
+      double wallTime = GetWallTimeSeconds () - m_initWallTime;
+      double cpuTime = GetProcessCpuTimeSeconds () - m_initCpuTime;
+      int totalThreads = m_wossManagerMulti->getConcurrentThreads ();
+
+      if (wallTime > 0.0 && totalThreads > 0)
+        {
+          // getrusage can't tell the WOSS threads apart, the main thread is accounted too
+          NS_LOG_INFO ("WOSS threads: " << totalThreads << "; wall time: " << wallTime
+                       << " [s]; process cpu time: " << cpuTime << " [s]; process cpu load over "
+                       << totalThreads << " threads (main thread included): "
+                       << (cpuTime / (wallTime * totalThreads)) * 100.0 << " %");
+        }
+    }
+
+  RestoreCpuAffinity ();
+
   m_initialized = false;
 }
 
+bool
+WossHelper::ParseCpuList (const std::string &cpuList, std::vector<int> &cpus)
+{
+  cpus.clear ();
+
+  std::string::size_type start = 0;
+
+  while (start < cpuList.size ())
+    {
+      std::string::size_type end = cpuList.find (',', start);
+      if (end == std::string::npos)
+        {
+          end = cpuList.size ();
+        }
+
+      std::string item = cpuList.substr (start, end - start);
+      start = end + 1;
+
+      if (item.find_first_not_of (" \t\n") == std::string::npos)
+        {
+          continue;
+        }
+
+      int first = 0;
+      int last = 0;
+      std::string::size_type dash = item.find ('-');
+
+      bool valid = false;
+
+      if (dash == std::string::npos)
+        {
+          valid = ParseCpuNumber (item, first);
+          last = first;
+        }
+      else
+        {
+          valid = ParseCpuNumber (item.substr (0, dash), first) && ParseCpuNumber (item.substr (dash + 1), last);
+        }
+
+      if (valid == false || last < first)
+        {
+          NS_LOG_ERROR ("invalid CPU range: " << item);
+          cpus.clear ();
+          return false;
+        }
+
+      for (int cpu = first; cpu <= last; ++cpu)
+        {
+          cpus.push_back (cpu);
+        }
+    }
+
+  std::sort (cpus.begin (), cpus.end ());
+  cpus.erase (std::unique (cpus.begin (), cpus.end ()), cpus.end ());
+
+  return true;
+}
+
+int
+WossHelper::ApplyCpuAffinity (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_wossManagerCpuSet == WH_CPU_SET_DEFAULT && m_wossManagerNumaNode == WH_NUMA_NODE_DEFAULT)
+    {
+      return 0;
+    }
+
+#if defined (__linux__)
+  std::string cpuList = m_wossManagerCpuSet;
+
+  if (m_wossManagerNumaNode != WH_NUMA_NODE_DEFAULT && m_wossManagerCpuSet != WH_CPU_SET_DEFAULT)
+    {
+      NS_LOG_WARN ("WossManagerCpuSet takes precedence, NUMA node " << m_wossManagerNumaNode << " ignored");
+    }
+  else if (m_wossManagerNumaNode != WH_NUMA_NODE_DEFAULT)
+    {
+      std::ostringstream nodePath;
+      nodePath << "/sys/devices/system/node/node" << m_wossManagerNumaNode << "/cpulist";
+
+      std::ifstream nodeFile (nodePath.str ());
+      std::string nodeCpuList;
+
+      if (!nodeFile.is_open () || !std::getline (nodeFile, nodeCpuList))
+        {
+          NS_FATAL_ERROR ("NUMA node " << m_wossManagerNumaNode << " not found, can't read " << nodePath.str ());
+        }
+
+      NS_LOG_DEBUG ("NUMA node " << m_wossManagerNumaNode << " cpulist: " << nodeCpuList);
+
+      cpuList = nodeCpuList;
+    }
+
+  std::vector<int> cpus;
+
+  if (ParseCpuList (cpuList, cpus) == false || cpus.empty ())
+    {
+      NS_FATAL_ERROR ("invalid WOSS CPU set: " << cpuList);
+    }
+
+  // the mask of the calling thread is saved, so that RestoreCpuAffinity can release it once the workers are started
+  cpu_set_t originalSet;
+  CPU_ZERO (&originalSet);
+
+  if (sched_getaffinity (0, sizeof (cpu_set_t), &originalSet) != 0)
+    {
+      NS_LOG_ERROR ("sched_getaffinity failed, CPU set: " << cpuList << " not applied");
+      return 0;
+    }
+
+  cpu_set_t cpuSet;
+  FillCpuSet (cpus, cpuSet);
+
+  if (sched_setaffinity (0, sizeof (cpu_set_t), &cpuSet) != 0)
+    {
+      NS_LOG_ERROR ("sched_setaffinity failed for CPU set: " << cpuList);
+      return 0;
+    }
+
+  m_originalCpus.clear ();
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET (cpu, &originalSet))
+        {
+          m_originalCpus.push_back (cpu);
+        }
+    }
+
+  NS_LOG_DEBUG ("WOSS CPU affinity set to: " << cpuList << "; total cpus: " << cpus.size ());
+
+  return static_cast<int> (cpus.size ());
+#else
+  NS_LOG_WARN ("CPU affinity and NUMA placement are only supported on Linux, ignoring configuration");
+
+  return 0;
+#endif // defined (__linux__)
+}
+
+void
+WossHelper::RestoreCpuAffinity (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_originalCpus.empty ())
+    {
+      return;
+    }
+
+#if defined (__linux__)
+  cpu_set_t cpuSet;
+  FillCpuSet (m_originalCpus, cpuSet);
+
+  if (sched_setaffinity (0, sizeof (cpu_set_t), &cpuSet) != 0)
+    {
+      NS_LOG_ERROR ("sched_setaffinity failed, the calling thread keeps the WOSS CPU set");
+    }
+#endif // defined (__linux__)
+
+  m_originalCpus.clear ();
+}
+
 void
 WossHelper::CheckInitialized (void) const
 {
@@ -452,14 +957,42 @@ WossHelper::Initialize (Ptr<WossPropModel> wossPropModel)
   m_bellhopCreator->setBellhopShdSyntax ((woss::BellhopShdSyntax)m_bellhopShdSyntax);
   m_bellhopCreator->setBoxDepth(m_boxDepth);
   m_bellhopCreator->setBoxRange(m_boxRange);
-  m_wossController->setWossCreator (m_bellhopCreator);
+
+  if (m_useStubCreator == true)
+    {
+      NS_LOG_DEBUG ("Setting Stub Creator");
+
+      m_stubCreator = std::make_shared<WossStubCreator> ();
+      m_stubCreator->setDebug (m_wossCreatorDebug);
+      m_stubCreator->setWossDebug (m_wossDebug);
+      m_stubCreator->SetWaterDepth (m_stubWaterDepth);
+      m_stubCreator->SetSoundSpeed (m_stubSoundSpeed);
+      m_stubCreator->SetMaxReflectionOrder (m_stubMaxReflOrder);
+      m_stubCreator->SetBottomReflCoeff (m_stubBottomReflCoeff);
+      m_wossController->setWossCreator (m_stubCreator);
+    }
+  else
+    {
+      m_wossController->setWossCreator (m_bellhopCreator);
+    }
 
   NS_LOG_DEBUG ("Setting WossDbManager");
 
   m_wossDbManager->setDebug (m_wossDbManagerDebug);
+  m_wossDbManager->SetTransectCache (m_wossDbTransectQuantum, m_wossDbTransectCacheSize);
 
   m_wossController->setWossDbManager (m_wossDbManager);
 
+  if (m_wossDbSnapshotFile != WH_STRING_DEFAULT)
+    {
+      NS_LOG_DEBUG ("Loading environment snapshot " << m_wossDbSnapshotFile);
+
+      if (m_wossDbManager->LoadSnapshot (m_wossDbSnapshotFile) == false)
+        {
+          NS_FATAL_ERROR ("Can't load environment snapshot " << m_wossDbSnapshotFile);
+        }
+    }
+
   if (m_wossManagerUseMultiThread == false)
     {
       NS_LOG_DEBUG ("Setting WossManager Single Threaded");
@@ -475,6 +1008,14 @@ WossHelper::Initialize (Ptr<WossPropModel> wossPropModel)
     {
       NS_LOG_DEBUG ("Setting WossManager Multi Threaded");
 
+      int totalCpus = ApplyCpuAffinity ();
+
+      if (m_concurrentThreads == 0 && totalCpus > 0)
+        {
+          // automatic thread count is bound to the pinned CPU set
+          m_concurrentThreads = totalCpus;
+        }
+
       m_wossManagerMulti->setDebugFlag (m_wossManagerDebug);
       m_wossManagerMulti->setTimeEvolutionActiveFlag (m_isTimeEvolutionActive);
       m_wossManagerMulti->setSpaceSampling (m_wossManagerSpaceSampling);
@@ -485,6 +1026,9 @@ WossHelper::Initialize (Ptr<WossPropModel> wossPropModel)
       wossPropModel->SetWossManager (m_wossManagerMulti);
     }
 
+  // the wideband cache of the prop model follows the time evolution of the environment
+  wossPropModel->SetTimeEvolution (m_isTimeEvolutionActive, m_evolutionTimeQuantum);
+
   NS_LOG_DEBUG ("Setting TransducerHandler");
 
   m_wossTransducerHndl->setDebug (m_wossTransducerHndlDebug);
@@ -499,10 +1043,101 @@ WossHelper::Initialize (Ptr<WossPropModel> wossPropModel)
       NS_FATAL_ERROR ("WossController is not initialized");
     }
 
+  // the pool workers have inherited the WOSS CPU set, the simulator thread gets its own mask back.
+  // Without the pool WOSS spawns its threads on every request, so the calling thread keeps the set
+  if (m_wossManagerUseMultiThread && m_wossManagerUseThreadPool)
+    {
+      RestoreCpuAffinity ();
+    }
+
+  m_initWallTime = GetWallTimeSeconds ();
+  m_initCpuTime = GetProcessCpuTimeSeconds ();
   m_initialized = true;
 }
 
 
+std::shared_ptr<WossStubCreator>
+WossHelper::GetWossStubCreator (void) const
+{
+  return m_stubCreator;
+}
+
+
+void
+WossHelper::PreloadEnvironment (const woss::Coord &minCoord, const woss::Coord &maxCoord)
+{
+  NS_LOG_FUNCTION (this << minCoord << maxCoord);
+
+  CheckInitialized ();
+
+  m_wossDbManager->SetBathymetryTileSize (m_wossDbBathyTileSize);
+  m_wossDbManager->SetSspTileSize (m_wossDbSspTileSize);
+  m_wossDbManager->SetSedimentTileSize (m_wossDbSedimTileSize);
+
+  double startTime = GetWallTimeSeconds ();
+
+  m_wossDbManager->Preload (minCoord, maxCoord, m_simTime.start_time, m_sspDepthPrecision);
+
+  NS_LOG_INFO ("environment preloaded in " << GetWallTimeSeconds () - startTime << " s");
+}
+
+
+void
+WossHelper::PreloadEnvironment (const NodeContainer &nodes, double margin)
+{
+  NS_LOG_FUNCTION (this << nodes.GetN () << margin);
+
+  NS_ASSERT (nodes.GetN () > 0);
+
+  double minLat = 90.0, maxLat = -90.0, minLon = 180.0, maxLon = -180.0;
+
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+
+      NS_ASSERT (mobility != nullptr);
+
+      woss::CoordZ coordz = CreateCoordZFromVector (mobility->GetPosition ());
+
+      minLat = std::min (minLat, coordz.getLatitude ());
+      maxLat = std::max (maxLat, coordz.getLatitude ());
+      minLon = std::min (minLon, coordz.getLongitude ());
+      maxLon = std::max (maxLon, coordz.getLongitude ());
+    }
+
+  woss::Coord minCoord (minLat, minLon);
+  woss::Coord maxCoord (maxLat, maxLon);
+
+  if (margin > 0.0)
+    {
+      // south west and north east corners are moved outwards along the diagonal
+      double diagonal = margin * std::sqrt (2.0);
+      minCoord = woss::Coord::getCoordFromBearing (minCoord, 5.0 * M_PI / 4.0, diagonal);
+      maxCoord = woss::Coord::getCoordFromBearing (maxCoord, M_PI / 4.0, diagonal);
+    }
+
+  PreloadEnvironment (minCoord, maxCoord);
+}
+
+
+bool
+WossHelper::SaveEnvironmentSnapshot (const std::string &fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  CheckInitialized ();
+
+  return m_wossDbManager->SaveSnapshot (fileName);
+}
+
+
+std::shared_ptr<WossTiledDbManager>
+WossHelper::GetWossDbManager (void) const
+{
+  return m_wossDbManager;
+}
+
+
 std::shared_ptr<WossLocation>
 WossHelper::GetWossLocation ( Ptr< MobilityModel > ptr )
 {
@@ -530,23 +1165,17 @@ WossHelper::SetAngles (const std::string &angleString, Ptr<MobilityModel> tx, Pt
 {
   CheckInitialized ();
 
-  std::string angleTmp = angleString;
-  std::string::size_type tmp;
+  TokenParser parser (angleString);
   double param[2];
 
   for (int cnt = 0; cnt < 2; ++cnt)
     {
-      tmp = angleTmp.find ("|");
-      if ((tmp == std::string::npos) && (cnt != 2 - 1))
+      if (parser.NextNumber (param[cnt]) == false)
         {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed: " << angleTmp);
+          NS_LOG_ERROR ("cnt:" << cnt << "; invalid angle, string parsed: " << angleString);
           return false;
         }
 
-      std::string paramStr = angleTmp.substr (0, tmp);
-      angleTmp = angleTmp.substr (tmp + 1, angleTmp.npos);
-      param[cnt] = std::atof (paramStr.c_str ());
-
       NS_LOG_DEBUG ("cnt:" << cnt << "; param:" << param[cnt]);
     }
 
@@ -679,40 +1308,14 @@ WossHelper::SetCustomTransducer ( const std::string &transducerString, Ptr<Mobil
   CheckInitialized ();
 
   std::string transducerType;
-  std::string transTmp = transducerString;
-  std::string::size_type tmp;
   double param[5];
 
-  tmp = transTmp.find ("|");
-  if (tmp == std::string::npos)
+  if (ParseNamedParams (transducerString, transducerType, param) == false)
     {
-      NS_LOG_ERROR ("separator | not found, string parsed:" << transTmp);
       return false;
     }
 
-  transducerType = transTmp.substr (0, tmp);
-  transTmp = transTmp.substr (tmp + 1, transTmp.npos);
-
-  NS_LOG_ERROR ("transducerType: " << transducerType);
-
-  for (int cnt = 0; cnt < 5; ++cnt)
-    {
-//    double range;
-//    double depth;
-
-      tmp = transTmp.find ("|");
-      if ((tmp == std::string::npos) && (cnt != 5 - 1))
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed: " << transTmp);
-          return false;
-        }
-
-      std::string paramStr = transTmp.substr (0, tmp);
-      transTmp = transTmp.substr (tmp + 1, transTmp.npos);
-      param[cnt] = std::atof (paramStr.c_str ());
-
-      NS_LOG_DEBUG ("cnt:" << cnt << "; param:" << param[cnt]);
-    }
+  NS_LOG_DEBUG ("transducerType: " << transducerType);
 
   woss::CustomTransducer customTrasducer = woss::CustomTransducer (transducerType, param[0], param[1], param[2], param[3], param[4]);
 
@@ -830,7 +1433,11 @@ WossHelper::SetCustomAltimetry (const woss::Altimetry& altimetry, const woss::Co
 {
   CheckInitialized ();
 
-  return m_wossDbManager->setCustomAltimetry (altimetry, txCoord, bearing, range);
+  bool isSet = m_wossDbManager->setCustomAltimetry (altimetry, txCoord, bearing, range);
+
+  m_wossDbManager->ClearTransectCache ();
+
+  return isSet;
 }
 
 
@@ -849,6 +1456,7 @@ WossHelper::EraseCustomAltimetry (const woss::Coord& txCoord, double bearing, do
   CheckInitialized ();
 
   m_wossDbManager->eraseCustomAltimetry (txCoord, bearing, range);
+  m_wossDbManager->ClearTransectCache ();
 }
 
 
@@ -858,7 +1466,11 @@ WossHelper::SetCustomSediment (const woss::Sediment& sediment, const woss::Coord
 {
   CheckInitialized ();
 
-  return m_wossDbManager->setCustomSediment (sediment, txCoord, bearing, range);
+  bool isSet = m_wossDbManager->setCustomSediment (sediment, txCoord, bearing, range);
+
+  m_wossDbManager->ClearTransectCache ();
+
+  return isSet;
 }
 
 
@@ -870,41 +1482,22 @@ WossHelper::SetCustomSediment (const std::string &sedimentString, const woss::Co
   CheckInitialized ();
 
   std::string sedimentType;
-  std::string sedimTmp = sedimentString;
-  std::string::size_type tmp;
   double param[5];
 
-  tmp = sedimTmp.find ("|");
-  if (tmp == std::string::npos)
+  if (ParseNamedParams (sedimentString, sedimentType, param) == false)
     {
-      NS_LOG_ERROR ("separator | not found, string parsed:" << sedimTmp);
       return false;
     }
 
-  sedimentType = sedimTmp.substr (0, tmp);
-  sedimTmp = sedimTmp.substr (tmp + 1, sedimTmp.npos);
-
   NS_LOG_DEBUG ("sedimentType: " << sedimentType);
 
-  for (int cnt = 0; cnt < 5; ++cnt)
-    {
-      tmp = sedimTmp.find ("|");
-      if ((tmp == std::string::npos) && (cnt != 5 - 1))
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed: " << sedimTmp);
-          return false;
-        }
-
-      std::string paramStr = sedimTmp.substr (0, tmp);
-      sedimTmp = sedimTmp.substr (tmp + 1, sedimTmp.npos);
-      param[cnt] = std::atof (paramStr.c_str ());
+  woss::Sediment sediment = woss::Sediment ( sedimentType, param[0], param[1], param[2], param[3], param[4]);
 
-      NS_LOG_DEBUG ("cnt:" << cnt << "; param:" << param[cnt]);
-    }
+  bool isSet = m_wossDbManager->setCustomSediment (sediment, txCoord, bearing, range);
 
-  woss::Sediment sediment = woss::Sediment ( sedimentType, param[0], param[1], param[2], param[3], param[4]);
+  m_wossDbManager->ClearTransectCache ();
 
-  return m_wossDbManager->setCustomSediment (sediment, txCoord, bearing, range);
+  return isSet;
 }
 
 
@@ -923,6 +1516,7 @@ WossHelper::EraseCustomSediment (const woss::Coord& txCoord, double bearing, dou
   CheckInitialized ();
 
   m_wossDbManager->eraseCustomSediment (txCoord, bearing, range);
+  m_wossDbManager->ClearTransectCache ();
 }
 
 
@@ -932,7 +1526,11 @@ WossHelper::SetCustomSsp (const woss::SSP& ssp, const woss::Coord& txCoord, doub
 {
   CheckInitialized ();
 
-  return m_wossDbManager->setCustomSSP ( ssp, txCoord, bearing, range, timeValue);
+  bool isSet = m_wossDbManager->setCustomSSP ( ssp, txCoord, bearing, range, timeValue);
+
+  m_wossDbManager->ClearTransectCache ();
+
+  return isSet;
 }
 
 
@@ -944,81 +1542,65 @@ WossHelper::SetCustomSsp (const std::string &sspString, const woss::Coord& txCoo
 
   CheckInitialized ();
 
-  woss::SSP ssp;
-  std::string sspTmp = sspString;
-  std::string::size_type tmp;
-
-  int totalDepths = 0;
+  // the whole string is validated before building the SSP
+  static thread_local std::vector<std::pair<double, double> > depthValues;
 
-  tmp = sspTmp.find ("|");
-  if (tmp == std::string::npos)
+  if (ParseValuePairs (sspString, "depths", depthValues) == false)
     {
-      NS_LOG_ERROR ("WossHelper::SetCustomSsp() separator | not found, string parsed:" << sspTmp);
       return false;
     }
 
-  std::string totDepths = sspTmp.substr (0, tmp);
-  sspTmp = sspTmp.substr (tmp + 1, sspTmp.npos);
-  totalDepths = std::atoi (totDepths.c_str ());
-
-  NS_LOG_DEBUG ("totalDepths: " << totalDepths);
+  woss::SSP ssp;
 
-  if (totalDepths <= 0)
+  for (const auto &depthValue : depthValues)
     {
-      NS_LOG_ERROR ("totalDepths given < 0:" << totalDepths);
-      return false;
+      ssp.insertValue (depthValue.first, depthValue.second);
     }
 
-  for (int cnt = 0; cnt < totalDepths; ++cnt)
-    {
-      double depth;
-      double sspValue;
+  bool isSet = m_wossDbManager->setCustomSSP (ssp, txCoord, bearing, range, timeValue);
 
-      tmp = sspTmp.find ("|");
-      if (tmp == std::string::npos)
-        {
-          NS_LOG_ERROR ("WossHelper::SetCustomSsp() cnt:" << cnt << "; separator | not found, string parsed:" << sspTmp);
-          return false;
-        }
+  m_wossDbManager->ClearTransectCache ();
 
-      std::string depthStr = sspTmp.substr (0, tmp);
-      sspTmp = sspTmp.substr (tmp + 1, sspTmp.npos);
-      depth = std::atof (depthStr.c_str ());
+  return isSet;
+}
 
-      tmp = sspTmp.find ("|");
-      if ((tmp == std::string::npos) && (cnt != totalDepths - 1))
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed: " << sspTmp);
-          return false;
-        }
 
-      std::string sspValueStr = sspTmp.substr (0, tmp);
-      sspTmp = sspTmp.substr (tmp + 1, sspTmp.npos);
-      sspValue = std::atof (sspValueStr.c_str ());
+bool
+WossHelper::ImportCustomSsp (const std::string &sspFileName, const woss::Coord& txCoord, double bearing, const woss::Time& timeValue)
+{
+  CheckInitialized ();
 
-      NS_LOG_DEBUG ("cnt:" << cnt << "; depth:" << depth << "; sspValue:" << sspValue);
+  bool isSet = m_wossDbManager->importCustomSSP (sspFileName, timeValue, txCoord, bearing);
 
-      if (sspValue < 0.0)
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << " sspValue:" << depth << " < 0");
-          return false;
-        }
-      else
-        {
-          ssp.insertValue (depth, sspValue);
-        }
-    }
+  m_wossDbManager->ClearTransectCache ();
 
-  return m_wossDbManager->setCustomSSP (ssp, txCoord, bearing, range, timeValue);
+  return isSet;
 }
 
 
 bool
-WossHelper::ImportCustomSsp (const std::string &sspFileName, const woss::Coord& txCoord, double bearing, const woss::Time& timeValue)
+WossHelper::ImportCustomSspGrid (const std::string &fileName)
 {
+  NS_LOG_FUNCTION (this << fileName);
+
   CheckInitialized ();
 
-  return m_wossDbManager->importCustomSSP (sspFileName, timeValue, txCoord, bearing);
+  std::shared_ptr<WossGridField> field = std::make_shared<WossGridField> ();
+
+  if (field->Import (fileName) == false)
+    {
+      return false;
+    }
+
+  if (field->IsProfile () == false)
+    {
+      NS_LOG_ERROR (fileName << " is not a 3-D field");
+      return false;
+    }
+
+  m_wossDbManager->SetSspField (field);
+
+  return true;
 }
 
 
@@ -1039,6 +1621,7 @@ WossHelper::EraseCustomSsp (const woss::Coord& txCoord, double bearing,
   CheckInitialized ();
 
   m_wossDbManager->eraseCustomSSP (txCoord, bearing, range, timeValue);
+  m_wossDbManager->ClearTransectCache ();
 }
 
 
@@ -1048,7 +1631,11 @@ WossHelper::SetCustomBathymetry (const woss::Bathymetry& bathymetry, const woss:
 {
   CheckInitialized ();
 
-  return m_wossDbManager->setCustomBathymetry (bathymetry, txCoord, bearing, range);
+  bool isSet = m_wossDbManager->setCustomBathymetry (bathymetry, txCoord, bearing, range);
+
+  m_wossDbManager->ClearTransectCache ();
+
+  return isSet;
 }
 
 
@@ -1059,82 +1646,63 @@ WossHelper::SetCustomBathymetry (const std::string &bathyLine, const woss::Coord
 
   CheckInitialized ();
 
-  std::string bathyTmp = bathyLine;
-  std::string::size_type tmp;
-
-  int totalRanges = 0;
-
   NS_LOG_DEBUG ("txCoord: " << txCoord << "; bearing: " << bearing);
 
-  tmp = bathyTmp.find ("|");
-  if (tmp == std::string::npos)
-    {
-      NS_LOG_ERROR ("separator | not found, string parsed:" << bathyTmp);
-      return false;
-    }
-
-  std::string totRanges = bathyTmp.substr (0, tmp);
-  bathyTmp = bathyTmp.substr (tmp + 1, bathyTmp.npos);
-  totalRanges = std::atoi (totRanges.c_str ());
-
-  NS_LOG_DEBUG ("totalRanges: " << totalRanges);
+  // the whole string is validated before any insertion, so a malformed line leaves no partial transect
+  static thread_local std::vector<std::pair<double, double> > rangeDepths;
 
-  if (totalRanges <= 0)
+  if (ParseValuePairs (bathyLine, "ranges", rangeDepths) == false)
     {
-      NS_LOG_ERROR ("totalRanges given < 0:" << totalRanges);
       return false;
     }
 
-  for (int cnt = 0; cnt < totalRanges; ++cnt)
+  for (const auto &rangeDepth : rangeDepths)
     {
-      double range;
-      double depth;
+      m_wossDbManager->setCustomBathymetry (rangeDepth.second, txCoord, bearing, rangeDepth.first);
+    }
 
-      tmp = bathyTmp.find ("|");
-      if (tmp == std::string::npos)
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed:" << bathyTmp);
-          return false;
-        }
+  m_wossDbManager->ClearTransectCache ();
 
-      std::string rangeStr = bathyTmp.substr (0, tmp);
-      bathyTmp = bathyTmp.substr (tmp + 1, bathyTmp.npos);
-      range = std::atof (rangeStr.c_str ());
+  return true;
+}
 
-      tmp = bathyTmp.find ("|");
-      if ((tmp == std::string::npos) && (cnt != totalRanges - 1))
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << "; separator | not found, string parsed: " << bathyTmp);
-          return false;
-        }
 
-      std::string depthStr = bathyTmp.substr (0, tmp);
-      bathyTmp = bathyTmp.substr (tmp + 1, bathyTmp.npos);
-      depth = std::atof (depthStr.c_str ());
+bool
+WossHelper::ImportCustomBathymetry (const std::string &bathyFile, const woss::Coord& txCoord, double bearing)
+{
+  CheckInitialized ();
 
-      NS_LOG_DEBUG ("cnt:" << cnt << "; range:" << range << "; depth:" << depth);
+  bool isSet = m_wossDbManager->importCustomBathymetry (bathyFile, txCoord, bearing);
 
-      if (depth < 0.0)
-        {
-          NS_LOG_ERROR ("cnt:" << cnt << " depth:" << depth << " < 0");
-          return false;
-        }
-      else
-        {
-          m_wossDbManager->setCustomBathymetry (depth, txCoord, bearing, range);
-        }
-    }
+  m_wossDbManager->ClearTransectCache ();
 
-  return true;
+  return isSet;
 }
 
 
 bool
-WossHelper::ImportCustomBathymetry (const std::string &bathyFile, const woss::Coord& txCoord, double bearing)
+WossHelper::ImportCustomBathymetryGrid (const std::string &fileName)
 {
+  NS_LOG_FUNCTION (this << fileName);
+
   CheckInitialized ();
 
-  return m_wossDbManager->importCustomBathymetry (bathyFile, txCoord, bearing);
+  std::shared_ptr<WossGridField> field = std::make_shared<WossGridField> ();
+
+  if (field->Import (fileName) == false)
+    {
+      return false;
+    }
+
+  if (field->IsProfile () == true)
+    {
+      NS_LOG_ERROR (fileName << " is not a 2-D field");
+      return false;
+    }
+
+  m_wossDbManager->SetBathymetryField (field);
+
+  return true;
 }
 
 
@@ -1153,6 +1721,17 @@ WossHelper::EraseCustomBathymetry (const woss::Coord& txCoord, double bearing, d
   CheckInitialized ();
 
   m_wossDbManager->eraseCustomBathymetry (txCoord, bearing, range);
+  m_wossDbManager->ClearTransectCache ();
+}
+
+
+double
+WossHelper::GetBathymetry (const woss::Coord& coord) const
+{
+  CheckInitialized ();
+
+  // a zero length geometry gives the bathymetry right below the given coordinates
+  return m_wossDbManager->getBathymetry (coord, coord);
 }
 
 
@@ -1313,6 +1892,38 @@ WossHelper::GetTypeId ()
                    BooleanValue (WH_DEBUG_DEFAULT),
                    MakeBooleanAccessor (&WossHelper::m_wossDbManagerDebug),
                    MakeBooleanChecker () )
+    .AddAttribute ("WossDbBathymetryTileSize",
+                   "The bathymetry tile size of PreloadEnvironment, in decimal degrees",
+                   DoubleValue (WH_DB_BATHY_TILE_SIZE_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_wossDbBathyTileSize),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossDbSspTileSize",
+                   "The SSP tile size of PreloadEnvironment, in decimal degrees",
+                   DoubleValue (WH_DB_SSP_TILE_SIZE_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_wossDbSspTileSize),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossDbSedimentTileSize",
+                   "The sediment tile size of PreloadEnvironment, in decimal degrees",
+                   DoubleValue (WH_DB_SEDIM_TILE_SIZE_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_wossDbSedimTileSize),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossDbSnapshotFile",
+                   "Environment snapshot (see SaveEnvironmentSnapshot) loaded at initialization. "
+                   "The database paths can be left empty when a snapshot is used",
+                   StringValue (WH_STRING_DEFAULT),
+                   MakeStringAccessor (&WossHelper::m_wossDbSnapshotFile),
+                   MakeStringChecker () )
+    .AddAttribute ("WossDbTransectQuantum",
+                   "Quantization step of the transect cache shared by the WossManager threads, in decimal degrees. "
+                   "It should be finer than the range step of the transects, 0 disables the cache",
+                   DoubleValue (WH_DB_TRANSECT_QUANTUM_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_wossDbTransectQuantum),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossDbTransectCacheSize",
+                   "Maximum number of cached transect samples of each data type, the cache is flushed when exceeded",
+                   UintegerValue (WH_DB_TRANSECT_CACHE_SIZE_DEFAULT),
+                   MakeUintegerAccessor (&WossHelper::m_wossDbTransectCacheSize),
+                   MakeUintegerChecker<uint32_t> (1) )
     .AddAttribute ("WossCreatorDebug",
                    "A boolean that enables or disables the debug screen output of WossCreator",
                    BooleanValue (WH_DEBUG_DEFAULT),
@@ -1503,6 +2114,20 @@ WossHelper::GetTypeId ()
                    BooleanValue (true),
                    MakeBooleanAccessor (&WossHelper::m_wossManagerUseThreadPool),
                    MakeBooleanChecker () )
+    .AddAttribute ("WossManagerCpuSet",
+                   "CPU list (e.g. \"0-7,16-23\") all the WOSS worker threads will be pinned to. With the thread pool, \
+                   the simulator thread gets its mask back once the pool is started, otherwise it keeps the CPU set. \
+                   Empty to disable the feature. If WossManagerTotalThreads is 0, the CPU set size is used as total threads. Linux only",
+                   StringValue (WH_CPU_SET_DEFAULT),
+                   MakeStringAccessor (&WossHelper::m_wossManagerCpuSet),
+                   MakeStringChecker () )
+    .AddAttribute ("WossManagerNumaNode",
+                   "NUMA node whose CPUs all the WOSS worker threads will be pinned to, as WossManagerCpuSet. Memory is \
+                   node-local only through the first touch policy, no memory policy is set. If WossManagerCpuSet is also \
+                   given, the CPU set takes precedence. -1 to disable the feature. Linux only",
+                   IntegerValue (WH_NUMA_NODE_DEFAULT),
+                   MakeIntegerAccessor (&WossHelper::m_wossManagerNumaNode),
+                   MakeIntegerChecker<int> () )
     .AddAttribute ("WossTransHandlerDebug",
                    "A boolean that enables or disables the TransducerHandler's debug screen output",
                    BooleanValue (WH_DEBUG_DEFAULT),
@@ -1523,6 +2148,32 @@ WossHelper::GetTypeId ()
                    DoubleValue (WH_BOX_RANGE),
                    MakeDoubleAccessor (&WossHelper::m_boxRange),
                    MakeDoubleChecker<double> () )
+    .AddAttribute ("WossUseStubCreator",
+                   "A boolean that replaces Bellhop with an in-process stub channel simulator, which computes "
+                   "deterministic image method multipath in an iso-velocity waveguide. Meant for Bellhop-free performance testing",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WossHelper::m_useStubCreator),
+                   MakeBooleanChecker () )
+    .AddAttribute ("WossStubWaterDepth",
+                   "The stub channel simulator waveguide depth in meters",
+                   DoubleValue (WH_STUB_WATER_DEPTH_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_stubWaterDepth),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossStubSoundSpeed",
+                   "The stub channel simulator sound speed in m/s",
+                   DoubleValue (WH_STUB_SOUND_SPEED_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_stubSoundSpeed),
+                   MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WossStubMaxReflectionOrder",
+                   "The stub channel simulator maximum number of bottom reflections of a path",
+                   UintegerValue (WH_STUB_MAX_REFL_ORDER_DEFAULT),
+                   MakeUintegerAccessor (&WossHelper::m_stubMaxReflOrder),
+                   MakeUintegerChecker<uint32_t> () )
+    .AddAttribute ("WossStubBottomReflCoeff",
+                   "The stub channel simulator bottom reflection coefficient, range [0,1]",
+                   DoubleValue (WH_STUB_BOTTOM_REFL_COEFF_DEFAULT),
+                   MakeDoubleAccessor (&WossHelper::m_stubBottomReflCoeff),
+                   MakeDoubleChecker<double> (0.0, 1.0) )
   ;
 
   return tid;
@@ -27,6 +27,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 #include <ssp-definitions.h>
 #include <sediment-definitions.h>
 #include <altimetry-definitions.h>
@@ -51,6 +52,9 @@
 #include <ns3/woss-location.h>
 #include <ns3/woss-time-reference.h>
 #include <ns3/woss-prop-model.h>
+#include <ns3/woss-stub-creator.h>
+#include <ns3/woss-tiled-db-manager.h>
+#include <ns3/node-container.h>
 
 
 #define WOSS_HELPER_ALL_COORDS(class ) woss::WossDbManager::CC ## class::DB_CDATA_ALL_OUTER_KEYS //!< WOSS custom container special db key valid for all geographic coordinates.
@@ -122,6 +126,44 @@ public:
    */
   void Initialize (Ptr<WossPropModel> wossPropModel);
 
+  /**
+   * \returns the WossStubCreator used instead of Bellhop if the "WossUseStubCreator" attribute is true,
+   * nullptr otherwise
+   */
+  std::shared_ptr<WossStubCreator> GetWossStubCreator (void) const;
+
+  /**
+   * Preloads bathymetry, SSP and sediment of the given bounding box into the in-memory tiles of the
+   * WossTiledDbManager, at the "WossDbBathymetryTileSize", "WossDbSspTileSize" and "WossDbSedimentTileSize" resolutions.
+   * Afterwards the lookups inside the box don't access the databases anymore.
+   * The helper must be initialized.
+   * \param minCoord south west corner of the bounding box
+   * \param maxCoord north east corner of the bounding box
+   */
+  void PreloadEnvironment (const woss::Coord &minCoord, const woss::Coord &maxCoord);
+
+  /**
+   * Preloads the environment of the bounding box of the current node positions, enlarged by margin.
+   * Bounding boxes crossing the antimeridian are not supported.
+   * \param nodes the nodes, with a MobilityModel aggregated
+   * \param margin bounding box margin [m]
+   */
+  void PreloadEnvironment (const NodeContainer &nodes, double margin = 0.0);
+
+  /**
+   * Saves the preloaded environment into a snapshot file, which can be loaded later through the
+   * "WossDbSnapshotFile" attribute instead of opening the databases. Custom data and gridded fields
+   * are not saved.
+   * \param fileName the snapshot file name
+   * \returns true on success
+   */
+  bool SaveEnvironmentSnapshot (const std::string &fileName) const;
+
+  /**
+   * \returns the WossTiledDbManager of the helper
+   */
+  std::shared_ptr<WossTiledDbManager> GetWossDbManager (void) const;
+
 
   /**
    * Bounds a woss::CustomAngles object to a node pair (transmitter - receiver). A woss::CustomAngles defines the minimum
@@ -342,6 +384,15 @@ public:
                          double bearing = WOSS_HELPER_ALL_BEARINGS (SSP),
                          const woss::Time& time_value = WOSS_HELPER_ALL_TIMES (SSP) );
 
+  /**
+   * Imports a gridded 3-D SSP field (CSV grid or binary raster, see WossGridField) covering a whole area,
+   * valid at any simulation time. The field is bilinearly interpolated along any transect and takes
+   * precedence over the SSP database, while the custom SSP bound to a geometry takes precedence over the field.
+   * \param fileName the 3-D field file, values are sound speeds [m/s]
+   * \returns true if successful, false otherwise
+   */
+  bool ImportCustomSspGrid (const std::string &fileName);
+
   /**
    * Returns a pointer to the woss::SSP associated to the given input geometry.
    * \param txCoord the geometry originating geographical coordinates
@@ -404,6 +455,15 @@ public:
   bool ImportCustomBathymetry ( const std::string &bathyFile, const woss::Coord& txCoord = WOSS_HELPER_ALL_COORDS (Bathymetry),
                                 double bearing = WOSS_HELPER_ALL_BEARINGS (Bathymetry) );
 
+  /**
+   * Imports a gridded bathymetry field (CSV grid or binary raster, see WossGridField) covering a whole area.
+   * The field is bilinearly interpolated along any transect and takes precedence over the bathymetry database,
+   * while the custom bathymetry bound to a geometry takes precedence over the field.
+   * \param fileName the 2-D field file
+   * \returns true if successful, false otherwise
+   */
+  bool ImportCustomBathymetryGrid (const std::string &fileName);
+
   /**
    * Returns a pointer to the woss::Bathymetry associated to the given input geometry.
    * \param txCoord the geometry originating geographical coordinates
@@ -425,6 +485,23 @@ public:
                                double bearing = WOSS_HELPER_ALL_BEARINGS (Bathymetry),
                                double range = WOSS_HELPER_ALL_RANGES (Bathymetry) );
 
+  /**
+   * Returns the seafloor depth at the given coordinates, from the custom bathymetry or the
+   * bathymetry database, as seen by the channel simulator.
+   * It can be bound to WossBathymetryPositionAllocator::SetBathymetryCallback
+   * \param coord the geographical coordinates
+   * \returns the seafloor depth in meters, non positive or non finite if not available
+   */
+  double GetBathymetry (const woss::Coord& coord) const;
+
+  /**
+   * Parses a CPU list in the kernel cpulist syntax, e.g. "0-7,16-23,31"; blank items are skipped
+   * \param cpuList the CPU list
+   * \param cpus the sorted CPU numbers, without duplicates, empty on failure
+   * \returns true if successful, false if any item is malformed or a range is reversed
+   */
+  static bool ParseCpuList (const std::string &cpuList, std::vector<int> &cpus);
+
 
 protected:
   virtual void DoDispose (void); //!< action to be performed during de-initialization
@@ -455,6 +532,20 @@ private:
    */
   bool CreateDirectory (const std::string& path);
 
+  /**
+   * Restricts the CPU affinity of the calling thread to the configured CPU set and/or NUMA node, so that
+   * all the WOSS worker threads spawned afterwards inherit the same placement. The previous mask is saved
+   * for RestoreCpuAffinity. Linux only, on other platforms the configuration is ignored.
+   *
+   * \returns the number of CPUs in the applied set, 0 if no placement has been applied
+   */
+  int ApplyCpuAffinity (void);
+
+  /**
+   * Restores the CPU affinity of the calling thread saved by ApplyCpuAffinity, if any
+   */
+  void RestoreCpuAffinity (void);
+
   MobLocMap m_locMap; //!< map of all simulated nodes
 
   std::unique_ptr<woss::SSP> m_sspProto; //!< woss::SSP prototype which will be plugged into the WOSS framework.
@@ -510,7 +601,14 @@ private:
 
   bool m_wossDbManagerDebug; //!< enable/disable the debug prints of the woss DB manager object.
 
-  std::shared_ptr<woss::WossDbManager> m_wossDbManager; //!< the helper will automatically allocate the woss DB manager
+  double m_wossDbBathyTileSize; //!< WossTiledDbManager bathymetry tile size [dec degrees]
+  double m_wossDbSspTileSize; //!< WossTiledDbManager SSP tile size [dec degrees]
+  double m_wossDbSedimTileSize; //!< WossTiledDbManager sediment tile size [dec degrees]
+  std::string m_wossDbSnapshotFile; //!< environment snapshot loaded at initialization (empty = none)
+  double m_wossDbTransectQuantum; //!< WossTiledDbManager transect cache quantization step [dec degrees], 0 = disabled
+  uint32_t m_wossDbTransectCacheSize; //!< WossTiledDbManager maximum number of cached samples of each data type
+
+  std::shared_ptr<WossTiledDbManager> m_wossDbManager; //!< the helper will automatically allocate the woss DB manager
 
   bool m_wossCreatorDebug; //!< enable/disable the debug prints of the woss creator.
   bool m_wossDebug; //!< enable/disable the debug prints of all woss objects
@@ -547,6 +645,12 @@ private:
   std::shared_ptr<woss::BellhopCreator> m_bellhopCreator; //!< the helper will automatically allocate the woss creator
   double m_boxDepth; //!< woss object configuration: maximum depth to trace rays to; deeper rays will be ignored
   double m_boxRange; //!< woss object configuration: maximum range to trace rats to; longer rays will be ignored
+  bool m_useStubCreator; //!< if true, the Bellhop creator is replaced by the in-process WossStubCreator
+  double m_stubWaterDepth; //!< WossStubCreator configuration: waveguide depth [m]
+  double m_stubSoundSpeed; //!< WossStubCreator configuration: sound speed [m/s]
+  uint32_t m_stubMaxReflOrder; //!< WossStubCreator configuration: maximum number of bottom reflections
+  double m_stubBottomReflCoeff; //!< WossStubCreator configuration: bottom reflection coefficient
+  std::shared_ptr<WossStubCreator> m_stubCreator; //!< the helper will automatically allocate the stub creator if needed
 
   bool m_wossManagerDebug; //!< enable/disable the debug prints of the woss manager.
   bool m_isTimeEvolutionActive; //!< enable/disable the time evolution feature.
@@ -554,6 +658,11 @@ private:
   double m_wossManagerSpaceSampling; //!< woss manager space sampling in meters
   bool m_wossManagerUseMultiThread; //!< enable/disable the multithread feature
   bool m_wossManagerUseThreadPool; //!< enable/disable multithread's thread pool feature
+  std::string m_wossManagerCpuSet; //!< CPU list the WOSS worker threads are pinned to, e.g. "0-7,16-23" (empty = no pinning)
+  int m_wossManagerNumaNode; //!< NUMA node the WOSS worker threads are pinned to (-1 = no pinning)
+  std::vector<int> m_originalCpus; //!< CPU affinity of the calling thread before ApplyCpuAffinity (empty = not changed)
+  double m_initWallTime; //!< wall clock time in seconds at the end of the initialization, used for utilization reports
+  double m_initCpuTime; //!< process CPU time in seconds at the end of the initialization, used for utilization reports
   std::shared_ptr<woss::WossManagerSimple<woss::WossManagerResDb> > m_wossManagerSimple; //!<  the helper will automatically allocate the desired woss manager based on current configuration.
   std::shared_ptr<woss::WossManagerSimple<woss::WossManagerResDbMT> > m_wossManagerMulti; //!<  the helper will automatically allocate the desired woss manaeger based on current configuration.
 
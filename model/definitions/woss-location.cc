@@ -28,7 +28,11 @@ namespace ns3 {
 
 
 WossLocation::WossLocation (Ptr<MobilityModel> m)
-  : m_mobModel (m)
+  : m_mobModel (m),
+    m_geoMobModel (DynamicCast<WossGeoWaypointMobilityModel> (m)),
+    m_isCacheValid (false),
+    m_cachedPosition (),
+    m_cachedCoordZ ()
 {
 
 }
@@ -39,12 +43,24 @@ WossLocation::getLocation ()
 {
   NS_ASSERT (m_mobModel != nullptr);
 
+  if (m_geoMobModel != nullptr)
+    {
+      return m_geoMobModel->GetCoordZ ();
+    }
+
   Vector vector = m_mobModel->GetPosition ();
 
-  return (woss::CoordZ::getCoordZFromCartesianCoords (vector.x, 
-                                                      vector.y, 
-                                                      vector.z, 
-                                                      woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84));
+  if (m_isCacheValid == false || !(vector == m_cachedPosition))
+    {
+      m_cachedPosition = vector;
+      m_cachedCoordZ = woss::CoordZ::getCoordZFromCartesianCoords (vector.x, 
+                                                                   vector.y, 
+                                                                   vector.z, 
+                                                                   woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+      m_isCacheValid = true;
+    }
+
+  return m_cachedCoordZ;
 }
 
 
@@ -52,6 +68,8 @@ void
 WossLocation::SetMobilityModel (Ptr<MobilityModel> m)
 {
   m_mobModel = m;
+  m_geoMobModel = DynamicCast<WossGeoWaypointMobilityModel> (m);
+  m_isCacheValid = false;
 }
 
 
@@ -25,6 +25,7 @@
 
 
 #include <ns3/mobility-model.h>
+#include <ns3/woss-geo-waypoint-mobility-model.h>
 #include <location-definitions.h>
 
 
@@ -52,7 +53,9 @@ public:
        * the node's current position.
    *
    * \returns converts the underlying MobilityModel::GetPosition()
-   * into a woss::CoordZ object
+   * into a woss::CoordZ object. The conversion is cached and run again
+   * only if the node has moved since the last call. A WossGeoWaypointMobilityModel
+   * returns its geographic position directly, without any conversion.
    */
   virtual woss::CoordZ getLocation () override;
 
@@ -65,6 +68,12 @@ protected:
 
   Ptr<MobilityModel> m_mobModel;
 
+  Ptr<WossGeoWaypointMobilityModel> m_geoMobModel; //!< m_mobModel if it has a native geographic position, null otherwise
+
+  bool m_isCacheValid; //!< true if m_cachedPosition and m_cachedCoordZ are valid
+  Vector m_cachedPosition; //!< last converted cartesian position
+  woss::CoordZ m_cachedCoordZ; //!< geodetic conversion of m_cachedPosition
+
 };
 
 
@@ -20,6 +20,8 @@
 
 #ifdef NS3_WOSS_SUPPORT
 
+#include <algorithm>
+#include <cmath>
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -30,9 +32,13 @@
 #include "ns3/pointer.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/nstime.h"
+#include "ns3/boolean.h"
+#include "ns3/trace-source-accessor.h"
 
 #include "woss-channel.h"
 #include "woss-prop-model.h"
+#include "woss-pdp-kernel.h"
 #include "ns3/uan-phy.h"
 #include "ns3/uan-prop-model.h"
 #include "ns3/uan-tx-mode.h"
@@ -60,8 +66,19 @@ WossChannel::GetTypeId ()
     .AddAttribute ("ChannelEqSnrThresholdDb",
                    "The first channel tap that gives a SNR (dB) greater than the threshold will be used as delay.",
                    DoubleValue (WOSS_CHANNEL_SNR_EQ_THRES_DB),
-                   MakeDoubleAccessor (&WossChannel::m_channelEqSnrThresDb),
+                   MakeDoubleAccessor (&WossChannel::SetChannelEqSnrThresholdDb,
+                                       &WossChannel::GetChannelEqSnrThresholdDb),
                    MakeDoubleChecker<double> () )
+    .AddAttribute ("PdpKernels",
+                   "If true, the cumulative tap energy (WossPdpKernel) of every reception is published in the "
+                   "WossPdpKernelRegistry, for the SINR models of the receivers (e.g. WossPhyCalcSinr).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WossChannel::m_pdpKernels),
+                   MakeBooleanChecker () )
+    .AddTraceSource ("StageLatency",
+                     "Wall clock latency of a WOSS channel stage (see WossProfiler::Stage)",
+                     MakeTraceSourceAccessor (&WossChannel::m_stageLatencyTrace),
+                     "ns3::WossPropModel::StageLatencyTracedCallback")
   ;
 
   return tid;
@@ -71,7 +88,12 @@ WossChannel::WossChannel ()
   : UanChannel (),
     m_channelEqSnrThresDb (WOSS_CHANNEL_SNR_EQ_THRES_DB),
     // -infinite snr ==> first tap
-    m_wossPropModel (nullptr)
+    m_wossPropModel (nullptr),
+    m_txModeNoise (),
+    m_txModeNoiseModel (nullptr),
+    m_pdpKernels (false),
+    m_rxMobBuffer (),
+    m_stageLatencyTrace ()
 {
 }
 
@@ -87,6 +109,167 @@ WossChannel::DoInitialize (void)
   UanChannel::DoInitialize ();
 }
 
+void
+WossChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_wossPropModel = nullptr;
+  m_rxMobBuffer.clear ();
+
+  if (m_pdpKernels)
+    {
+      // the kernels of the receptions that will never be delivered are released with their packets
+      WossPdpKernelRegistry::Purge ();
+    }
+
+  UanChannel::DoDispose ();
+}
+
+void
+WossChannel::SetChannelEqSnrThresholdDb (double snrThresDb)
+{
+  m_channelEqSnrThresDb = snrThresDb;
+
+  InvalidateTxModeCache ();
+}
+
+double
+WossChannel::GetChannelEqSnrThresholdDb (void) const
+{
+  return m_channelEqSnrThresDb;
+}
+
+void
+WossChannel::InvalidateTxModeCache (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_txModeNoise.clear ();
+  m_txModeNoiseModel = nullptr;
+}
+
+const WossChannel::TxModeNoise &
+WossChannel::GetTxModeNoise (const UanTxMode &txMode, double txPowerDb)
+{
+  // UanChannel::SetNoiseModel is not virtual, a new noise model is detected here
+  if (m_txModeNoiseModel != PeekPointer (m_noise))
+    {
+      m_txModeNoise.clear ();
+      m_txModeNoiseModel = PeekPointer (m_noise);
+    }
+
+  auto it = m_txModeNoise.find (txMode.GetUid ());
+
+  if (it == m_txModeNoise.end ())
+    {
+      double noisePwrDb = GetNoiseDbHz ( (double) txMode.GetCenterFreqHz () / 1000.0) + 10 * log10 (txMode.GetBandwidthHz ());
+
+      // NaN forces the thresholds computation below
+      it = m_txModeNoise.emplace (txMode.GetUid (), TxModeNoise { noisePwrDb, std::nan (""), 0.0, 0.0 }).first;
+    }
+
+  TxModeNoise &entry = it->second;
+
+  if (entry.txPowerDb != txPowerDb)
+    {
+      entry.txPowerDb = txPowerDb;
+      entry.chAttThresDb = txPowerDb - m_channelEqSnrThresDb - entry.noisePwrDb;
+      // taps stronger than 0 dB attenuation are always usable
+      entry.ampThres = ::std::pow (10.0, -::std::max (entry.chAttThresDb, 0.0) / 20.0);
+
+      NS_LOG_DEBUG ("mode:" << txMode.GetName () << "; noisePwrDb:" << entry.noisePwrDb << "dB; chAttThresDb:"
+                            << entry.chAttThresDb << "dB; ampThres:" << entry.ampThres);
+    }
+
+  return entry;
+}
+
+void
+WossChannel::SendUpPdp (uint32_t i, Ptr<Packet> packet, double rxPowerDb, UanTxMode txMode, ConstUanPdpPtr pdp)
+{
+  NS_LOG_FUNCTION (this << i);
+
+  // UanTransducer::Receive takes the PDP by value, the only copy left on the delivery path
+  m_devList[i].second->Receive (packet, rxPowerDb, txMode, *pdp);
+}
+
+void
+WossChannel::RecordStage (Ptr<WossProfiler> profiler, WossProfiler::Stage stage, double startTime, uint32_t items)
+{
+  double latency = WossProfiler::GetWallTime () - startTime;
+
+  if (profiler != nullptr)
+    {
+      profiler->Record (stage, latency, items);
+    }
+
+  m_stageLatencyTrace (stage, Seconds (latency), items);
+}
+
+void
+WossChannel::ComputeRxPowerAndDelay (const UanPdp &pdp, double txPowerDb, double ampThres,
+                                     double &rxPowerDb, Time &delay) const
+{
+  double totalAttCh = 0.0;
+  double totalAttChdB = HUGE_VAL;
+  bool delayFound = false;
+  // attChDb <= chAttThresDb  <==>  |amp|^2 >= ampThres^2
+  double powerThres = ampThres * ampThres;
+
+  rxPowerDb = -HUGE_VAL;
+
+  UanPdp::Iterator it = pdp.GetBegin ();
+
+  delay = it->GetDelay ();
+
+  for (int tapCnt = 0; it != pdp.GetEnd (); ++it, ++tapCnt)
+    {
+      double tapPower = ::std::norm (it->GetAmp ());
+
+      if ( tapPower >= powerThres )
+        {
+          NS_LOG_DEBUG ("tap:" << tapCnt << "; attenuation below threshold, attChDb:"
+                               << -10.0 * ::std::log10 (tapPower) << "dB" );
+
+          if ( delayFound == false )
+            {
+              delay = it->GetDelay ();
+              delayFound = true;
+
+              NS_LOG_DEBUG ("found delay:" << delay);
+            }
+        }
+
+      // we found first usable tap
+      if (delayFound == true)
+        {
+          totalAttCh += tapPower;
+
+          NS_LOG_DEBUG ("summing tap:" << tapCnt << "; totalAttCh:" << totalAttCh);
+        }
+    }
+
+  if (delayFound == true)
+    {
+      totalAttCh = ::std::sqrt (totalAttCh);
+      totalAttChdB = -20.0 * ::std::log10 (totalAttCh);
+
+      rxPowerDb = txPowerDb - totalAttChdB;
+
+      NS_LOG_DEBUG ("totalAttCh:" << totalAttCh << "; totalAttChdB:" << totalAttChdB
+                                  << "dB; rxPowerDb:" << rxPowerDb << "dB");
+    }
+}
+
+bool
+WossChannel::GetFreqResponse (Ptr<MobilityModel> tx, Ptr<MobilityModel> rx, UanTxMode mode,
+                              WossFreqResponse &response) const
+{
+  NS_ASSERT (m_wossPropModel != nullptr);
+
+  return m_wossPropModel->GetFreqResponse (tx, rx, mode, response);
+}
 
 void
 WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
@@ -96,17 +279,19 @@ WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
 
   Ptr<MobilityModel> senderMobility = 0;
   Ptr<MobilityModel> tempRxMobility = 0;
-  WossPropModel::MobModelVector rxMobVector;
+  // per transmission buffers, they keep their capacity across transmissions
+  WossPropModel::MobModelVector &rxMobVector = m_rxMobBuffer;
   WossPropModel::UanPdpVector uanPdpVector;
 
-  double noisePwrDb = GetNoiseDbHz ( (double) txMode.GetCenterFreqHz () / 1000.0) + 10 * log10 (txMode.GetBandwidthHz ());
-  double chAttThresDb = txPowerDb - m_channelEqSnrThresDb - noisePwrDb;
+  const TxModeNoise &txModeNoise = GetTxModeNoise (txMode, txPowerDb);
 
-  NS_LOG_DEBUG ("noisePwrDb:" << noisePwrDb << "dB; chAttThresDb:"
-                              << chAttThresDb << "dB; m_channelEqSnrThresDb:" << m_channelEqSnrThresDb << "dB");
+  NS_LOG_DEBUG ("noisePwrDb:" << txModeNoise.noisePwrDb << "dB; chAttThresDb:" << txModeNoise.chAttThresDb
+                              << "dB; m_channelEqSnrThresDb:" << m_channelEqSnrThresDb << "dB");
 
   NS_LOG_DEBUG ("Channel scheduling");
 
+  rxMobVector.reserve (m_devList.size ());
+
   for (UanDeviceList::const_iterator i = m_devList.begin (); i != m_devList.end (); i++)
     {
       tempRxMobility = i->first->GetNode ()->GetObject<MobilityModel> ();
@@ -127,11 +312,16 @@ WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
 
   NS_LOG_DEBUG ("rxMobVector.size ():" << rxMobVector.size ());
 
-  uanPdpVector = m_wossPropModel->GetPdpVector (senderMobility, rxMobVector, txMode);
+  // the PDP truncation starts from the tap that sets the delivery delay
+  uanPdpVector = m_wossPropModel->GetPdpVector (senderMobility, rxMobVector, txMode, txModeNoise.ampThres);
 
   NS_LOG_DEBUG ("uanPdpVector.size ():" << uanPdpVector.size ()
                                         << "; m_devList.size ():" << m_devList.size ());
 
+  Ptr<WossProfiler> profiler = m_wossPropModel->GetProfiler ();
+  bool profiling = (profiler != nullptr) || (!m_stageLatencyTrace.IsEmpty ());
+  double schedStartTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
   uint32_t k = 0;
   WossPropModel::UanPdpVector::iterator j = uanPdpVector.begin ();
   for ( UanDeviceList::const_iterator i = m_devList.begin (); i != m_devList.end (); ++i, ++k)
@@ -139,61 +329,14 @@ WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
       if (src != i->second)
         {
           double rxPowerDb = -HUGE_VAL;
-          double totalAttCh = 0.0;
-          double totalAttChdB = HUGE_VAL;
-          bool delayFound = false;
+          Time delay;
 
           NS_LOG_DEBUG ("src:" << src << "; dst:" << i->second
                                << "; UanPdp size:" << j->GetNTaps ());
 
-          UanPdp::Iterator it = j->GetBegin ();
-
-          Time delay = it->GetDelay ();
+          ComputeRxPowerAndDelay (*j, txPowerDb, txModeNoise.ampThres, rxPowerDb, delay);
 
-          if ( chAttThresDb < 0.0 )
-            {
-              chAttThresDb = 0.0;
-            }
-
-          for (int tapCnt = 0; it != j->GetEnd (); ++it, ++tapCnt)
-            {
-              double attChDb = -20.0 * ::std::log10 (::std::abs (it->GetAmp ()));
-
-              if ( (attChDb < 0.0) || (attChDb <= chAttThresDb) )
-                {
-                  NS_LOG_DEBUG ("tap:" << tapCnt << "; attenuation below threshold, attChDb:" << attChDb << "dB" );
-
-                  if ( delayFound == false )
-                    {
-                      delay = it->GetDelay ();
-                      delayFound = true;
-
-                      NS_LOG_DEBUG ("found delay:" << delay);
-                    }
-                }
-
-              // we found first usable tap
-              if (delayFound == true)
-                {
-                  totalAttCh += ::std::pow (::std::abs (it->GetAmp ()), 2.0);
-
-                  NS_LOG_DEBUG ("summing tap:" << tapCnt << "; totalAttCh:" << totalAttCh);
-                }
-            }
-
-          if (delayFound == true)
-            {
-              totalAttCh = ::std::sqrt (totalAttCh);
-              totalAttChdB = -20.0 * ::std::log10 (totalAttCh);
-
-              rxPowerDb = txPowerDb - totalAttChdB;
-
-              NS_LOG_DEBUG ("totalAttCh:" << totalAttCh << "; totalAttChdB:" << totalAttChdB
-                                          << "dB; rxPowerDb:" << rxPowerDb << "dB");
-
-            }
-
-          // else rxPowerDb is -infinite and rx is not possible
+          // if rxPowerDb is -infinite rx is not possible
 
           uint32_t dstNodeId = i->first->GetNode ()->GetId ();
           Ptr<Packet> copy = packet->Copy ();
@@ -205,16 +348,30 @@ WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
                                        << pathLossDb << "dB, rxPowerDb1="
                                        << rxPowerDb << "dB, rxPowerDb2=" << (txPowerDb - pathLossDb) << "dB, delay=" << delay);
 
-          UanPdp normalizedPdp = j->NormalizeToSumNc ();
+          double normStartTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
+          // the event binds a handle, the taps are not copied into the scheduler
+          ConstUanPdpPtr normalizedPdp = std::make_shared<const UanPdp> (j->NormalizeToSumNc ());
+
+          if (profiling)
+            {
+              RecordStage (profiler, WossProfiler::PDP_NORMALIZATION, normStartTime, normalizedPdp->GetNTaps ());
+            }
+
+          if (m_pdpKernels)
+            {
+              // keyed by the packet copy, which travels unchanged up to the SINR model of the receiver.
+              // The kernel is anchored on the tap that sets the delivery delay and the received power
+              WossPdpKernelRegistry::Publish (copy, std::make_shared<const WossPdpKernel> (*normalizedPdp, delay));
+            }
 
           Simulator::ScheduleWithContext (dstNodeId, delay,
-                                          &WossChannel::SendUp,
+                                          &WossChannel::SendUpPdp,
                                           this,
                                           k,
                                           copy,
                                           rxPowerDb,
                                           txMode,
-//                                       (*j));
                                           normalizedPdp);
 
           if ( j != uanPdpVector.end () )
@@ -223,6 +380,14 @@ WossChannel::TxPacket (Ptr<UanTransducer> src, Ptr<Packet> packet,
             }
         }
     }
+
+  // the receivers references are released, the capacity is kept
+  rxMobVector.clear ();
+
+  if (profiling)
+    {
+      RecordStage (profiler, WossProfiler::TX_SCHEDULING, schedStartTime, uanPdpVector.size ());
+    }
 }
 
 
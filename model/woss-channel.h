@@ -24,6 +24,9 @@
 #define WOSS_CHANNEL_H
 
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "ns3/uan-channel.h"
 #include "woss-prop-model.h"
 
@@ -59,7 +62,69 @@ public:
   virtual void TxPacket  (Ptr<UanTransducer> src, Ptr<Packet> packet, double txPowerDb,
                           UanTxMode txmode) override;
 
+  /**
+   * Returns the frequency response of the link of the last transmission from tx to rx, as computed by
+   * the WossPropModel with the "FreqResponse" attribute set. PHY models can read per-subcarrier gains from it.
+   * \param tx transmitter mobility model
+   * \param rx receiver mobility model
+   * \param mode transmission mode
+   * \param response the frequency response
+   * \returns false if not available
+   */
+  bool GetFreqResponse (Ptr<MobilityModel> tx, Ptr<MobilityModel> rx, UanTxMode mode, WossFreqResponse &response) const;
+
+  /**
+   * \param snrThresDb the SNR threshold of the first channel tap used as transmission delay [dB]
+   */
+  void SetChannelEqSnrThresholdDb (double snrThresDb);
+
+  /**
+   * \returns the SNR threshold of the first channel tap used as transmission delay [dB]
+   */
+  double GetChannelEqSnrThresholdDb (void) const;
+
+  /**
+   * Clears the per UanTxMode noise power and thresholds.
+   * It must be called if the attributes of the noise model are changed during the simulation;
+   * a new noise model or a new SNR threshold are detected automatically.
+   */
+  void InvalidateTxModeCache (void);
+
 protected:
+  /**
+   * Noise power and thresholds of a UanTxMode, computed once per mode and transmission power
+   */
+  struct TxModeNoise
+  {
+    double noisePwrDb; //!< noise power in the mode band [dB]
+    double txPowerDb; //!< transmission power of the thresholds [dB]
+    double chAttThresDb; //!< channel attenuation threshold [dB]
+    double ampThres; //!< channel tap amplitude threshold, linear, matching chAttThresDb
+  };
+
+  typedef std::unordered_map<uint32_t, TxModeNoise> TxModeNoiseMap; //!< map of noise entries, keyed by UanTxMode uid
+
+  /**
+   * Returns the noise power and thresholds of a mode, computing them on the first use of the mode
+   * or when the transmission power changes
+   * \param txMode the transmission mode
+   * \param txPowerDb transmission power in dB
+   * \returns the noise entry of the mode
+   */
+  const TxModeNoise &GetTxModeNoise (const UanTxMode &txMode, double txPowerDb);
+
+  typedef std::shared_ptr<const UanPdp> ConstUanPdpPtr; //!< immutable PDP shared by the delivery events
+
+  /**
+   * Delivers a reception to a transducer, as UanChannel::SendUp, without copying the PDP into the event
+   * \param i index of the receiver in m_devList
+   * \param packet copy of the transmitted packet
+   * \param rxPowerDb received power [dB]
+   * \param txMode UanTxMode of the transmission
+   * \param pdp normalized power delay profile
+   */
+  void SendUpPdp (uint32_t i, Ptr<Packet> packet, double rxPowerDb, UanTxMode txMode, ConstUanPdpPtr pdp);
+
   /**
    * The first channel tap that gives a SNR (dB) greater
    * than the threshold will be used as transmission delay
@@ -68,7 +133,42 @@ protected:
 
   Ptr<WossPropModel> m_wossPropModel; //!< Smart ptr to a WossPropModel object
 
+  TxModeNoiseMap m_txModeNoise; //!< per UanTxMode noise power and thresholds
+
+  UanNoiseModel *m_txModeNoiseModel; //!< noise model used to compute m_txModeNoise, only used for comparison
+
+  bool m_pdpKernels; //!< if true a WossPdpKernel of every reception is published in the WossPdpKernelRegistry
+
+  WossPropModel::MobModelVector m_rxMobBuffer; //!< receivers buffer of TxPacket, reused across transmissions
+
+  TracedCallback<uint32_t, Time, uint32_t> m_stageLatencyTrace; //!< trace fired at the end of every profiled stage
+
   virtual void DoInitialize (void) override;
+
+  virtual void DoDispose (void) override;
+
+  /**
+   * Records a stage execution into the WossProfiler of the WossPropModel and fires the StageLatency trace
+   * \param profiler the WossProfiler object, can be null
+   * \param stage the profiled stage
+   * \param startTime the stage start time, as returned by WossProfiler::GetWallTime ()
+   * \param items number of items processed by the stage
+   */
+  void RecordStage (Ptr<WossProfiler> profiler, WossProfiler::Stage stage, double startTime, uint32_t items);
+
+  /**
+   * Computes the received power and the transmission delay from a UanPdp.
+   * The delay is given by the first tap whose attenuation is below the threshold,
+   * the received power by the coherent sum of all the following taps.
+   * The threshold is linear, see TxModeNoise::ampThres, so the tap loop needs no logarithm.
+   * \param pdp the power delay profile
+   * \param txPowerDb transmission power in dB
+   * \param ampThres channel tap amplitude threshold, linear
+   * \param rxPowerDb returned received power in dB, -HUGE_VAL if no tap is above the threshold
+   * \param delay returned transmission delay
+   */
+  void ComputeRxPowerAndDelay (const UanPdp &pdp, double txPowerDb, double ampThres,
+                               double &rxPowerDb, Time &delay) const;
 };
 
 }
@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <cmath>
+#include <limits>
+#include "ns3/log.h"
+#include "woss-freq-response.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossFreqResponse");
+
+WossFreqResponse::WossFreqResponse ()
+  : m_carrierFreq (0.0),
+    m_delays (),
+    m_amplitudes ()
+{
+}
+
+WossFreqResponse::WossFreqResponse (const woss::TimeArr &timeArr, double carrierFreq, double gain)
+  : m_carrierFreq (carrierFreq),
+    m_delays (),
+    m_amplitudes ()
+{
+  NS_LOG_FUNCTION (this << carrierFreq << gain);
+
+  m_delays.reserve (timeArr.size ());
+  m_amplitudes.reserve (timeArr.size ());
+
+  double firstDelay = 0.0;
+
+  for (woss::TimeArrCIt it = timeArr.begin (); it != timeArr.end (); ++it)
+    {
+      double delay = it->first;
+
+      if (m_delays.empty ())
+        {
+          firstDelay = delay;
+        }
+
+      m_delays.push_back (delay - firstDelay);
+      m_amplitudes.push_back (gain * it->second);
+    }
+
+  NS_LOG_DEBUG ("arrivals: " << m_delays.size ());
+}
+
+bool
+WossFreqResponse::IsEmpty (void) const
+{
+  return m_amplitudes.empty ();
+}
+
+double
+WossFreqResponse::GetCarrierFreq (void) const
+{
+  return m_carrierFreq;
+}
+
+uint32_t
+WossFreqResponse::GetNArrivals (void) const
+{
+  return m_amplitudes.size ();
+}
+
+std::complex<double>
+WossFreqResponse::GetResponse (double freq) const
+{
+  std::complex<double> retVal (0.0, 0.0);
+  double omega = -2.0 * M_PI * (freq - m_carrierFreq);
+
+  for (size_t k = 0; k < m_amplitudes.size (); ++k)
+    {
+      retVal += m_amplitudes[k] * std::polar (1.0, omega * m_delays[k]);
+    }
+
+  return retVal;
+}
+
+std::vector<std::complex<double> >
+WossFreqResponse::GetResponses (double startFreq, double spacing, uint32_t nSubcarriers) const
+{
+  std::vector<std::complex<double> > retVal (nSubcarriers, std::complex<double> (0.0, 0.0));
+  double omegaStart = -2.0 * M_PI * (startFreq - m_carrierFreq);
+  double omegaStep = -2.0 * M_PI * spacing;
+
+  // each arrival contributes a rotating phasor: one complex product per subcarrier
+  for (size_t k = 0; k < m_amplitudes.size (); ++k)
+    {
+      std::complex<double> phasor = m_amplitudes[k] * std::polar (1.0, omegaStart * m_delays[k]);
+      const std::complex<double> rotation = std::polar (1.0, omegaStep * m_delays[k]);
+
+      for (uint32_t n = 0; n < nSubcarriers; ++n)
+        {
+          retVal[n] += phasor;
+          phasor *= rotation;
+        }
+    }
+
+  return retVal;
+}
+
+std::vector<double>
+WossFreqResponse::GetGainsDb (double startFreq, double spacing, uint32_t nSubcarriers) const
+{
+  std::vector<std::complex<double> > responses = GetResponses (startFreq, spacing, nSubcarriers);
+  std::vector<double> retVal (nSubcarriers);
+
+  for (uint32_t n = 0; n < nSubcarriers; ++n)
+    {
+      double power = std::norm (responses[n]);
+
+      retVal[n] = power > 0.0 ? 10.0 * std::log10 (power) : -std::numeric_limits<double>::infinity ();
+    }
+
+  return retVal;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_FREQ_RESPONSE_H
+#define WOSS_FREQ_RESPONSE_H
+
+#include <complex>
+#include <vector>
+#include <time-arrival-definitions.h>
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossFreqResponse
+ * \brief Frequency response of an acoustic link, computed from the WOSS arrival structure
+ *
+ * The response is built once from the full resolution woss::TimeArr of the link, before the coherent
+ * sum at symbol time, so it keeps the frequency selectivity that the PDP of a narrowband mode loses:
+ * \f$ H(f) = \sum_k a_k e^{-j 2 \pi (f - f_c) \tau_k} \f$, with \f$ \tau_k \f$ relative to the first arrival.
+ * Evenly spaced subcarriers are evaluated with a phase recurrence, without any trigonometric call per subcarrier.
+ */
+class WossFreqResponse
+{
+public:
+  WossFreqResponse (); //!< Default constructor, empty response
+
+  /**
+   * \param timeArr the arrivals of the link
+   * \param carrierFreq the carrier frequency [Hz] the arrivals were computed at
+   * \param gain amplitude gain applied to all the arrivals
+   */
+  WossFreqResponse (const woss::TimeArr &timeArr, double carrierFreq, double gain = 1.0);
+
+  /**
+   * \returns true if the link has no arrival
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \returns the carrier frequency [Hz]
+   */
+  double GetCarrierFreq (void) const;
+
+  /**
+   * \returns the number of arrivals
+   */
+  uint32_t GetNArrivals (void) const;
+
+  /**
+   * \param freq frequency [Hz]
+   * \returns the complex channel gain at freq
+   */
+  std::complex<double> GetResponse (double freq) const;
+
+  /**
+   * \param startFreq frequency of the first subcarrier [Hz]
+   * \param spacing subcarrier spacing [Hz]
+   * \param nSubcarriers number of subcarriers
+   * \returns the complex channel gain of each subcarrier
+   */
+  std::vector<std::complex<double> > GetResponses (double startFreq, double spacing, uint32_t nSubcarriers) const;
+
+  /**
+   * \param startFreq frequency of the first subcarrier [Hz]
+   * \param spacing subcarrier spacing [Hz]
+   * \param nSubcarriers number of subcarriers
+   * \returns the power gain of each subcarrier [dB]
+   */
+  std::vector<double> GetGainsDb (double startFreq, double spacing, uint32_t nSubcarriers) const;
+
+private:
+  double m_carrierFreq; //!< carrier frequency [Hz]
+  std::vector<double> m_delays; //!< arrival delays, relative to the first arrival [s]
+  std::vector<std::complex<double> > m_amplitudes; //!< arrival complex amplitudes
+};
+
+}
+
+#endif /* WOSS_FREQ_RESPONSE_H */
+
+#endif /* NS3_WOSS_SUPPORT */
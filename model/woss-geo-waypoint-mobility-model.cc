@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "woss-geo-waypoint-mobility-model.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossGeoWaypointMobilityModel");
+
+NS_OBJECT_ENSURE_REGISTERED (WossGeoWaypointMobilityModel);
+
+
+TypeId
+WossGeoWaypointMobilityModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WossGeoWaypointMobilityModel")
+    .SetParent<MobilityModel> ()
+    .SetGroupName ("Woss")
+    .AddConstructor<WossGeoWaypointMobilityModel> ()
+  ;
+  return tid;
+}
+
+WossGeoWaypointMobilityModel::WossGeoWaypointMobilityModel ()
+  : m_waypoints (),
+    m_legStart (),
+    m_legEnd (),
+    m_leg (),
+    m_legVelocity (),
+    m_isInitialized (false),
+    m_cachedTime (),
+    m_cachedPosition (),
+    m_isCacheValid (false)
+{
+}
+
+void
+WossGeoWaypointMobilityModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_waypoints.clear ();
+
+  MobilityModel::DoDispose ();
+}
+
+void
+WossGeoWaypointMobilityModel::AddWaypoint (const Time &time, const woss::CoordZ &coordZ)
+{
+  NS_LOG_FUNCTION (this << time << coordZ);
+
+  GeoWaypoint waypoint { time, coordZ };
+
+  if (m_isInitialized == false)
+    {
+      // the first waypoint is both start and end of a zero length leg
+      m_legStart = waypoint;
+      m_legEnd = waypoint;
+      m_leg = WossGreatCircleLeg (coordZ, coordZ);
+      m_legVelocity = Vector (0.0, 0.0, 0.0);
+      m_isInitialized = true;
+      m_isCacheValid = false;
+      NotifyCourseChange ();
+      return;
+    }
+
+  NS_ABORT_MSG_IF ((m_waypoints.empty () ? m_legEnd.time : m_waypoints.back ().time) >= time,
+                   "Waypoints must be added in ascending time order");
+
+  m_waypoints.push_back (waypoint);
+}
+
+uint32_t
+WossGeoWaypointMobilityModel::WaypointsLeft (void) const
+{
+  Update ();
+
+  return m_waypoints.size ();
+}
+
+void
+WossGeoWaypointMobilityModel::EndMobility (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  woss::CoordZ current = GetCoordZ ();
+
+  m_waypoints.clear ();
+  m_legStart = GeoWaypoint { Simulator::Now (), current };
+  m_legEnd = m_legStart;
+  m_leg = WossGreatCircleLeg (current, current);
+  m_legVelocity = Vector (0.0, 0.0, 0.0);
+  m_isCacheValid = false;
+
+  NotifyCourseChange ();
+}
+
+void
+WossGeoWaypointMobilityModel::Update (void) const
+{
+  const Time now = Simulator::Now ();
+  bool newLeg = false;
+
+  while (now >= m_legEnd.time && !m_waypoints.empty ())
+    {
+      m_legStart = m_legEnd;
+      m_legEnd = m_waypoints.front ();
+      m_waypoints.pop_front ();
+      newLeg = true;
+    }
+
+  if (newLeg == false)
+    {
+      return;
+    }
+
+  // all leg constants are computed once per leg
+  m_leg = WossGreatCircleLeg (m_legStart.coordZ, m_legEnd.coordZ);
+
+  const double tSpan = (m_legEnd.time - m_legStart.time).GetSeconds ();
+  NS_ASSERT (tSpan > 0);
+
+  Vector startPos = m_leg.GetCartesian (0.0);
+  Vector endPos = m_leg.GetCartesian (1.0);
+
+  m_legVelocity = Vector ((endPos.x - startPos.x) / tSpan,
+                          (endPos.y - startPos.y) / tSpan,
+                          (endPos.z - startPos.z) / tSpan);
+  m_isCacheValid = false;
+
+  NS_LOG_DEBUG ("new leg: start=" << m_legStart.coordZ << "; end=" << m_legEnd.coordZ
+                                   << "; angular distance=" << m_leg.GetAngularDistance ());
+
+  NotifyCourseChange ();
+}
+
+double
+WossGeoWaypointMobilityModel::GetLegRatio (void) const
+{
+  const Time now = Simulator::Now ();
+
+  if (now <= m_legStart.time)
+    {
+      return 0.0;
+    }
+
+  if (now >= m_legEnd.time)
+    {
+      return 1.0;
+    }
+
+  return (now - m_legStart.time).GetSeconds () / (m_legEnd.time - m_legStart.time).GetSeconds ();
+}
+
+woss::CoordZ
+WossGeoWaypointMobilityModel::GetCoordZ (void) const
+{
+  NS_ASSERT (m_isInitialized == true);
+
+  Update ();
+
+  return m_leg.GetCoordZ (GetLegRatio ());
+}
+
+Vector
+WossGeoWaypointMobilityModel::DoGetPosition (void) const
+{
+  if (m_isInitialized == false)
+    {
+      return Vector (0.0, 0.0, 0.0);
+    }
+
+  Update ();
+
+  const Time now = Simulator::Now ();
+
+  if (m_isCacheValid == false || m_cachedTime != now)
+    {
+      m_cachedPosition = m_leg.GetCartesian (GetLegRatio ());
+      m_cachedTime = now;
+      m_isCacheValid = true;
+    }
+
+  return m_cachedPosition;
+}
+
+void
+WossGeoWaypointMobilityModel::DoSetPosition (const Vector &position)
+{
+  NS_LOG_FUNCTION (this << position);
+
+  woss::CoordZ coordZ = woss::CoordZ::getCoordZFromCartesianCoords (position.x,
+                                                                    position.y,
+                                                                    position.z,
+                                                                    woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  // the node is moved and stopped, pending waypoints are kept and followed from the new position
+  m_legStart = GeoWaypoint { Simulator::Now (), coordZ };
+  m_legEnd = m_legStart;
+  m_leg = WossGreatCircleLeg (coordZ, coordZ);
+  m_legVelocity = Vector (0.0, 0.0, 0.0);
+  m_isInitialized = true;
+  m_isCacheValid = false;
+
+  NotifyCourseChange ();
+}
+
+Vector
+WossGeoWaypointMobilityModel::DoGetVelocity (void) const
+{
+  Update ();
+
+  const Time now = Simulator::Now ();
+
+  if (now < m_legStart.time || now >= m_legEnd.time)
+    {
+      return Vector (0.0, 0.0, 0.0);
+    }
+
+  return m_legVelocity;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_GEO_WAYPOINT_MOBILITY_MODEL_H
+#define WOSS_GEO_WAYPOINT_MOBILITY_MODEL_H
+
+#include <deque>
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "woss-great-circle.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \brief Waypoint mobility model with native geographic state.
+ *
+ * Unlike ns3::WossWaypointMobilityModel, waypoints are given and stored as woss::CoordZ,
+ * and every leg between two waypoints is precomputed once as a WossGreatCircleLeg.
+ * The current position is kept in geographic coordinates (see GetCoordZ) and the
+ * WGS84 cartesian position is computed lazily, at most once per simulation time,
+ * without any iterative ellipsoid solve.
+ * Before the first waypoint time the node stays at the first waypoint,
+ * after the last waypoint it stays at the last one.
+ */
+class WossGeoWaypointMobilityModel : public MobilityModel
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  WossGeoWaypointMobilityModel (); //!< Default constructor
+
+  virtual ~WossGeoWaypointMobilityModel () = default; //!< Default destructor
+
+  /**
+   * Adds a waypoint. Waypoints must be added in increasing time order.
+   * \param time the waypoint time
+   * \param coordZ the waypoint geographic coordinates
+   */
+  void AddWaypoint (const Time &time, const woss::CoordZ &coordZ);
+
+  /**
+   * \returns the current geographic coordinates
+   */
+  woss::CoordZ GetCoordZ (void) const;
+
+  /**
+   * \returns the number of waypoints not yet reached as leg start
+   */
+  uint32_t WaypointsLeft (void) const;
+
+  /**
+   * Clears all the pending waypoints and stops the node at its current position
+   */
+  void EndMobility (void);
+
+private:
+  /**
+   * Geographic waypoint
+   */
+  struct GeoWaypoint
+  {
+    Time time; //!< waypoint time
+    woss::CoordZ coordZ; //!< waypoint coordinates
+  };
+
+  /**
+   * Advances the current leg up to the current simulation time
+   */
+  void Update (void) const;
+
+  /**
+   * \returns the fraction of the current leg at the current simulation time
+   */
+  double GetLegRatio (void) const;
+
+  virtual Vector DoGetPosition (void) const override;
+  virtual void DoSetPosition (const Vector &position) override;
+  virtual Vector DoGetVelocity (void) const override;
+  virtual void DoDispose (void) override;
+
+  mutable std::deque<GeoWaypoint> m_waypoints; //!< pending waypoints
+  mutable GeoWaypoint m_legStart; //!< current leg start
+  mutable GeoWaypoint m_legEnd; //!< current leg end
+  mutable WossGreatCircleLeg m_leg; //!< precomputed current leg
+  mutable Vector m_legVelocity; //!< cartesian chord velocity of the current leg
+  mutable bool m_isInitialized; //!< true if at least one waypoint or position has been set
+  mutable Time m_cachedTime; //!< simulation time of m_cachedPosition
+  mutable Vector m_cachedPosition; //!< lazily computed cartesian position
+  mutable bool m_isCacheValid; //!< true if m_cachedPosition is valid for m_cachedTime
+};
+
+} // namespace ns3
+
+#endif /* WOSS_GEO_WAYPOINT_MOBILITY_MODEL_H */
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <cmath>
+#include "ns3/assert.h"
+#include "woss-great-circle.h"
+
+
+namespace ns3 {
+
+WossGreatCircleLeg::WossGreatCircleLeg ()
+  : m_start (),
+    m_end (),
+    m_startVect { 1.0, 0.0, 0.0 },
+    m_orthoVect { 0.0, 0.0, 0.0 },
+    m_angularDistance (0.0),
+    m_initialBearing (0.0),
+    m_depthDiff (0.0)
+{
+}
+
+WossGreatCircleLeg::WossGreatCircleLeg (const woss::CoordZ &start, const woss::CoordZ &end)
+  : m_start (start),
+    m_end (end),
+    m_startVect { 0.0, 0.0, 0.0 },
+    m_orthoVect { 0.0, 0.0, 0.0 },
+    m_angularDistance (0.0),
+    m_initialBearing (0.0),
+    m_depthDiff (end.getDepth () - start.getDepth ())
+{
+  double lat1 = start.getLatitude () * M_PI / 180.0;
+  double lon1 = start.getLongitude () * M_PI / 180.0;
+  double lat2 = end.getLatitude () * M_PI / 180.0;
+  double lon2 = end.getLongitude () * M_PI / 180.0;
+
+  m_startVect[0] = std::cos (lat1) * std::cos (lon1);
+  m_startVect[1] = std::cos (lat1) * std::sin (lon1);
+  m_startVect[2] = std::sin (lat1);
+
+  double endVect[3] = { std::cos (lat2) * std::cos (lon2),
+                        std::cos (lat2) * std::sin (lon2),
+                        std::sin (lat2) };
+
+  double dot = m_startVect[0] * endVect[0] + m_startVect[1] * endVect[1] + m_startVect[2] * endVect[2];
+
+  // component of the end vector orthogonal to the start vector
+  double ortho[3] = { endVect[0] - dot * m_startVect[0],
+                      endVect[1] - dot * m_startVect[1],
+                      endVect[2] - dot * m_startVect[2] };
+
+  double orthoNorm = std::sqrt (ortho[0] * ortho[0] + ortho[1] * ortho[1] + ortho[2] * ortho[2]);
+
+  // atan2 is accurate for both short and almost antipodal legs
+  m_angularDistance = std::atan2 (orthoNorm, dot);
+
+  if (orthoNorm > 0.0)
+    {
+      for (int i = 0; i < 3; ++i)
+        {
+          m_orthoVect[i] = ortho[i] / orthoNorm;
+        }
+    }
+
+  double deltaLon = lon2 - lon1;
+
+  m_initialBearing = std::atan2 (std::sin (deltaLon) * std::cos (lat2),
+                                 std::cos (lat1) * std::sin (lat2) - std::sin (lat1) * std::cos (lat2) * std::cos (deltaLon));
+}
+
+woss::CoordZ
+WossGreatCircleLeg::GetCoordZ (double ratio) const
+{
+  NS_ASSERT (ratio >= 0.0 && ratio <= 1.0);
+
+  if (ratio <= 0.0)
+    {
+      return m_start;
+    }
+
+  if (ratio >= 1.0)
+    {
+      return m_end;
+    }
+
+  double depth = m_start.getDepth () + ratio * m_depthDiff;
+
+  if (m_angularDistance <= 0.0)
+    {
+      return woss::CoordZ (m_start.getLatitude (), m_start.getLongitude (), depth);
+    }
+
+  double angle = ratio * m_angularDistance;
+  double cosAngle = std::cos (angle);
+  double sinAngle = std::sin (angle);
+
+  double x = cosAngle * m_startVect[0] + sinAngle * m_orthoVect[0];
+  double y = cosAngle * m_startVect[1] + sinAngle * m_orthoVect[1];
+  double z = cosAngle * m_startVect[2] + sinAngle * m_orthoVect[2];
+
+  double lat = std::atan2 (z, std::sqrt (x * x + y * y)) * 180.0 / M_PI;
+  double lon = std::atan2 (y, x) * 180.0 / M_PI;
+
+  return woss::CoordZ (lat, lon, depth);
+}
+
+Vector
+WossGreatCircleLeg::GetCartesian (double ratio) const
+{
+  woss::CoordZ::CartCoords cartCoords = GetCoordZ (ratio).getCartCoords (woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  return Vector (cartCoords.getX (), cartCoords.getY (), cartCoords.getZ ());
+}
+
+const woss::CoordZ &
+WossGreatCircleLeg::GetStart (void) const
+{
+  return m_start;
+}
+
+const woss::CoordZ &
+WossGreatCircleLeg::GetEnd (void) const
+{
+  return m_end;
+}
+
+double
+WossGreatCircleLeg::GetAngularDistance (void) const
+{
+  return m_angularDistance;
+}
+
+double
+WossGreatCircleLeg::GetDistance (void) const
+{
+  return m_start.getGreatCircleDistance (m_end);
+}
+
+double
+WossGreatCircleLeg::GetInitialBearing (void) const
+{
+  return m_initialBearing;
+}
+
+double
+WossGreatCircleLeg::GetDepthDiff (void) const
+{
+  return m_depthDiff;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
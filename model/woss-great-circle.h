@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_GREAT_CIRCLE_H
+#define WOSS_GREAT_CIRCLE_H
+
+#include <coordinates-definitions.h>
+#include "ns3/vector.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossGreatCircleLeg
+ * \brief Precomputed great circle leg between two geographic coordinates
+ *
+ * All the trigonometry of the leg (unit vectors, angular distance, initial bearing)
+ * is computed once at construction. Intermediate points are then evaluated in closed
+ * form by rotating the start unit vector along the leg plane, with a linear depth profile.
+ * The great circle is computed on the same sphere used by woss::Coord, so the points lie on
+ * the same path returned by woss::Coord::getCoordAlongGreatCircle.
+ */
+class WossGreatCircleLeg
+{
+public:
+  WossGreatCircleLeg (); //!< Default constructor, zero length leg
+
+  /**
+   * \param start leg start coordinates
+   * \param end leg end coordinates
+   */
+  WossGreatCircleLeg (const woss::CoordZ &start, const woss::CoordZ &end);
+
+  /**
+   * \param ratio fraction of the leg, range [0,1]
+   * \returns the geographic coordinates at the given fraction of the leg
+   */
+  woss::CoordZ GetCoordZ (double ratio) const;
+
+  /**
+   * \param ratio fraction of the leg, range [0,1]
+   * \returns the WGS84 cartesian coordinates at the given fraction of the leg
+   */
+  Vector GetCartesian (double ratio) const;
+
+  /**
+   * \returns the leg start coordinates
+   */
+  const woss::CoordZ & GetStart (void) const;
+
+  /**
+   * \returns the leg end coordinates
+   */
+  const woss::CoordZ & GetEnd (void) const;
+
+  /**
+   * \returns the leg angular distance [radians]
+   */
+  double GetAngularDistance (void) const;
+
+  /**
+   * \returns the leg great circle distance at zero depth [m]
+   */
+  double GetDistance (void) const;
+
+  /**
+   * \returns the leg initial bearing [radians]
+   */
+  double GetInitialBearing (void) const;
+
+  /**
+   * \returns the depth difference between end and start [m], signed
+   */
+  double GetDepthDiff (void) const;
+
+private:
+  woss::CoordZ m_start; //!< leg start
+  woss::CoordZ m_end; //!< leg end
+  double m_startVect[3]; //!< unit vector of the leg start
+  double m_orthoVect[3]; //!< unit vector orthogonal to m_startVect in the leg plane, towards the end
+  double m_angularDistance; //!< angular distance [radians]
+  double m_initialBearing; //!< initial bearing [radians]
+  double m_depthDiff; //!< signed depth difference [m]
+};
+
+}
+
+#endif /* WOSS_GREAT_CIRCLE_H */
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,540 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "woss-grid-field.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossGridField");
+
+namespace {
+
+const char GRID_MAGIC[8] = { 'W', 'O', 'S', 'S', 'G', 'R', 'D', '1' }; //!< binary raster magic
+const uint32_t GRID_VERSION = 1; //!< binary raster format version
+const size_t MAX_NUMBER_LENGTH = 63; //!< longest accepted number token, without terminator
+
+/**
+ * Binary raster header, followed by the depths (doubles) and by the values (floats)
+ */
+struct GridHeader
+{
+  char magic[8]; //!< GRID_MAGIC
+  uint32_t version; //!< GRID_VERSION
+  uint32_t nDepth; //!< number of depths, 0 for a 2-D field
+  uint32_t nLat; //!< number of nodes along the latitude
+  uint32_t nLon; //!< number of nodes along the longitude
+  double latMin; //!< latitude of the southernmost nodes [dec degrees]
+  double lonMin; //!< longitude of the westernmost nodes [dec degrees]
+  double latStep; //!< latitude spacing of the nodes [dec degrees]
+  double lonStep; //!< longitude spacing of the nodes [dec degrees]
+};
+
+/**
+ * Reads the numbers of a CSV grid one at a time, without copying the text
+ */
+class CsvReader
+{
+public:
+  /**
+   * \param text the whole file content, it must outlive the reader
+   */
+  explicit CsvReader (const std::string &text)
+    : m_pos (text.data ()),
+      m_end (text.data () + text.size ())
+  {
+  }
+
+  /**
+   * \param value the next number
+   * \returns false if no number is left or the next token is not a number
+   */
+  bool Next (double &value)
+  {
+    while (m_pos < m_end)
+      {
+        if (*m_pos == '#')
+          {
+            m_pos = std::find (m_pos, m_end, '\n');
+          }
+        else if (*m_pos == ',' || *m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' || *m_pos == '\n')
+          {
+            ++m_pos;
+          }
+        else
+          {
+            break;
+          }
+      }
+
+    if (m_pos == m_end)
+      {
+        return false;
+      }
+
+    const char *tokenEnd = std::find_if (m_pos, m_end, [] (char c)
+      {
+        return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '#';
+      });
+
+    if (WossParseDouble (m_pos, tokenEnd, value) == false)
+      {
+        return false;
+      }
+
+    m_pos = tokenEnd;
+
+    return true;
+  }
+
+private:
+  const char *m_pos; //!< current position
+  const char *m_end; //!< end of the text
+};
+
+/**
+ * \param value a number read from the header
+ * \param count the converted count
+ * \returns true if value is a non negative integer
+ */
+bool
+ToCount (double value, uint32_t &count)
+{
+  if (!(value >= 0.0) || value > std::numeric_limits<uint32_t>::max () || std::floor (value) != value)
+    {
+      return false;
+    }
+
+  count = static_cast<uint32_t> (value);
+
+  return true;
+}
+
+} // namespace
+
+bool
+WossParseDouble (const char *begin, const char *end, double &value)
+{
+  size_t length = end - begin;
+
+  if (length == 0 || length > MAX_NUMBER_LENGTH || std::isspace (static_cast<unsigned char> (*begin)))
+    {
+      return false;
+    }
+
+  char buffer[MAX_NUMBER_LENGTH + 1];
+  std::memcpy (buffer, begin, length);
+  buffer[length] = '\0';
+
+  char *parsedEnd = nullptr;
+  errno = 0;
+  double parsed = std::strtod (buffer, &parsedEnd);
+
+  if (parsedEnd != buffer + length || errno == ERANGE)
+    {
+      return false;
+    }
+
+  value = parsed;
+
+  return true;
+}
+
+WossGridField::WossGridField ()
+  : m_latMin (0.0),
+    m_lonMin (0.0),
+    m_latStep (0.0),
+    m_lonStep (0.0),
+    m_nLat (0),
+    m_nLon (0),
+    m_nLayers (0),
+    m_depths (),
+    m_values ()
+{
+}
+
+void
+WossGridField::Clear (void)
+{
+  m_latMin = 0.0;
+  m_lonMin = 0.0;
+  m_latStep = 0.0;
+  m_lonStep = 0.0;
+  m_nLat = 0;
+  m_nLon = 0;
+  m_nLayers = 0;
+  m_depths.clear ();
+  m_values.clear ();
+}
+
+bool
+WossGridField::SetGrid (double latMin, double lonMin, double latStep, double lonStep, uint32_t nLat, uint32_t nLon,
+                        const std::vector<double> &depths, const std::vector<float> &values)
+{
+  NS_LOG_FUNCTION (this << latMin << lonMin << latStep << lonStep << nLat << nLon << depths.size ());
+
+  uint32_t nLayers = std::max<uint32_t> (depths.size (), 1);
+
+  if (!(latStep > 0.0) || !(lonStep > 0.0) || nLat < 2 || nLon < 2
+      || values.size () != (uint64_t) nLat * nLon * nLayers)
+    {
+      NS_LOG_ERROR ("inconsistent grid: latStep=" << latStep << "; lonStep=" << lonStep << "; nLat=" << nLat
+                                                  << "; nLon=" << nLon << "; values=" << values.size ());
+      Clear ();
+      return false;
+    }
+
+  if (!std::is_sorted (depths.begin (), depths.end ()))
+    {
+      NS_LOG_ERROR ("depths are not in increasing order");
+      Clear ();
+      return false;
+    }
+
+  m_latMin = latMin;
+  m_lonMin = lonMin;
+  m_latStep = latStep;
+  m_lonStep = lonStep;
+  m_nLat = nLat;
+  m_nLon = nLon;
+  m_nLayers = nLayers;
+  m_depths = depths;
+  m_values = values;
+
+  return true;
+}
+
+bool
+WossGridField::Import (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  std::ifstream in (fileName, std::ios::binary);
+
+  if (!in.is_open ())
+    {
+      NS_LOG_ERROR ("can't open " << fileName);
+      Clear ();
+      return false;
+    }
+
+  char magic[sizeof (GRID_MAGIC)] = { 0 };
+  in.read (magic, sizeof (magic));
+  in.close ();
+
+  if (std::memcmp (magic, GRID_MAGIC, sizeof (GRID_MAGIC)) == 0)
+    {
+      return ImportBinary (fileName);
+    }
+
+  return ImportCsv (fileName);
+}
+
+bool
+WossGridField::ImportCsv (const std::string &fileName)
+{
+  std::ifstream in (fileName, std::ios::binary);
+  std::string text ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+
+  CsvReader reader (text);
+  double header[7];
+
+  for (int i = 0; i < 7; ++i)
+    {
+      if (reader.Next (header[i]) == false)
+        {
+          NS_LOG_ERROR (fileName << ": invalid header");
+          Clear ();
+          return false;
+        }
+    }
+
+  uint32_t nLat = 0;
+  uint32_t nLon = 0;
+  uint32_t nDepth = 0;
+
+  if (!ToCount (header[4], nLat) || !ToCount (header[5], nLon) || !ToCount (header[6], nDepth))
+    {
+      NS_LOG_ERROR (fileName << ": invalid grid size");
+      Clear ();
+      return false;
+    }
+
+  std::vector<double> depths (nDepth);
+
+  for (uint32_t i = 0; i < nDepth; ++i)
+    {
+      if (reader.Next (depths[i]) == false)
+        {
+          NS_LOG_ERROR (fileName << ": depth " << i << " missing");
+          Clear ();
+          return false;
+        }
+    }
+
+  uint64_t total = (uint64_t) nLat * nLon * std::max<uint32_t> (nDepth, 1);
+  std::vector<float> values;
+  // every value takes at least two characters, a bogus header can't trigger a huge allocation
+  values.reserve (std::min<uint64_t> (total, text.size () / 2 + 1));
+
+  for (uint64_t i = 0; i < total; ++i)
+    {
+      double value = 0.0;
+
+      if (reader.Next (value) == false)
+        {
+          NS_LOG_ERROR (fileName << ": value " << i << " of " << total << " missing or invalid");
+          Clear ();
+          return false;
+        }
+
+      values.push_back (value);
+    }
+
+  NS_LOG_DEBUG (fileName << ": nLat=" << nLat << "; nLon=" << nLon << "; nDepth=" << nDepth);
+
+  return SetGrid (header[0], header[1], header[2], header[3], nLat, nLon, depths, values);
+}
+
+bool
+WossGridField::ImportBinary (const std::string &fileName)
+{
+  std::ifstream in (fileName, std::ios::binary);
+  GridHeader header;
+
+  if (!in.read (reinterpret_cast<char *> (&header), sizeof (GridHeader)) || header.version != GRID_VERSION)
+    {
+      NS_LOG_ERROR (fileName << ": invalid header");
+      Clear ();
+      return false;
+    }
+
+  uint64_t total = (uint64_t) header.nLat * header.nLon * std::max<uint32_t> (header.nDepth, 1);
+
+  // the sizes are checked against the file size before allocating anything
+  in.seekg (0, std::ios::end);
+  uint64_t fileSize = in.tellg ();
+
+  if (fileSize != sizeof (GridHeader) + header.nDepth * sizeof (double) + total * sizeof (float))
+    {
+      NS_LOG_ERROR (fileName << ": file size doesn't match the grid size");
+      Clear ();
+      return false;
+    }
+
+  in.seekg (sizeof (GridHeader), std::ios::beg);
+
+  std::vector<double> depths (header.nDepth);
+  std::vector<float> values (total);
+
+  in.read (reinterpret_cast<char *> (depths.data ()), depths.size () * sizeof (double));
+  in.read (reinterpret_cast<char *> (values.data ()), values.size () * sizeof (float));
+
+  if (!in)
+    {
+      NS_LOG_ERROR (fileName << ": error while reading");
+      Clear ();
+      return false;
+    }
+
+  return SetGrid (header.latMin, header.lonMin, header.latStep, header.lonStep, header.nLat, header.nLon,
+                  depths, values);
+}
+
+bool
+WossGridField::SaveBinary (const std::string &fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  if (IsEmpty ())
+    {
+      NS_LOG_ERROR ("no field to save");
+      return false;
+    }
+
+  GridHeader header;
+  std::memset (&header, 0, sizeof (GridHeader));
+  std::memcpy (header.magic, GRID_MAGIC, sizeof (GRID_MAGIC));
+  header.version = GRID_VERSION;
+  header.nDepth = m_depths.size ();
+  header.nLat = m_nLat;
+  header.nLon = m_nLon;
+  header.latMin = m_latMin;
+  header.lonMin = m_lonMin;
+  header.latStep = m_latStep;
+  header.lonStep = m_lonStep;
+
+  std::ofstream out (fileName, std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open ())
+    {
+      NS_LOG_ERROR ("can't open " << fileName);
+      return false;
+    }
+
+  out.write (reinterpret_cast<const char *> (&header), sizeof (GridHeader));
+  out.write (reinterpret_cast<const char *> (m_depths.data ()), m_depths.size () * sizeof (double));
+  out.write (reinterpret_cast<const char *> (m_values.data ()), m_values.size () * sizeof (float));
+  out.close ();
+
+  if (out.fail ())
+    {
+      NS_LOG_ERROR ("error while writing " << fileName);
+      return false;
+    }
+
+  return true;
+}
+
+bool
+WossGridField::IsEmpty (void) const
+{
+  return m_values.empty ();
+}
+
+bool
+WossGridField::IsProfile (void) const
+{
+  return !m_depths.empty ();
+}
+
+const std::vector<double> &
+WossGridField::GetDepths (void) const
+{
+  return m_depths;
+}
+
+bool
+WossGridField::GetCell (const woss::Coord &coord, uint32_t (&nodes)[4], double (&weights)[4]) const
+{
+  if (IsEmpty ())
+    {
+      return false;
+    }
+
+  double latPos = (coord.getLatitude () - m_latMin) / m_latStep;
+  double lonPos = (coord.getLongitude () - m_lonMin) / m_lonStep;
+
+  // coordinates on the grid border are accepted despite the rounding of the division
+  const double tolerance = 1.0E-9;
+
+  if (!(latPos >= -tolerance) || !(lonPos >= -tolerance) || latPos > m_nLat - 1 + tolerance
+      || lonPos > m_nLon - 1 + tolerance)
+    {
+      return false;
+    }
+
+  latPos = std::min<double> (std::max (latPos, 0.0), m_nLat - 1);
+  lonPos = std::min<double> (std::max (lonPos, 0.0), m_nLon - 1);
+
+  // the last row and column belong to the previous cell
+  uint32_t latIdx = std::min<uint32_t> (latPos, m_nLat - 2);
+  uint32_t lonIdx = std::min<uint32_t> (lonPos, m_nLon - 2);
+  double latFrac = latPos - latIdx;
+  double lonFrac = lonPos - lonIdx;
+
+  nodes[0] = latIdx * m_nLon + lonIdx;
+  nodes[1] = nodes[0] + 1;
+  nodes[2] = nodes[0] + m_nLon;
+  nodes[3] = nodes[2] + 1;
+
+  weights[0] = (1.0 - latFrac) * (1.0 - lonFrac);
+  weights[1] = (1.0 - latFrac) * lonFrac;
+  weights[2] = latFrac * (1.0 - lonFrac);
+  weights[3] = latFrac * lonFrac;
+
+  return true;
+}
+
+double
+WossGridField::Interpolate (const uint32_t (&nodes)[4], const double (&weights)[4], uint32_t layer) const
+{
+  double sum = 0.0;
+  double weightSum = 0.0;
+
+  for (int i = 0; i < 4; ++i)
+    {
+      float value = m_values[(uint64_t) nodes[i] * m_nLayers + layer];
+
+      if (weights[i] > 0.0 && !std::isnan (value))
+        {
+          sum += weights[i] * value;
+          weightSum += weights[i];
+        }
+    }
+
+  return weightSum > 0.0 ? sum / weightSum : std::numeric_limits<double>::quiet_NaN ();
+}
+
+bool
+WossGridField::GetValue (const woss::Coord &coord, double &value) const
+{
+  uint32_t nodes[4];
+  double weights[4];
+
+  if (GetCell (coord, nodes, weights) == false)
+    {
+      return false;
+    }
+
+  value = Interpolate (nodes, weights, 0);
+
+  return !std::isnan (value);
+}
+
+bool
+WossGridField::GetProfile (const woss::Coord &coord, std::vector<double> &values) const
+{
+  uint32_t nodes[4];
+  double weights[4];
+
+  if (IsProfile () == false || GetCell (coord, nodes, weights) == false)
+    {
+      return false;
+    }
+
+  values.resize (m_nLayers);
+  bool isValid = false;
+
+  for (uint32_t layer = 0; layer < m_nLayers; ++layer)
+    {
+      values[layer] = Interpolate (nodes, weights, layer);
+      isValid = isValid || !std::isnan (values[layer]);
+    }
+
+  return isValid;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
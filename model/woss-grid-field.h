@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_GRID_FIELD_H
+#define WOSS_GRID_FIELD_H
+
+#include <string>
+#include <vector>
+#include <coordinates-definitions.h>
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossGridField
+ * \brief Gridded environmental field over a regular latitude / longitude grid
+ *
+ * A 2-D field (e.g. bathymetry) holds one value per grid node, a 3-D field (e.g. SSP) holds one value
+ * per grid node and per depth, all the nodes sharing the same depths.
+ * Values are bilinearly interpolated between the four grid nodes surrounding the queried coordinates,
+ * so any transect can be sampled at any range. NaN values mark missing data and are excluded from the
+ * interpolation, the weights of the remaining nodes being renormalized.
+ *
+ * Fields can be imported from a CSV text grid or from a binary raster written by SaveBinary.
+ * The CSV grid starts with the header
+ * \verbatim latMin, lonMin, latStep, lonStep, nLat, nLon, nDepth \endverbatim
+ * followed, if nDepth > 0, by the nDepth depths [m], and then by the nLat * nLon * max(nDepth, 1) values,
+ * south to north, west to east and top to bottom. Commas, spaces, tabs and newlines are all valid separators,
+ * "nan" marks a missing value and lines starting with '#' are comments. 2-D fields have nDepth = 0.
+ * The binary raster holds the same data in native byte order, and is meant to be used on the same architecture.
+ */
+class WossGridField
+{
+public:
+  WossGridField (); //!< Default constructor
+
+  /**
+   * Imports a field, the format (CSV or binary) is detected from the file content
+   * \param fileName the file name
+   * \returns true on success, on failure the field is left empty
+   */
+  bool Import (const std::string &fileName);
+
+  /**
+   * Writes the field as a binary raster
+   * \param fileName the file name
+   * \returns true on success
+   */
+  bool SaveBinary (const std::string &fileName) const;
+
+  /**
+   * Sets the grid and all the values
+   * \param latMin latitude of the southernmost nodes [dec degrees]
+   * \param lonMin longitude of the westernmost nodes [dec degrees]
+   * \param latStep latitude spacing of the nodes [dec degrees]
+   * \param lonStep longitude spacing of the nodes [dec degrees]
+   * \param nLat number of nodes along the latitude
+   * \param nLon number of nodes along the longitude
+   * \param depths the depths of a 3-D field [m], empty for a 2-D field
+   * \param values the nLat * nLon * max(depths.size (), 1) values
+   * \returns true if the grid and the values are consistent
+   */
+  bool SetGrid (double latMin, double lonMin, double latStep, double lonStep, uint32_t nLat, uint32_t nLon,
+                const std::vector<double> &depths, const std::vector<float> &values);
+
+  /**
+   * \returns true if the field holds no data
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \returns true if the field is a 3-D field
+   */
+  bool IsProfile (void) const;
+
+  /**
+   * \returns the depths of a 3-D field [m]
+   */
+  const std::vector<double> &GetDepths (void) const;
+
+  /**
+   * Interpolates a 2-D field, or the first depth of a 3-D field
+   * \param coord the geographic coordinates
+   * \param value the interpolated value
+   * \returns false if coord is outside the grid or no surrounding node is valid
+   */
+  bool GetValue (const woss::Coord &coord, double &value) const;
+
+  /**
+   * Interpolates all the depths of a 3-D field
+   * \param coord the geographic coordinates
+   * \param values one interpolated value per depth, NaN where no surrounding node is valid
+   * \returns false if coord is outside the grid or no value is valid
+   */
+  bool GetProfile (const woss::Coord &coord, std::vector<double> &values) const;
+
+private:
+  /**
+   * Finds the grid cell and the bilinear weights of the four surrounding nodes
+   * \param coord the geographic coordinates
+   * \param nodes the indexes of the four nodes
+   * \param weights the weights of the four nodes
+   * \returns false if coord is outside the grid
+   */
+  bool GetCell (const woss::Coord &coord, uint32_t (&nodes)[4], double (&weights)[4]) const;
+
+  /**
+   * \param nodes the indexes of the four nodes
+   * \param weights the weights of the four nodes
+   * \param layer the depth index
+   * \returns the interpolated value, NaN if no node is valid
+   */
+  double Interpolate (const uint32_t (&nodes)[4], const double (&weights)[4], uint32_t layer) const;
+
+  /**
+   * \param fileName the file name
+   * \returns true on success
+   */
+  bool ImportCsv (const std::string &fileName);
+
+  /**
+   * \param fileName the file name
+   * \returns true on success
+   */
+  bool ImportBinary (const std::string &fileName);
+
+  /**
+   * Frees all the data
+   */
+  void Clear (void);
+
+  double m_latMin; //!< latitude of the southernmost nodes [dec degrees]
+  double m_lonMin; //!< longitude of the westernmost nodes [dec degrees]
+  double m_latStep; //!< latitude spacing of the nodes [dec degrees]
+  double m_lonStep; //!< longitude spacing of the nodes [dec degrees]
+  uint32_t m_nLat; //!< number of nodes along the latitude
+  uint32_t m_nLon; //!< number of nodes along the longitude
+  uint32_t m_nLayers; //!< number of values per node
+  std::vector<double> m_depths; //!< depths of a 3-D field [m]
+  std::vector<float> m_values; //!< values, node major
+};
+
+/**
+ * Converts a text token into a double with std::strtod on a bounded, NUL terminated copy, so that the
+ * token needs no terminator and floating point std::from_chars (GCC >= 11) is not required.
+ * A leading '+' is accepted, leading blanks are not.
+ * \param begin first character of the token
+ * \param end one past the last character of the token
+ * \param value the converted number
+ * \returns true if the whole token is a valid number in the double range
+ */
+bool WossParseDouble (const char *begin, const char *end, double &value);
+
+}
+
+#endif /* WOSS_GRID_FIELD_H */
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,278 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "woss-pdp-kernel.h"
+
+
+#define WOSS_PDP_KERNEL_MIN_PURGE_SIZE (64)
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossPdpKernel");
+
+WossPdpKernel::WossPdpKernel ()
+  : m_delays (),
+    m_cumEnergy (1, 0.0),
+    m_spacing (0.0),
+    m_maxTapDelay (0),
+    m_anchorDelay (0),
+    m_anchorIndex (0)
+{
+}
+
+WossPdpKernel::WossPdpKernel (const UanPdp &pdp)
+  : WossPdpKernel (pdp, pdp.GetNTaps () > 0 ? pdp.GetBegin ()->GetDelay () : Seconds (0.0))
+{
+}
+
+WossPdpKernel::WossPdpKernel (const UanPdp &pdp, Time anchorDelay)
+  : m_delays (),
+    m_cumEnergy (),
+    m_spacing (0.0),
+    m_maxTapDelay (0),
+    m_anchorDelay (anchorDelay.GetTimeStep ()),
+    m_anchorIndex (0)
+{
+  NS_LOG_FUNCTION (this << pdp.GetNTaps ());
+
+  m_delays.reserve (pdp.GetNTaps ());
+  m_cumEnergy.reserve (pdp.GetNTaps () + 1);
+  m_cumEnergy.push_back (0.0);
+
+  double maxEnergy = -1.0;
+
+  for (UanPdp::Iterator it = pdp.GetBegin (); it != pdp.GetEnd (); ++it)
+    {
+      int64_t delay = it->GetDelay ().GetTimeStep ();
+      double energy = std::norm (it->GetAmp ());
+
+      NS_ASSERT_MSG (m_delays.empty () || delay >= m_delays.back (), "PDP taps not sorted by delay");
+
+      if (energy > maxEnergy)
+        {
+          maxEnergy = energy;
+          m_maxTapDelay = delay;
+        }
+
+      m_delays.push_back (delay);
+      m_cumEnergy.push_back (m_cumEnergy.back () + energy);
+    }
+
+  if (m_delays.size () > 1)
+    {
+      m_spacing = (double) (m_delays.back () - m_delays.front ()) / (m_delays.size () - 1);
+
+      // the delays of a dense PDP are rounded to the time resolution, so they are one step off at most
+      for (size_t i = 0; i < m_delays.size (); ++i)
+        {
+          if (std::abs (m_delays[i] - m_delays.front () - i * m_spacing) > 1.0)
+            {
+              m_spacing = 0.0;
+              break;
+            }
+        }
+    }
+
+  m_anchorIndex = GetTapIndex (m_anchorDelay);
+
+  NS_LOG_DEBUG ("taps: " << m_delays.size () << "; evenly spaced: " << (m_spacing > 0.0)
+                         << "; anchor tap: " << m_anchorIndex);
+}
+
+double
+WossPdpKernel::GetTotalEnergy (void) const
+{
+  return m_cumEnergy.back ();
+}
+
+Time
+WossPdpKernel::GetFirstDelay (void) const
+{
+  return m_delays.empty () ? Seconds (0.0) : TimeStep (m_delays.front ());
+}
+
+Time
+WossPdpKernel::GetAnchorDelay (void) const
+{
+  return TimeStep (m_anchorDelay);
+}
+
+double
+WossPdpKernel::GetAnchorEnergy (void) const
+{
+  return m_cumEnergy.back () - m_cumEnergy[m_anchorIndex];
+}
+
+Time
+WossPdpKernel::GetMaxTapDelay (void) const
+{
+  return TimeStep (m_maxTapDelay);
+}
+
+size_t
+WossPdpKernel::GetTapIndex (int64_t delay) const
+{
+  if (m_delays.empty () || delay <= m_delays.front ())
+    {
+      return 0;
+    }
+
+  if (delay > m_delays.back ())
+    {
+      return m_delays.size ();
+    }
+
+  if (m_spacing > 0.0)
+    {
+      // the estimate is at most one tap off
+      size_t index = std::min<size_t> (std::ceil ((delay - m_delays.front ()) / m_spacing), m_delays.size () - 1);
+
+      while ( (index > 0) && (m_delays[index - 1] >= delay) )
+        {
+          --index;
+        }
+
+      while ( (index < m_delays.size ()) && (m_delays[index] < delay) )
+        {
+          ++index;
+        }
+
+      return index;
+    }
+
+  return std::lower_bound (m_delays.begin (), m_delays.end (), delay) - m_delays.begin ();
+}
+
+double
+WossPdpKernel::GetWindowEnergy (Time start, Time end) const
+{
+  if (end <= start)
+    {
+      return 0.0;
+    }
+
+  return m_cumEnergy[GetTapIndex (end.GetTimeStep ())] - m_cumEnergy[GetTapIndex (start.GetTimeStep ())];
+}
+
+WossPdpKernelRegistry::EntryMap &
+WossPdpKernelRegistry::GetEntries (void)
+{
+  static EntryMap entries;
+
+  return entries;
+}
+
+size_t &
+WossPdpKernelRegistry::GetPurgeSize (void)
+{
+  static size_t purgeSize = WOSS_PDP_KERNEL_MIN_PURGE_SIZE;
+
+  return purgeSize;
+}
+
+bool &
+WossPdpKernelRegistry::GetClearScheduled (void)
+{
+  static bool clearScheduled = false;
+
+  return clearScheduled;
+}
+
+void
+WossPdpKernelRegistry::Publish (Ptr<Packet> packet, ConstKernelPtr kernel)
+{
+  EntryMap &entries = GetEntries ();
+
+  if (!GetClearScheduled ())
+    {
+      // the entries hold packets, they must not outlive the simulation
+      Simulator::ScheduleDestroy (&WossPdpKernelRegistry::Clear);
+      GetClearScheduled () = true;
+    }
+
+  // purges are amortized: the next one runs when the surviving entries have doubled
+  if (entries.size () >= GetPurgeSize ())
+    {
+      Purge ();
+
+      GetPurgeSize () = std::max<size_t> (2 * entries.size (), WOSS_PDP_KERNEL_MIN_PURGE_SIZE);
+    }
+
+  entries[PeekPointer (packet)] = Entry { packet, kernel };
+}
+
+WossPdpKernelRegistry::ConstKernelPtr
+WossPdpKernelRegistry::Lookup (Ptr<const Packet> packet)
+{
+  const EntryMap &entries = GetEntries ();
+  EntryMap::const_iterator it = entries.find (PeekPointer (packet));
+
+  if (it == entries.end ())
+    {
+      return nullptr;
+    }
+
+  return it->second.kernel;
+}
+
+void
+WossPdpKernelRegistry::Purge (void)
+{
+  EntryMap &entries = GetEntries ();
+
+  for (EntryMap::iterator it = entries.begin (); it != entries.end (); )
+    {
+      if (it->second.packet->GetReferenceCount () == 1)
+        {
+          it = entries.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+
+  NS_LOG_DEBUG ("entries after purge: " << entries.size ());
+}
+
+void
+WossPdpKernelRegistry::Clear (void)
+{
+  GetEntries ().clear ();
+  GetPurgeSize () = WOSS_PDP_KERNEL_MIN_PURGE_SIZE;
+  GetClearScheduled () = false;
+}
+
+uint32_t
+WossPdpKernelRegistry::GetSize (void)
+{
+  return GetEntries ().size ();
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
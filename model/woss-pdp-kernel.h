@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_PDP_KERNEL_H
+#define WOSS_PDP_KERNEL_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "ns3/packet.h"
+#include "ns3/uan-prop-model.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossPdpKernel
+ * \brief Cumulative tap energy of a UanPdp, for window energy lookups without tap walks
+ *
+ * The kernel holds the prefix sums of the tap energies, so the energy of the taps within any delay window
+ * is the difference of two prefix sums. The window bounds are found in O(1) if the taps are evenly spaced
+ * (dense PDPs), otherwise by binary search (e.g. sparse PDPs).
+ */
+class WossPdpKernel
+{
+public:
+  WossPdpKernel (); //!< Default constructor, empty kernel
+
+  /**
+   * The anchor tap is the first tap
+   * \param pdp the power delay profile, taps sorted by delay
+   */
+  WossPdpKernel (const UanPdp &pdp);
+
+  /**
+   * \param pdp the power delay profile, taps sorted by delay
+   * \param anchorDelay delay of the tap received at the arrival time, see GetAnchorDelay
+   */
+  WossPdpKernel (const UanPdp &pdp, Time anchorDelay);
+
+  /**
+   * \returns the energy of all the taps
+   */
+  double GetTotalEnergy (void) const;
+
+  /**
+   * \returns the delay of the first tap
+   */
+  Time GetFirstDelay (void) const;
+
+  /**
+   * The WossChannel delivers a reception at the delay of its first usable tap, and sums the received power
+   * from that tap on. Kernels built without it anchor on the first tap.
+   * \returns the delay of the anchor tap
+   */
+  Time GetAnchorDelay (void) const;
+
+  /**
+   * \returns the energy of the taps from the anchor tap on
+   */
+  double GetAnchorEnergy (void) const;
+
+  /**
+   * \returns the delay of the strongest tap
+   */
+  Time GetMaxTapDelay (void) const;
+
+  /**
+   * \param start window start delay, included
+   * \param end window end delay, excluded
+   * \returns the energy of the taps within the window
+   */
+  double GetWindowEnergy (Time start, Time end) const;
+
+private:
+  /**
+   * \param delay the delay
+   * \returns the index of the first tap not earlier than delay
+   */
+  size_t GetTapIndex (int64_t delay) const;
+
+  std::vector<int64_t> m_delays; //!< tap delays [time steps]
+  std::vector<double> m_cumEnergy; //!< tap energy prefix sums, m_cumEnergy[i] is the energy of the first i taps
+  double m_spacing; //!< mean tap spacing of evenly spaced taps [time steps], zero if the taps are not evenly spaced
+  int64_t m_maxTapDelay; //!< delay of the strongest tap [time steps]
+  int64_t m_anchorDelay; //!< delay of the anchor tap [time steps]
+  size_t m_anchorIndex; //!< index of the anchor tap
+};
+
+/**
+ * \ingroup WOSS
+ * \class WossPdpKernelRegistry
+ * \brief Kernels of the receptions in flight, published by the WossChannel and read by the SINR models
+ *
+ * The UanPhy receive path carries the PDP by value, so kernels are published next to it, keyed by the packet
+ * copy of each reception: the same Packet object travels from the channel to the SINR model of the receiver,
+ * both as the received packet and inside the arrival list.
+ * An entry is purged once the registry holds the last reference to its packet, and the registry is cleared
+ * by Simulator::Destroy, so no packet outlives the simulation.
+ */
+class WossPdpKernelRegistry
+{
+public:
+  typedef std::shared_ptr<const WossPdpKernel> ConstKernelPtr; //!< immutable kernel shared by the receptions
+
+  /**
+   * \param packet the packet copy of the reception
+   * \param kernel the kernel of the reception PDP
+   */
+  static void Publish (Ptr<Packet> packet, ConstKernelPtr kernel);
+
+  /**
+   * \param packet the packet copy of the reception
+   * \returns the kernel of the reception, null if none was published
+   */
+  static ConstKernelPtr Lookup (Ptr<const Packet> packet);
+
+  /**
+   * Removes the entries whose packet is no longer referenced outside the registry
+   */
+  static void Purge (void);
+
+  /**
+   * Removes all the entries
+   */
+  static void Clear (void);
+
+  /**
+   * \returns the number of entries
+   */
+  static uint32_t GetSize (void);
+
+private:
+  /**
+   * A published kernel
+   */
+  struct Entry
+  {
+    Ptr<Packet> packet; //!< the packet, referenced until the entry is purged
+    ConstKernelPtr kernel; //!< the kernel
+  };
+
+  typedef std::unordered_map<const Packet*, Entry> EntryMap; //!< map of the entries, keyed by packet
+
+  /**
+   * \returns the registry entries
+   */
+  static EntryMap &GetEntries (void);
+
+  /**
+   * \returns the registry size that triggers the next purge
+   */
+  static size_t &GetPurgeSize (void);
+
+  /**
+   * \returns true if Clear is scheduled at Simulator::Destroy
+   */
+  static bool &GetClearScheduled (void);
+};
+
+}
+
+#endif /* WOSS_PDP_KERNEL_H */
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <algorithm>
+#include <complex>
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "woss-phy-calc-sinr.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossPhyCalcSinr");
+
+NS_OBJECT_ENSURE_REGISTERED (WossPhyCalcSinr);
+
+WossPhyCalcSinr::WossPhyCalcSinr ()
+  : m_eqWindow (Seconds (0.0)),
+    m_intOverlap (false)
+{
+}
+
+TypeId
+WossPhyCalcSinr::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WossPhyCalcSinr")
+    .SetParent<UanPhyCalcSinr> ()
+    .SetGroupName ("Woss")
+    .AddConstructor<WossPhyCalcSinr> ()
+    .AddAttribute ("EqualizerWindow",
+                   "Taps within this window from the strongest tap are useful signal, the other ones are ISI. \
+                   Zero if all the taps are useful signal",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&WossPhyCalcSinr::m_eqWindow),
+                   MakeTimeChecker (Seconds (0.0)) )
+    .AddAttribute ("InterferenceOverlap",
+                   "If true, an interfering packet only contributes the energy of its taps that overlap the reception \
+                   in time. If false, it contributes all its received power",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WossPhyCalcSinr::m_intOverlap),
+                   MakeBooleanChecker () )
+  ;
+  return tid;
+}
+
+WossPdpKernelRegistry::ConstKernelPtr
+WossPhyCalcSinr::GetKernel (Ptr<const Packet> packet, const UanPdp &pdp) const
+{
+  WossPdpKernelRegistry::ConstKernelPtr kernel = WossPdpKernelRegistry::Lookup (packet);
+
+  if (kernel == nullptr)
+    {
+      // no kernel published by the channel, one tap walk
+      kernel = std::make_shared<const WossPdpKernel> (pdp);
+    }
+
+  return kernel;
+}
+
+double
+WossPhyCalcSinr::GetUsefulPowerFraction (const WossPdpKernel &kernel) const
+{
+  // the received power is summed from the anchor tap on
+  double anchorEnergy = kernel.GetAnchorEnergy ();
+
+  if (anchorEnergy <= 0.0)
+    {
+      return 1.0;
+    }
+
+  Time windowStart = std::max (kernel.GetMaxTapDelay (), kernel.GetAnchorDelay ());
+
+  return kernel.GetWindowEnergy (windowStart, windowStart + m_eqWindow) / anchorEnergy;
+}
+
+double
+WossPhyCalcSinr::CalcSinrDb (Ptr<Packet> pkt, Time arrTime, double rxPowerDb, double ambNoiseDb, UanTxMode mode,
+                             UanPdp pdp, const UanTransducer::ArrivalList &arrivalList) const
+{
+  double rxPowerKp = DbToKp (rxPowerDb);
+  double usefulFraction = 1.0;
+
+  if (m_eqWindow.IsStrictlyPositive ())
+    {
+      usefulFraction = GetUsefulPowerFraction (*GetKernel (pkt, pdp));
+    }
+
+  double intKp = DbToKp (ambNoiseDb) + rxPowerKp * (1.0 - usefulFraction);
+  Time duration = Seconds (pkt->GetSize () * 8.0 / mode.GetDataRateBps ());
+
+  for (UanTransducer::ArrivalList::const_iterator it = arrivalList.begin (); it != arrivalList.end (); ++it)
+    {
+      if (PeekPointer (it->GetPacket ()) == PeekPointer (pkt))
+        {
+          continue;
+        }
+
+      double overlapFraction = 1.0;
+
+      if (m_intOverlap)
+        {
+          WossPdpKernelRegistry::ConstKernelPtr intKernel = GetKernel (it->GetPacket (), it->GetPdp ());
+          // the interferer power is summed from its anchor tap on, the earlier taps are not counted
+          double anchorEnergy = intKernel->GetAnchorEnergy ();
+
+          if (anchorEnergy > 0.0)
+            {
+              Time intDuration = Seconds (it->GetPacket ()->GetSize () * 8.0 / it->GetTxMode ().GetDataRateBps ());
+              Time anchorDelay = intKernel->GetAnchorDelay ();
+              // the interferer arrival time matches its anchor tap
+              Time offset = anchorDelay - it->GetArrivalTime ();
+              Time windowStart = std::max (arrTime - intDuration + offset, anchorDelay);
+
+              // a tap at delay d is received in [arrival + d - anchor delay, + intDuration)
+              overlapFraction = intKernel->GetWindowEnergy (windowStart, arrTime + duration + offset) / anchorEnergy;
+            }
+        }
+
+      intKp += DbToKp (it->GetRxPowerDb ()) * overlapFraction;
+    }
+
+  double sinrDb = KpToDb (rxPowerKp * usefulFraction) - KpToDb (intKp);
+
+  NS_LOG_DEBUG ("rxPowerDb: " << rxPowerDb << "; useful fraction: " << usefulFraction << "; taps: " << pdp.GetNTaps ()
+                              << "; interferers: " << arrivalList.size () << "; sinrDb: " << sinrDb);
+
+  return sinrDb;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_PHY_CALC_SINR_H
+#define WOSS_PHY_CALC_SINR_H
+
+#include "ns3/uan-phy.h"
+#include "ns3/nstime.h"
+#include "woss-pdp-kernel.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossPhyCalcSinr
+ * \brief SINR model that reads the tap delays of the PDP, so it works with both dense and sparse PDPs
+ *
+ * The taps of the received PDP within "EqualizerWindow" from the strongest tap are useful signal,
+ * the other ones are self interference (ISI). The interference of the other packets is the sum of their
+ * received powers, as in UanPhyCalcSinrDefault. With a zero window all the taps are useful signal,
+ * and the model matches UanPhyCalcSinrDefault.
+ * Taps are selected by delay instead of by index, so the PDPs built with the WossPropModel "SparsePdp"
+ * attribute, holding only the non zero taps, give the same SINR of the dense ones, at a fraction of the cost.
+ *
+ * With "InterferenceOverlap" set, an interfering packet only contributes the energy of its taps that overlap
+ * the reception in time, given the durations of the two packets. The interferer arrival time is the one of its
+ * anchor tap (see WossPdpKernel::GetAnchorDelay), and only the taps from the anchor on, the ones summed in the
+ * received power, are counted; the same holds for the useful signal of the reception.
+ * Tap energies are read from the WossPdpKernel published by the WossChannel "PdpKernels" attribute, so every
+ * window costs a lookup instead of a tap walk; kernels are built on the fly for the receptions without one.
+ */
+class WossPhyCalcSinr : public UanPhyCalcSinr
+{
+public:
+  WossPhyCalcSinr (); //!< Default constructor
+
+  virtual ~WossPhyCalcSinr () = default; //!< Default destructor
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  virtual double CalcSinrDb (Ptr<Packet> pkt, Time arrTime, double rxPowerDb, double ambNoiseDb, UanTxMode mode,
+                             UanPdp pdp, const UanTransducer::ArrivalList &arrivalList) const override;
+
+private:
+  /**
+   * \param packet the packet of the reception
+   * \param pdp the power delay profile of the reception
+   * \returns the kernel published for the reception, or a kernel built from pdp
+   */
+  WossPdpKernelRegistry::ConstKernelPtr GetKernel (Ptr<const Packet> packet, const UanPdp &pdp) const;
+
+  /**
+   * \param kernel the kernel of the reception
+   * \returns the fraction of the PDP power, from the anchor tap on, within the equalizer window
+   */
+  double GetUsefulPowerFraction (const WossPdpKernel &kernel) const;
+
+  Time m_eqWindow; //!< equalizer window, starting at the strongest tap, zero if all the taps are useful
+
+  bool m_intOverlap; //!< if true interferers only contribute the energy of the taps overlapping the reception
+};
+
+}
+
+#endif /* WOSS_PHY_CALC_SINR_H */
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -27,14 +27,76 @@
 #include "ns3/log.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
+#include "ns3/abort.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <thread>
 
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("WossPositionAllocator");
 
+namespace {
+
+/**
+ * Runs func (begin, end) over [0, count), split in contiguous ranges across threads
+ * \param count number of items
+ * \param threads number of threads, 0 or 1 for the calling thread only
+ * \param func function processing the range [begin, end)
+ */
+template <typename F>
+void
+ParallelRanges (uint32_t count, uint32_t threads, F func)
+{
+  // below this size the thread start up costs more than the conversions
+  const uint32_t minItemsPerThread = 1024;
+
+  threads = std::max<uint32_t> (1, std::min<uint32_t> (threads, count / minItemsPerThread));
+
+  if (threads <= 1)
+    {
+      func (0, count);
+      return;
+    }
+
+  std::vector<std::thread> workers;
+  workers.reserve (threads - 1);
+
+  uint32_t chunk = (count + threads - 1) / threads;
+
+  for (uint32_t i = 1; i < threads; ++i)
+    {
+      uint32_t begin = std::min (count, i * chunk);
+      uint32_t end = std::min (count, begin + chunk);
+
+      workers.emplace_back (func, begin, end);
+    }
+
+  func (0, std::min (count, chunk));
+
+  for (auto &worker : workers)
+    {
+      worker.join ();
+    }
+}
+
+/**
+ * \param coordZ geographic coordinates
+ * \returns the WGS84 cartesian coordinates
+ */
+Vector
+ConvertToVector (const woss::CoordZ &coordZ)
+{
+  woss::CoordZ::CartCoords cartCoords = coordZ.getCartCoords (woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  return Vector (cartCoords.getX (), cartCoords.getY (), cartCoords.getZ ());
+}
+
+} // namespace
+
 NS_OBJECT_ENSURE_REGISTERED (WossListPositionAllocator);
 
 TypeId
@@ -65,12 +127,47 @@ WossListPositionAllocator::Add (const woss::CoordZ &coords)
   m_listAllocator.Add (Vector (currCartCoords.getX (), currCartCoords.getY (), currCartCoords.getZ ()) );
 }
 
+void
+WossListPositionAllocator::Add (const std::vector<woss::CoordZ> &coords, uint32_t threads)
+{
+  NS_LOG_FUNCTION (this << coords.size () << threads);
+
+  std::vector<Vector> positions (coords.size ());
+
+  ParallelRanges (coords.size (), threads, [&coords, &positions] (uint32_t begin, uint32_t end)
+    {
+      for (uint32_t i = begin; i < end; ++i)
+        {
+          positions[i] = ConvertToVector (coords[i]);
+        }
+    });
+
+  for (const Vector &position : positions)
+    {
+      m_listAllocator.Add (position);
+    }
+}
+
 Vector
 WossListPositionAllocator::GetNext (void) const
 {
   return m_listAllocator.GetNext ();
 }
 
+std::vector<Vector>
+WossListPositionAllocator::GetNextN (uint32_t count) const
+{
+  std::vector<Vector> retVal;
+  retVal.reserve (count);
+
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      retVal.push_back (m_listAllocator.GetNext ());
+    }
+
+  return retVal;
+}
+
 int64_t
 WossListPositionAllocator::AssignStreams (int64_t stream)
 {
@@ -264,6 +361,82 @@ WossGridPositionAllocator::GetNext (void) const
   return Vector (currCartCoords.getX (), currCartCoords.getY (), currCartCoords.getZ ());
 }
 
+woss::CoordZ
+WossGridPositionAllocator::GetCoordZ (uint32_t index, uint32_t &line, woss::Coord &lineStart, double &lineCoord) const
+{
+  if (index == 0)
+    {
+      return woss::CoordZ (m_LatMin, m_LonMin, m_Depth);
+    }
+
+  woss::Coord originCoord (m_LatMin, m_LonMin);
+  uint32_t currLine = index / m_n;
+  double lat = m_LatMin, lon = m_LonMin;
+
+  // same computations of GetNext, the ones depending only on the line are done once per line
+  switch (m_layoutType)
+    {
+
+    case ROW_FIRST:
+      if (currLine != line)
+        {
+          lat = woss::Coord::getCoordFromBearing (originCoord, 0.0, (m_DeltaLat * currLine), m_Depth).getLatitude ();
+          lineStart = woss::Coord (lat, m_LonMin);
+          lineCoord = woss::Coord::getCoordFromBearing (lineStart, M_PI / 2.0, (m_DeltaLat * currLine), m_Depth).getLatitude ();
+          line = currLine;
+        }
+
+      lat = lineCoord;
+      lon = woss::Coord::getCoordFromBearing (lineStart, M_PI / 2.0, (m_DeltaLon * (index % m_n)), m_Depth).getLongitude ();
+
+      break;
+
+    case COLUMN_FIRST:
+      if (currLine != line)
+        {
+          lon = woss::Coord::getCoordFromBearing (originCoord, M_PI / 2.0, (m_DeltaLat * currLine), m_Depth).getLongitude ();
+          lineStart = woss::Coord (m_LatMin, lon);
+          lineCoord = woss::Coord::getCoordFromBearing (lineStart, 0.0, (m_DeltaLon * currLine), m_Depth).getLongitude ();
+          line = currLine;
+        }
+
+      lat = woss::Coord::getCoordFromBearing (lineStart, 0.0, (m_DeltaLat * (index % m_n)), m_Depth).getLatitude ();
+      lon = lineCoord;
+
+      break;
+
+    }
+
+  return woss::CoordZ (lat, lon, m_Depth);
+}
+
+std::vector<Vector>
+WossGridPositionAllocator::GetNextN (uint32_t count, uint32_t threads) const
+{
+  NS_LOG_FUNCTION (this << count << threads);
+
+  NS_ASSERT (m_n > 0);
+
+  std::vector<Vector> retVal (count);
+  const uint32_t first = m_current;
+
+  ParallelRanges (count, threads, [this, first, &retVal] (uint32_t begin, uint32_t end)
+    {
+      uint32_t line = std::numeric_limits<uint32_t>::max ();
+      woss::Coord lineStart;
+      double lineCoord = 0.0;
+
+      for (uint32_t i = begin; i < end; ++i)
+        {
+          retVal[i] = ConvertToVector (GetCoordZ (first + i, line, lineStart, lineCoord));
+        }
+    });
+
+  m_current += count;
+
+  return retVal;
+}
+
 int64_t
 WossGridPositionAllocator::AssignStreams (int64_t stream)
 {
@@ -627,6 +800,207 @@ WossUniformDiscPositionAllocator::AssignStreams (int64_t stream)
   return 2;
 }
 
+NS_OBJECT_ENSURE_REGISTERED (WossBathymetryPositionAllocator);
+
+TypeId
+WossBathymetryPositionAllocator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WossBathymetryPositionAllocator")
+    .SetParent<PositionAllocator> ()
+    .SetGroupName ("Woss")
+    .AddConstructor<WossBathymetryPositionAllocator> ()
+    .AddAttribute ("InnerAllocator",
+                   "The position allocator providing the horizontal positions.",
+                   PointerValue (),
+                   MakePointerAccessor (&WossBathymetryPositionAllocator::m_innerAllocator),
+                   MakePointerChecker<PositionAllocator> ())
+    .AddAttribute ("Altitude",
+                   "A random variable which represents the altitude above the seafloor [m]. Positive values only",
+                   StringValue ("ns3::UniformRandomVariable[Min=1.0|Max=10.0]"),
+                   MakePointerAccessor (&WossBathymetryPositionAllocator::m_altitude),
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("MinDepth", "Positions shallower than this depth are rejected [m].",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&WossBathymetryPositionAllocator::m_minDepth),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("TileSize", "Size of the cached seafloor depth tiles [dec degrees]. "
+                   "The default matches the GEBCO 15 arc-second grid.",
+                   DoubleValue (1.0 / 240.0),
+                   MakeDoubleAccessor (&WossBathymetryPositionAllocator::m_tileSize),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MaxRetries", "Maximum number of rejected positions per allocation.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&WossBathymetryPositionAllocator::m_maxRetries),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+WossBathymetryPositionAllocator::WossBathymetryPositionAllocator ()
+  : m_bathymetryCallback (),
+    m_innerAllocator (),
+    m_altitude (),
+    m_minDepth (1.0),
+    m_tileSize (1.0 / 240.0),
+    m_maxRetries (1000),
+    m_tileMap (),
+    m_rejectedCount (0)
+{
+}
+
+void
+WossBathymetryPositionAllocator::DoDispose (void)
+{
+  m_bathymetryCallback = BathymetryCallback ();
+  m_innerAllocator = nullptr;
+  m_altitude = nullptr;
+  m_tileMap.clear ();
+
+  PositionAllocator::DoDispose ();
+}
+
+void
+WossBathymetryPositionAllocator::SetBathymetryCallback (BathymetryCallback callback)
+{
+  m_bathymetryCallback = callback;
+  m_tileMap.clear ();
+}
+
+void
+WossBathymetryPositionAllocator::SetInnerAllocator (Ptr<PositionAllocator> allocator)
+{
+  m_innerAllocator = allocator;
+}
+
+void
+WossBathymetryPositionAllocator::SetAltitude (Ptr<RandomVariableStream> altitude)
+{
+  m_altitude = altitude;
+}
+
+void
+WossBathymetryPositionAllocator::ClearTileCache (void)
+{
+  m_tileMap.clear ();
+}
+
+uint32_t
+WossBathymetryPositionAllocator::GetTileCacheSize (void) const
+{
+  return m_tileMap.size ();
+}
+
+uint32_t
+WossBathymetryPositionAllocator::GetRejectedCount (void) const
+{
+  return m_rejectedCount;
+}
+
+double
+WossBathymetryPositionAllocator::GetSeafloorDepth (const woss::Coord &coord) const
+{
+  TileKey key (static_cast<int64_t> (std::floor (coord.getLatitude () / m_tileSize)),
+               static_cast<int64_t> (std::floor (coord.getLongitude () / m_tileSize)));
+
+  TileMap::const_iterator it = m_tileMap.find (key);
+
+  if (it != m_tileMap.end ())
+    {
+      return it->second;
+    }
+
+  // the tile keeps the deepest seafloor among its center and corners: a coastal tile is rejected only
+  // when all its samples are on land, otherwise the positions inside it are checked one by one
+  double depth = -std::numeric_limits<double>::infinity ();
+
+  for (const auto &offset : { std::make_pair (0.5, 0.5), std::make_pair (0.0, 0.0), std::make_pair (0.0, 1.0),
+                              std::make_pair (1.0, 0.0), std::make_pair (1.0, 1.0) })
+    {
+      woss::Coord sample ((key.first + offset.first) * m_tileSize, (key.second + offset.second) * m_tileSize);
+      double sampleDepth = m_bathymetryCallback (sample);
+
+      if (std::isfinite (sampleDepth))
+        {
+          depth = std::max (depth, sampleDepth);
+        }
+    }
+
+  NS_LOG_DEBUG ("new tile=" << key.first << "," << key.second << "; max seafloor depth=" << depth);
+
+  m_tileMap.insert (std::make_pair (key, depth));
+
+  return depth;
+}
+
+Vector
+WossBathymetryPositionAllocator::GetNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ABORT_MSG_IF (m_bathymetryCallback.IsNull (), "WossBathymetryPositionAllocator: bathymetry callback not set");
+  NS_ABORT_MSG_IF (m_innerAllocator == nullptr, "WossBathymetryPositionAllocator: inner allocator not set");
+
+  for (uint32_t retry = 0; retry < m_maxRetries; ++retry)
+    {
+      Vector position = m_innerAllocator->GetNext ();
+
+      woss::CoordZ innerCoordz = woss::CoordZ::getCoordZFromCartesianCoords (position.x, position.y, position.z,
+                                                                             woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+      double tileDepth = GetSeafloorDepth (innerCoordz);
+
+      // land tile or missing data: the position is rejected without querying the bathymetry again
+      if (!std::isfinite (tileDepth) || tileDepth <= m_minDepth)
+        {
+          NS_LOG_DEBUG ("rejected position=" << innerCoordz << "; tile seafloor depth=" << tileDepth);
+          m_rejectedCount++;
+          continue;
+        }
+
+      // the tile depth is only a screen, the position is checked against the seafloor at the position
+      double seafloorDepth = m_bathymetryCallback (innerCoordz);
+
+      if (!std::isfinite (seafloorDepth) || seafloorDepth <= m_minDepth)
+        {
+          NS_LOG_DEBUG ("rejected position=" << innerCoordz << "; seafloor depth=" << seafloorDepth);
+          m_rejectedCount++;
+          continue;
+        }
+
+      double depth = seafloorDepth - std::abs (m_altitude->GetValue ());
+
+      if (depth < m_minDepth)
+        {
+          NS_LOG_DEBUG ("rejected position=" << innerCoordz << "; depth=" << depth);
+          m_rejectedCount++;
+          continue;
+        }
+
+      woss::CoordZ coordz (innerCoordz.getLatitude (), innerCoordz.getLongitude (), depth);
+
+      NS_LOG_DEBUG ("position=" << coordz << "; seafloor depth=" << seafloorDepth);
+
+      return ConvertToVector (coordz);
+    }
+
+  NS_FATAL_ERROR ("WossBathymetryPositionAllocator: no valid position found after " << m_maxRetries << " retries");
+
+  return Vector ();
+}
+
+int64_t
+WossBathymetryPositionAllocator::AssignStreams (int64_t stream)
+{
+  m_altitude->SetStream (stream);
+
+  if (m_innerAllocator == nullptr)
+    {
+      return 1;
+    }
+
+  return 1 + m_innerAllocator->AssignStreams (stream + 1);
+}
+
 } // namespace ns3
 
 #endif /* NS3_WOSS_SUPPORT */
@@ -23,7 +23,10 @@
 #ifndef WOSS_POSITION_ALLOCATOR_H
 #define WOSS_POSITION_ALLOCATOR_H
 
+#include <map>
+#include <vector>
 #include <coordinates-definitions.h>
+#include "ns3/callback.h"
 #include "ns3/position-allocator.h"
 #include "ns3/random-variable-stream.h"
 
@@ -55,11 +58,25 @@ public:
    */
   void Add (const woss::CoordZ &coords);
 
+  /**
+   * Add a list of geographic coordinates, the WGS84 conversions are split across threads
+   *
+   * \param coords positions in geographic coordinates (decimal degrees)
+   * \param threads number of conversion threads, 0 or 1 for the calling thread only
+   */
+  void Add (const std::vector<woss::CoordZ> &coords, uint32_t threads = 1);
+
   /**
    * \returns the Vector position in cartesian coordinates
    */
   virtual Vector GetNext (void) const override;
 
+  /**
+   * \param count number of positions
+   * \returns the next count positions in cartesian coordinates, as GetNext would return them
+   */
+  std::vector<Vector> GetNextN (uint32_t count) const;
+
   virtual int64_t AssignStreams (int64_t stream) override;
 
 protected:
@@ -175,9 +192,32 @@ public:
    */
   virtual Vector GetNext (void) const override;
 
+  /**
+   * Bulk version of GetNext. The row (or column) start coordinates are computed once
+   * per row (or column) instead of once per position, and the positions can be
+   * computed by several threads. The result is identical to count GetNext calls.
+   *
+   * \param count number of positions
+   * \param threads number of threads, 0 or 1 for the calling thread only
+   * \returns the next count positions in cartesian coordinates
+   */
+  std::vector<Vector> GetNextN (uint32_t count, uint32_t threads = 1) const;
+
   virtual int64_t AssignStreams (int64_t stream) override;
 
 protected:
+  /**
+   * Computes the geographic coordinates of a grid index. The line (row or column) dependent
+   * coordinates are cached in the given arguments, and recomputed only if the line changes
+   *
+   * \param index grid index
+   * \param line cached line index, UINT32_MAX if not valid
+   * \param lineStart cached line start coordinates
+   * \param lineCoord cached line dependent coordinate (latitude for ROW_FIRST, longitude for COLUMN_FIRST)
+   * \returns the geographic coordinates
+   */
+  woss::CoordZ GetCoordZ (uint32_t index, uint32_t &line, woss::Coord &lineStart, double &lineCoord) const;
+
   mutable uint32_t m_current; //!<
   enum LayoutType m_layoutType; //!< layout type
   double m_LatMin; //!< minimum latitude in decimal degrees
@@ -417,6 +457,100 @@ private:
   Ptr<UniformRandomVariable> m_RangeVar;  //!< random variable that generates a range in meters
 };
 
+/**
+ * \ingroup uan
+ *
+ * \brief WossBathymetryPositionAllocator allocates positions at a random altitude above the seafloor
+ *
+ * The horizontal position is taken from an inner position allocator (e.g. WossRandomRectanglePositionAllocator,
+ * WossRandomDiscPositionAllocator or WossUniformDiscPositionAllocator), the depth of the inner position is discarded.
+ * The seafloor depth is read through a bathymetry callback (e.g. WossHelper::GetBathymetry, which queries
+ * the configured bathymetry database or custom bathymetry). The deepest seafloor among the center and the corners
+ * of each tile of TileSize decimal degrees is cached and screens out the tiles with all samples on land without a
+ * callback per position; in any other tile, coastal ones included, the seafloor depth is read at the actual
+ * position, which is accepted or rejected on it and gives the altitude, so that nodes stay above the seafloor on slopes.
+ * Positions on land, or whose depth would be shallower than MinDepth, are rejected and drawn again,
+ * so that no channel computation is wasted on positions below the seafloor.
+ */
+class WossBathymetryPositionAllocator : public PositionAllocator
+{
+public:
+  /**
+   * Bathymetry callback, it returns the seafloor depth in meters at the given coordinates.
+   * Non positive or non finite values mark land or missing data.
+   */
+  typedef Callback<double, const woss::Coord &> BathymetryCallback;
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  WossBathymetryPositionAllocator (); //!< Default constructor
+
+  virtual ~WossBathymetryPositionAllocator () = default; //!< Default destructor
+
+  /**
+   * \param callback the bathymetry callback
+   */
+  void SetBathymetryCallback (BathymetryCallback callback);
+
+  /**
+   * \param allocator the allocator providing the horizontal positions
+   */
+  void SetInnerAllocator (Ptr<PositionAllocator> allocator);
+
+  /**
+   * \param altitude the random variable must return the altitude above the seafloor in meters (positive values)
+   */
+  void SetAltitude (Ptr<RandomVariableStream> altitude);
+
+  /**
+   * Clears the cached seafloor depth tiles, e.g. after the bathymetry has been changed
+   */
+  void ClearTileCache (void);
+
+  /**
+   * \returns the number of cached seafloor depth tiles
+   */
+  uint32_t GetTileCacheSize (void) const;
+
+  /**
+   * \returns the number of rejected positions since creation
+   */
+  uint32_t GetRejectedCount (void) const;
+
+  /**
+   * \returns the position in cartesian coordinates
+   */
+  virtual Vector GetNext (void) const override;
+
+  virtual int64_t AssignStreams (int64_t stream) override;
+
+protected:
+  virtual void DoDispose (void) override;
+
+  /**
+   * \param coord the geographic coordinates
+   * \returns the deepest seafloor among the center and the corners of the tile containing coord, in meters,
+   * minus infinity if all of them are on land or missing
+   */
+  double GetSeafloorDepth (const woss::Coord &coord) const;
+
+  typedef std::pair<int64_t, int64_t> TileKey; //!< tile indexes (latitude, longitude)
+  typedef std::map<TileKey, double> TileMap; //!< deepest sampled seafloor depth of each tile
+
+  BathymetryCallback m_bathymetryCallback; //!< the bathymetry callback
+  Ptr<PositionAllocator> m_innerAllocator; //!< allocator of the horizontal positions
+  Ptr<RandomVariableStream> m_altitude; //!< random variable that generates the altitude above the seafloor in meters
+  double m_minDepth; //!< minimum accepted depth in meters
+  double m_tileSize; //!< tile size in decimal degrees
+  uint32_t m_maxRetries; //!< maximum number of rejected positions per GetNext call
+  mutable TileMap m_tileMap; //!< seafloor depth tile cache
+  mutable uint32_t m_rejectedCount; //!< number of rejected positions
+};
+
 }
 
 #endif /* WOSS_POSITION_ALLOCATOR_H */
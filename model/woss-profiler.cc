@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "woss-profiler.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossProfiler");
+
+NS_OBJECT_ENSURE_REGISTERED (WossProfiler);
+
+TypeId
+WossProfiler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::WossProfiler")
+    .SetParent<Object> ()
+    .SetGroupName ("Woss")
+    .AddConstructor<WossProfiler> ()
+    .AddAttribute ("OutputFile",
+                   "If not empty, all the statistics are written in JSON format to this file at Simulator::Destroy ()",
+                   StringValue (""),
+                   MakeStringAccessor (&WossProfiler::SetOutputFile, &WossProfiler::GetOutputFile),
+                   MakeStringChecker () )
+  ;
+  return tid;
+}
+
+WossProfiler::WossProfiler ()
+  : m_stats (),
+    m_outputFile (""),
+    m_outputScheduled (false)
+{
+  Reset ();
+}
+
+double
+WossProfiler::GetWallTime (void)
+{
+  return std::chrono::duration<double> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+std::string
+WossProfiler::GetStageName (Stage stage)
+{
+  switch (stage)
+    {
+    case TIME_ARR_RETRIEVAL:
+      return "TimeArrRetrieval";
+    case COHERENT_SUM:
+      return "CoherentSum";
+    case PDP_CREATION:
+      return "PdpCreation";
+    case PDP_NORMALIZATION:
+      return "PdpNormalization";
+    case TX_SCHEDULING:
+      return "TxScheduling";
+    default:
+      break;
+    }
+
+  return "Unknown";
+}
+
+void
+WossProfiler::Record (Stage stage, double latency, uint32_t items)
+{
+  NS_ASSERT (stage < STAGE_TOTAL);
+
+  StageStats &stats = m_stats[stage];
+
+  stats.count++;
+  stats.items += items;
+  stats.totalTime += latency;
+
+  if (latency > stats.maxTime)
+    {
+      stats.maxTime = latency;
+    }
+
+  uint32_t bin = 0;
+  double latencyNs = latency * 1.0E9;
+
+  if (latencyNs >= 1.0)
+    {
+      bin = std::min (static_cast<uint32_t> (std::log2 (latencyNs)), HISTOGRAM_BINS - 1);
+    }
+
+  stats.histogram[bin]++;
+}
+
+uint64_t
+WossProfiler::GetCount (Stage stage) const
+{
+  return m_stats[stage].count;
+}
+
+uint64_t
+WossProfiler::GetItems (Stage stage) const
+{
+  return m_stats[stage].items;
+}
+
+double
+WossProfiler::GetTotalTime (Stage stage) const
+{
+  return m_stats[stage].totalTime;
+}
+
+void
+WossProfiler::Reset (void)
+{
+  for (auto &stats : m_stats)
+    {
+      stats.count = 0;
+      stats.items = 0;
+      stats.totalTime = 0.0;
+      stats.maxTime = 0.0;
+      stats.histogram.fill (0);
+    }
+}
+
+void
+WossProfiler::WriteJson (std::ostream &os) const
+{
+  os << "{\n  \"stages\": [\n";
+
+  for (uint32_t i = 0; i < STAGE_TOTAL; ++i)
+    {
+      const StageStats &stats = m_stats[i];
+
+      os << "    {\"name\": \"" << GetStageName (static_cast<Stage> (i)) << "\""
+         << ", \"count\": " << stats.count
+         << ", \"items\": " << stats.items
+         << ", \"total_s\": " << stats.totalTime
+         << ", \"mean_s\": " << (stats.count > 0 ? stats.totalTime / stats.count : 0.0)
+         << ", \"max_s\": " << stats.maxTime
+         << ", \"histogram_log2_ns\": [";
+
+      for (uint32_t bin = 0; bin < HISTOGRAM_BINS; ++bin)
+        {
+          os << (bin > 0 ? ", " : "") << stats.histogram[bin];
+        }
+
+      os << "]}" << (i + 1 < STAGE_TOTAL ? "," : "") << "\n";
+    }
+
+  os << "  ]\n}\n";
+}
+
+void
+WossProfiler::SetOutputFile (const std::string &fileName)
+{
+  m_outputFile = fileName;
+
+  if (m_outputFile != "" && m_outputScheduled == false)
+    {
+      Simulator::ScheduleDestroy (&WossProfiler::WriteOutputFile, Ptr<WossProfiler> (this));
+      m_outputScheduled = true;
+    }
+}
+
+std::string
+WossProfiler::GetOutputFile (void) const
+{
+  return m_outputFile;
+}
+
+void
+WossProfiler::WriteOutputFile (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // the destroy event is consumed, a run after Simulator::Destroy needs a new one
+  m_outputScheduled = false;
+
+  if (m_outputFile == "")
+    {
+      return;
+    }
+
+  std::ofstream outFile (m_outputFile);
+
+  if (!outFile.is_open ())
+    {
+      NS_LOG_ERROR ("can't open profiler output file " << m_outputFile);
+      return;
+    }
+
+  WriteJson (outFile);
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_PROFILER_H
+#define WOSS_PROFILER_H
+
+#include <array>
+#include <string>
+#include <ostream>
+#include "ns3/object.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossProfiler
+ * \brief Per-stage counters and latency histograms of the WOSS integration layer
+ *
+ * A WossProfiler object can be plugged into a WossPropModel (and through it into the WossChannel)
+ * via the "Profiler" attribute. Every stage of the channel computation records its wall clock
+ * latency and the number of processed items (links, taps, receivers).
+ * Latencies are accumulated in log2 histograms with nanoseconds resolution.
+ * If the "OutputFile" attribute is set, all statistics are written in JSON format at Simulator::Destroy ().
+ */
+class WossProfiler : public Object
+{
+public:
+  /**
+   * Profiled stages
+   */
+  enum Stage
+  {
+    TIME_ARR_RETRIEVAL = 0, //!< woss::WossManager time arrival request (channel simulator runs, .arr parsing and result database I/O)
+    COHERENT_SUM, //!< woss::TimeArr::coherentSumSample
+    PDP_CREATION, //!< conversion of the coherent sum into a UanPdp
+    PDP_NORMALIZATION, //!< UanPdp::NormalizeToSumNc
+    TX_SCHEDULING, //!< WossChannel::TxPacket reception power, delay computation and event scheduling (PDP_NORMALIZATION included)
+    STAGE_TOTAL //!< number of stages
+  };
+
+  static const uint32_t HISTOGRAM_BINS = 40; //!< number of log2 latency bins, bin i counts latencies in [2^i, 2^(i+1)) ns
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  WossProfiler (); //!< Default constructor
+
+  virtual ~WossProfiler () = default; //!< Default destructor
+
+  /**
+   * \returns a monotonic wall clock time in seconds, to be used as stage start time
+   */
+  static double GetWallTime (void);
+
+  /**
+   * \param stage the stage
+   * \returns the stage name
+   */
+  static std::string GetStageName (Stage stage);
+
+  /**
+   * Records a stage execution
+   * \param stage the stage
+   * \param latency the stage wall clock latency in seconds
+   * \param items number of items processed by the stage
+   */
+  void Record (Stage stage, double latency, uint32_t items = 1);
+
+  /**
+   * \param stage the stage
+   * \returns the number of executions of the given stage
+   */
+  uint64_t GetCount (Stage stage) const;
+
+  /**
+   * \param stage the stage
+   * \returns the number of items processed by the given stage
+   */
+  uint64_t GetItems (Stage stage) const;
+
+  /**
+   * \param stage the stage
+   * \returns the total wall clock time spent in the given stage [s]
+   */
+  double GetTotalTime (Stage stage) const;
+
+  /**
+   * Clears all statistics
+   */
+  void Reset (void);
+
+  /**
+   * Writes all statistics in JSON format
+   * \param os the output stream
+   */
+  void WriteJson (std::ostream &os) const;
+
+  /**
+   * Sets the JSON output file. The file is written at Simulator::Destroy ()
+   * \param fileName the output file path
+   */
+  void SetOutputFile (const std::string &fileName);
+
+  /**
+   * \returns the JSON output file path
+   */
+  std::string GetOutputFile (void) const;
+
+private:
+  /**
+   * Statistics of a single stage
+   */
+  struct StageStats
+  {
+    uint64_t count; //!< number of executions
+    uint64_t items; //!< number of processed items
+    double totalTime; //!< total latency [s]
+    double maxTime; //!< maximum latency [s]
+    std::array<uint64_t, HISTOGRAM_BINS> histogram; //!< log2 latency histogram [ns]
+  };
+
+  void WriteOutputFile (void); //!< writes the JSON statistics to m_outputFile, a new output can be scheduled afterwards
+
+  std::array<StageStats, STAGE_TOTAL> m_stats; //!< per-stage statistics
+  std::string m_outputFile; //!< JSON output file path, empty = no output
+  bool m_outputScheduled; //!< true if the output has been scheduled at the next Simulator::Destroy ()
+};
+
+}
+
+#endif /* WOSS_PROFILER_H */
+
+#endif /* NS3_WOSS_SUPPORT */
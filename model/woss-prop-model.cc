@@ -20,11 +20,18 @@
 
 #ifdef NS3_WOSS_SUPPORT
 
+#include <algorithm>
+#include <cmath>
 #include "ns3/woss-prop-model.h"
 #include "ns3/uan-tx-mode.h"
 #include "ns3/mobility-model.h"
+#include "ns3/woss-geo-waypoint-mobility-model.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 #include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/trace-source-accessor.h"
 
 
 
@@ -36,9 +43,73 @@ NS_LOG_COMPONENT_DEFINE ("WossPropModel");
 
 NS_OBJECT_ENSURE_REGISTERED (WossPropModel);
 
+namespace {
+
+/**
+ * Thorp absorption, as in UanPropModelThorp
+ * \param freqKhz frequency [kHz]
+ * \returns the absorption [dB/km]
+ */
+double
+GetThorpAttenDbKm (double freqKhz)
+{
+  double fsq = freqKhz * freqKhz;
+  double attenDbKyd = 0.0;
+
+  if (freqKhz >= 0.4)
+    {
+      attenDbKyd = 0.11 * fsq / (1 + fsq) + 44 * fsq / (4100 + fsq) + 2.75 * 0.0001 * fsq + 0.003;
+    }
+  else
+    {
+      attenDbKyd = 0.002 + 0.11 * (freqKhz / (1 + freqKhz)) + 0.011 * freqKhz;
+    }
+
+  return attenDbKyd / 0.9144;
+}
+
+/**
+ * \param a geographical coordinates
+ * \param b geographical coordinates
+ * \returns the cartesian distance [m], as MobilityModel::GetDistanceFrom
+ */
+double
+GetCartesianDistance (const woss::CoordZ &a, const woss::CoordZ &b)
+{
+  woss::CoordZ::CartCoords aCart = a.getCartCoords (woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+  woss::CoordZ::CartCoords bCart = b.getCartCoords (woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  return CalculateDistance (Vector (aCart.getX (), aCart.getY (), aCart.getZ ()),
+                            Vector (bCart.getX (), bCart.getY (), bCart.getZ ()));
+}
+
+} // namespace
+
+#define WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE (64)
+
 WossPropModel::WossPropModel ()
   : m_wossManager (nullptr),
-    m_memOptimization (false)
+    m_coordZCache (),
+    m_coordZPurgeSize (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE),
+    m_coordZConversions (0),
+    m_widebandCache (),
+    m_linkPurgeSize (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE),
+    m_freqResponseCache (),
+    m_freqResponsePurgeSize (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE),
+    m_freqResponse (false),
+    m_sparsePdp (false),
+    m_truncEnergyFraction (0.0),
+    m_truncDelayWindow (Seconds (0.0)),
+    m_pdpTruncationTrace (),
+    m_widebandStartFreq (0.0),
+    m_widebandEndFreq (0.0),
+    m_timeEvolution (false),
+    m_evolutionQuantum (0.0),
+    m_profiler (nullptr),
+    m_stageLatencyTrace (),
+    m_memOptimization (false),
+    m_coordzPairBuffer (),
+    m_tapBuffer ()
 {
 }
 
@@ -56,6 +127,56 @@ WossPropModel::GetTypeId (void)
                BooleanValue (false),
                MakeBooleanAccessor (&WossPropModel::m_memOptimization),
                MakeBooleanChecker () )
+    .AddAttribute ("Profiler",
+               "Optional WossProfiler object that collects per-stage counters and latency histograms. \
+               If not set, profiling is disabled",
+               PointerValue (),
+               MakePointerAccessor (&WossPropModel::m_profiler),
+               MakePointerChecker<WossProfiler> () )
+    .AddAttribute ("WidebandStartFreq",
+               "Start frequency [Hz] of the wideband mode. The band is computed once per link and shared by all \
+               the modes with a carrier inside it. Wideband is disabled if not lower than WidebandEndFreq",
+               DoubleValue (0.0),
+               MakeDoubleAccessor (&WossPropModel::m_widebandStartFreq),
+               MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("WidebandEndFreq",
+               "End frequency [Hz] of the wideband mode",
+               DoubleValue (0.0),
+               MakeDoubleAccessor (&WossPropModel::m_widebandEndFreq),
+               MakeDoubleChecker<double> (0.0) )
+    .AddAttribute ("FreqResponse",
+               "If true, the frequency response of every link is built from the arrivals of its last PDP \
+               and cached, see GetFreqResponse",
+               BooleanValue (false),
+               MakeBooleanAccessor (&WossPropModel::m_freqResponse),
+               MakeBooleanChecker () )
+    .AddAttribute ("SparsePdp",
+               "If true, the PDPs hold only the non zero taps, each one with its own delay, instead of one tap \
+               per symbol time between the first and the last arrival. Use it with a SINR model that reads the \
+               tap delays, e.g. WossPhyCalcSinr",
+               BooleanValue (false),
+               MakeBooleanAccessor (&WossPropModel::m_sparsePdp),
+               MakeBooleanChecker () )
+    .AddAttribute ("TruncationEnergyFraction",
+               "The last taps of a PDP, in delay order, are removed as long as their cumulative energy is within \
+               this fraction of the PDP energy. Zero disables the energy truncation",
+               DoubleValue (0.0),
+               MakeDoubleAccessor (&WossPropModel::m_truncEnergyFraction),
+               MakeDoubleChecker<double> (0.0, 1.0) )
+    .AddAttribute ("TruncationDelayWindow",
+               "The taps of a PDP later than this window from the first usable tap are removed. \
+               Zero disables the delay truncation",
+               TimeValue (Seconds (0.0)),
+               MakeTimeAccessor (&WossPropModel::m_truncDelayWindow),
+               MakeTimeChecker (Seconds (0.0)) )
+    .AddTraceSource ("StageLatency",
+               "Wall clock latency of a WOSS integration stage (see WossProfiler::Stage)",
+               MakeTraceSourceAccessor (&WossPropModel::m_stageLatencyTrace),
+               "ns3::WossPropModel::StageLatencyTracedCallback")
+    .AddTraceSource ("PdpTruncation",
+               "Taps before and after a PDP truncation, and the fraction of the PDP energy removed",
+               MakeTraceSourceAccessor (&WossPropModel::m_pdpTruncationTrace),
+               "ns3::WossPropModel::PdpTruncationTracedCallback")
   ;
   return tid;
 }
@@ -72,6 +193,119 @@ WossPropModel::GetWossManager (void)
   return m_wossManager;
 }
 
+void
+WossPropModel::SetTimeEvolution (bool active, double quantum)
+{
+  m_timeEvolution = active;
+  m_evolutionQuantum = quantum;
+  m_widebandCache.clear ();
+}
+
+int64_t
+WossPropModel::GetEvolutionSlot (void) const
+{
+  if (m_timeEvolution == false)
+    {
+      return 0;
+    }
+
+  if (m_evolutionQuantum > 0.0)
+    {
+      return (int64_t) std::floor (Simulator::Now ().GetSeconds () / m_evolutionQuantum);
+    }
+
+  // the environment evolves at every simulation time
+  return Simulator::Now ().GetTimeStep ();
+}
+
+void
+WossPropModel::PurgeReleasedModels (void)
+{
+  // a model is released if all its references are held by the caches
+  std::map<const MobilityModel*, uint32_t> cacheRefs;
+
+  for (const auto &entry : m_coordZCache)
+    {
+      ++cacheRefs[PeekPointer (entry.first)];
+    }
+
+  for (const auto &entry : m_widebandCache)
+    {
+      ++cacheRefs[PeekPointer (entry.first.first)];
+      ++cacheRefs[PeekPointer (entry.first.second)];
+    }
+
+  for (const auto &entry : m_freqResponseCache)
+    {
+      ++cacheRefs[PeekPointer (std::get<0> (entry.first))];
+      ++cacheRefs[PeekPointer (std::get<1> (entry.first))];
+    }
+
+  std::set<const MobilityModel*> released;
+
+  for (const auto &ref : cacheRefs)
+    {
+      if (ref.first->GetReferenceCount () == ref.second)
+        {
+          released.insert (ref.first);
+        }
+    }
+
+  if (released.empty ())
+    {
+      return;
+    }
+
+  for (auto it = m_coordZCache.begin (); it != m_coordZCache.end (); )
+    {
+      it = released.count (PeekPointer (it->first)) ? m_coordZCache.erase (it) : std::next (it);
+    }
+
+  for (auto it = m_widebandCache.begin (); it != m_widebandCache.end (); )
+    {
+      bool isReleased = released.count (PeekPointer (it->first.first)) || released.count (PeekPointer (it->first.second));
+
+      it = isReleased ? m_widebandCache.erase (it) : std::next (it);
+    }
+
+  for (auto it = m_freqResponseCache.begin (); it != m_freqResponseCache.end (); )
+    {
+      bool isReleased = released.count (PeekPointer (std::get<0> (it->first)))
+        || released.count (PeekPointer (std::get<1> (it->first)));
+
+      it = isReleased ? m_freqResponseCache.erase (it) : std::next (it);
+    }
+
+  NS_LOG_DEBUG ("released models: " << released.size () << "; coordZ cache: " << m_coordZCache.size ()
+                                    << "; wideband cache: " << m_widebandCache.size ()
+                                    << "; response cache: " << m_freqResponseCache.size ());
+}
+
+Ptr<WossProfiler>
+WossPropModel::GetProfiler (void) const
+{
+  return m_profiler;
+}
+
+bool
+WossPropModel::IsProfiling (void) const
+{
+  return (m_profiler != nullptr) || (!m_stageLatencyTrace.IsEmpty ());
+}
+
+void
+WossPropModel::RecordStage (WossProfiler::Stage stage, double startTime, uint32_t items)
+{
+  double latency = WossProfiler::GetWallTime () - startTime;
+
+  if (m_profiler != nullptr)
+    {
+      m_profiler->Record (stage, latency, items);
+    }
+
+  m_stageLatencyTrace (stage, Seconds (latency), items);
+}
+
 void
 WossPropModel::DoInitialize (void)
 {
@@ -82,6 +316,25 @@ WossPropModel::DoInitialize (void)
   UanPropModel::DoInitialize ();
 }
 
+void
+WossPropModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_coordZCache.clear ();
+  m_coordZPurgeSize = WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE;
+  m_coordZConversions = 0;
+  m_widebandCache.clear ();
+  m_linkPurgeSize = WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE;
+  m_freqResponseCache.clear ();
+  m_freqResponsePurgeSize = WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE;
+  m_coordzPairBuffer = woss::CoordZPairVect ();
+  m_tapBuffer = std::vector< Tap > ();
+  m_profiler = nullptr;
+
+  UanPropModelThorp::DoDispose ();
+}
+
 
 double
 WossPropModel::GetPathLossDb (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode mode)
@@ -96,6 +349,22 @@ WossPropModel::GetPdp (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode mod
 {
   NS_LOG_FUNCTION (this);
 
+  if (IsWideband (mode))
+    {
+      MobModelVector rxs (1, b);
+      std::shared_ptr<const woss::TimeArr> timeArr = GetWidebandTimeArr (a, rxs).front ();
+      double gain = GetWidebandGain (mode, a->GetDistanceFrom (b));
+
+      UanPdp pdp = CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr->clone ()), (1.0 / mode.GetPhyRateSps ()), gain);
+
+      if (m_memOptimization)
+        {
+          m_wossManager->reset ();
+        }
+
+      return pdp;
+    }
+
   woss::CoordZ txCoordz = CreateCoordZ (a);
   woss::CoordZ rxCoorz = CreateCoordZ (b);
   double startFreq = mode.GetCenterFreqHz ();
@@ -103,12 +372,22 @@ WossPropModel::GetPdp (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode mod
 
   NS_LOG_DEBUG ("txCoordz: " << txCoordz << "; rxCoorz: " << rxCoorz << "; startFreq: " << startFreq << "; endFreq: " << endFreq);
 
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
   auto currTimeArr = m_wossManager->getWossTimeArr (txCoordz, rxCoorz, startFreq, endFreq);
 
+  if (profiling)
+    {
+      RecordStage (WossProfiler::TIME_ARR_RETRIEVAL, startTime, 1);
+    }
+
   NS_ASSERT ( currTimeArr != NULL );
 
   NS_LOG_DEBUG ("timeArr: " << *currTimeArr);
 
+  StoreFreqResponse (a, b, *currTimeArr, startFreq, 1.0);
+
   UanPdp pdp = CreateUanPdp (std::move (currTimeArr), (1.0 / mode.GetPhyRateSps ()));
   
   if (m_memOptimization)
@@ -126,18 +405,60 @@ WossPropModel::GetDelay (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode m
 }
 
 WossPropModel::UanPdpVector
-WossPropModel::GetPdpVector (Ptr<MobilityModel> a, MobModelVector& b, UanTxMode mode)
+WossPropModel::GetPdpVector (Ptr<MobilityModel> a, MobModelVector& b, UanTxMode mode, double ampThres)
 {
   NS_LOG_FUNCTION (this);
 
-  woss::CoordZPairVect coordzPairVector = CreateCoordzPairVector (a, b);
+  if (IsWideband (mode))
+    {
+      std::vector< std::shared_ptr<const woss::TimeArr> > timeArrs = GetWidebandTimeArr (a, b);
+      UanPdpVector pdpVector;
+
+      pdpVector.reserve (timeArrs.size ());
+
+      for (size_t i = 0; i < timeArrs.size (); ++i)
+        {
+          double gain = GetWidebandGain (mode, a->GetDistanceFrom (b[i]));
+
+          pdpVector.push_back (CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArrs[i]->clone ()),
+                                             (1.0 / mode.GetPhyRateSps ()), gain, ampThres));
+        }
+
+      if (m_memOptimization)
+        {
+          m_wossManager->reset ();
+        }
+
+      return pdpVector;
+    }
+
+  const woss::CoordZPairVect &coordzPairVector = CreateCoordzPairVector (a, b);
   double startFreq = mode.GetCenterFreqHz ();
   double endFreq = startFreq;
 
   NS_LOG_DEBUG ("coordzPairVector size: " << coordzPairVector.size () << "; startFreq: " << startFreq << "; endFreq: " << endFreq);
 
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
   woss::TimeArrVector timeArrVect = m_wossManager->getWossTimeArr (coordzPairVector, startFreq, endFreq);
-  UanPdpVector pdpVector = CreateUanPdpVector (timeArrVect, (1.0 / mode.GetPhyRateSps ()));
+
+  if (profiling)
+    {
+      RecordStage (WossProfiler::TIME_ARR_RETRIEVAL, startTime, coordzPairVector.size ());
+    }
+
+  if (m_freqResponse)
+    {
+      for (size_t i = 0; i < timeArrVect.size (); ++i)
+        {
+          NS_ASSERT (timeArrVect[i] != NULL);
+
+          StoreFreqResponse (a, b[i], *timeArrVect[i], startFreq, 1.0);
+        }
+    }
+
+  UanPdpVector pdpVector = CreateUanPdpVector (timeArrVect, (1.0 / mode.GetPhyRateSps ()), ampThres);
   
   if (m_memOptimization)
   {
@@ -147,20 +468,183 @@ WossPropModel::GetPdpVector (Ptr<MobilityModel> a, MobModelVector& b, UanTxMode
   return pdpVector;   
 }
 
+void
+WossPropModel::StoreFreqResponse (Ptr<MobilityModel> a, Ptr<MobilityModel> b, const woss::TimeArr &timeArr,
+                                  double carrierFreq, double gain)
+{
+  if (m_freqResponse == false)
+    {
+      return;
+    }
+
+  // the cache holds a reference to its keys, the entries of released models are dropped here
+  if (m_freqResponseCache.size () >= m_freqResponsePurgeSize)
+    {
+      PurgeReleasedModels ();
+
+      m_freqResponsePurgeSize = std::max<size_t> (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE, 2 * m_freqResponseCache.size ());
+    }
+
+  m_freqResponseCache[FreqResponseKey (a, b, carrierFreq)]
+    = FreqResponseCacheEntry { a->GetPosition (), b->GetPosition (), WossFreqResponse (timeArr, carrierFreq, gain) };
+}
+
+bool
+WossPropModel::GetFreqResponse (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode mode,
+                                WossFreqResponse &response) const
+{
+  // same carrier of StoreFreqResponse
+  double carrierFreq = IsWideband (mode) ? (m_widebandStartFreq + m_widebandEndFreq) / 2.0 : mode.GetCenterFreqHz ();
+  auto it = m_freqResponseCache.find (FreqResponseKey (a, b, carrierFreq));
+
+  if (it == m_freqResponseCache.end () || it->second.txPosition != a->GetPosition ()
+      || it->second.rxPosition != b->GetPosition ())
+    {
+      return false;
+    }
+
+  response = it->second.response;
+
+  return true;
+}
+
+uint64_t
+WossPropModel::GetCoordZConversions (void) const
+{
+  return m_coordZConversions;
+}
+
+uint32_t
+WossPropModel::GetCoordZCacheSize (void) const
+{
+  return m_coordZCache.size ();
+}
+
+bool
+WossPropModel::IsWideband (UanTxMode mode) const
+{
+  double carrier = mode.GetCenterFreqHz ();
+
+  return (m_widebandStartFreq < m_widebandEndFreq) && (carrier >= m_widebandStartFreq) && (carrier <= m_widebandEndFreq);
+}
+
+double
+WossPropModel::GetWidebandGain (UanTxMode mode, double range) const
+{
+  double refFreqKhz = (m_widebandStartFreq + m_widebandEndFreq) / 2.0 / 1000.0;
+  double modeFreqKhz = mode.GetCenterFreqHz () / 1000.0;
+
+  // the spreading loss doesn't depend on the frequency, only the absorption differs
+  double deltaDb = (GetThorpAttenDbKm (modeFreqKhz) - GetThorpAttenDbKm (refFreqKhz)) * range / 1000.0;
+
+  return std::pow (10.0, -deltaDb / 20.0);
+}
+
+std::vector< std::shared_ptr<const woss::TimeArr> >
+WossPropModel::GetWidebandTimeArr (Ptr<MobilityModel> tx, MobModelVector& rxs)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::vector< std::shared_ptr<const woss::TimeArr> > retVal (rxs.size ());
+  woss::CoordZPairVect &missingPairs = m_coordzPairBuffer;
+  std::vector<size_t> missingIndexes;
+
+  Vector txPosition = tx->GetPosition ();
+  woss::CoordZ txCoordZ = CreateCoordZ (tx);
+  int64_t evolutionSlot = GetEvolutionSlot ();
+
+  missingPairs.clear ();
+
+  for (size_t i = 0; i < rxs.size (); ++i)
+    {
+      auto it = m_widebandCache.find (LinkKey (tx, rxs[i]));
+
+      // with time evolution the arrivals of a static link change with the evolution slot
+      if (it != m_widebandCache.end () && it->second.txPosition == txPosition
+          && it->second.rxPosition == rxs[i]->GetPosition () && it->second.evolutionSlot == evolutionSlot)
+        {
+          retVal[i] = it->second.timeArr;
+        }
+      else
+        {
+          missingPairs.push_back (std::make_pair (txCoordZ, CreateCoordZ (rxs[i])));
+          missingIndexes.push_back (i);
+        }
+    }
+
+  NS_LOG_DEBUG ("links: " << rxs.size () << "; missing from cache: " << missingPairs.size ()
+                          << "; startFreq: " << m_widebandStartFreq << "; endFreq: " << m_widebandEndFreq);
+
+  if (missingPairs.empty ())
+    {
+      return retVal;
+    }
+
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
+  woss::TimeArrVector timeArrVect = m_wossManager->getWossTimeArr (missingPairs, m_widebandStartFreq, m_widebandEndFreq);
+
+  if (profiling)
+    {
+      RecordStage (WossProfiler::TIME_ARR_RETRIEVAL, startTime, missingPairs.size ());
+    }
+
+  NS_ASSERT (timeArrVect.size () == missingPairs.size ());
+
+  // the cache holds a reference to its keys, the entries of released models are dropped here
+  if (m_widebandCache.size () >= m_linkPurgeSize)
+    {
+      PurgeReleasedModels ();
+
+      m_linkPurgeSize = std::max<size_t> (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE, 2 * m_widebandCache.size ());
+    }
+
+  for (size_t k = 0; k < missingIndexes.size (); ++k)
+    {
+      NS_ASSERT (timeArrVect[k] != NULL);
+
+      size_t i = missingIndexes[k];
+      std::shared_ptr<const woss::TimeArr> timeArr (std::move (timeArrVect[k]));
+
+      m_widebandCache[LinkKey (tx, rxs[i])]
+        = WidebandCacheEntry { txPosition, rxs[i]->GetPosition (), evolutionSlot, timeArr };
+      retVal[i] = timeArr;
+
+      // the response is the one of the cached arrivals, at the band center without any Thorp correction,
+      // so it is shared by all the in-band modes and built only once per cache miss
+      StoreFreqResponse (tx, rxs[i], *timeArr, (m_widebandStartFreq + m_widebandEndFreq) / 2.0, 1.0);
+    }
+
+  return retVal;
+}
+
 UanPdp
-WossPropModel::CreateUanPdp (std::unique_ptr<woss::TimeArr> timeArr, double symbolTime)
+WossPropModel::CreateUanPdp (std::unique_ptr<woss::TimeArr> timeArr, double symbolTime, double gain, double ampThres)
 {
   NS_LOG_FUNCTION (this);
 
-  std::vector< Tap > vectTap;
+  // the buffer keeps its capacity, so the taps are not reallocated while growing
+  std::vector< Tap > &vectTap = m_tapBuffer;
+
+  vectTap.clear ();
 
   NS_LOG_DEBUG ("timeArr: " << *timeArr << "; symbolTime: " << symbolTime);
 
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
   // we sum coherently at symbol time
   auto coherentSum = timeArr->coherentSumSample (symbolTime);
 
   NS_LOG_DEBUG ("coherentSum size: " << coherentSum->size ());
 
+  if (profiling)
+    {
+      RecordStage (WossProfiler::COHERENT_SUM, startTime, coherentSum->size ());
+      startTime = WossProfiler::GetWallTime ();
+    }
+
   // we need to create a UanPdp with fixed resolution at symbolTime
   if (coherentSum->size () > 0)
     {
@@ -182,57 +666,171 @@ WossPropModel::CreateUanPdp (std::unique_ptr<woss::TimeArr> timeArr, double symb
 
       NS_LOG_DEBUG ("total n taps: " << n_taps);
 
+      vectTap.reserve (m_sparsePdp ? coherentSum->size () : n_taps);
+
       woss::TimeArrCIt it = coherentSum->begin ();
 
-      for (cnt = 0; cnt < n_taps; ++cnt)
+      if (m_sparsePdp)
         {
-          double tap_time = start_time + cnt * symbolTime;
+          // only the non zero taps, each one at the delay of its symbol slot
+          for (; it != coherentSum->end (); ++it)
+            {
+              long tapCnt = std::lround ((it->first - start_time) / symbolTime);
 
-          std::complex<double> tap_value (0.0, 0.0);
+              if (tapCnt >= n_taps)
+                {
+                  break;
+                }
 
-          if (it == coherentSum->end ())
-            {
-              break;
-            }
+              std::complex<double> tap_value = gain * it->second;
 
-          if (woss::PDouble (tap_time, symbolTime * 1.1 / 2.0) == it->first)
-            { // if |tap_time - it->first| <= ((symbolTime+0.1*symbolTime)/2.0) ==> set tap, advance iterator
-              tap_value = it->second;
-              it++;
+              if (tap_value != std::complex<double> (0.0, 0.0))
+                {
+                  vectTap.push_back (Tap (Seconds (start_time + tapCnt * symbolTime), tap_value));
+                }
             }
-          else if (woss::PDouble (tap_time, symbolTime * 1.1 / 2.0) > it->first)
-            { // if tap_time > it->first ==> fatal error
-              NS_FATAL_ERROR ("tap_time: " << tap_time << " > iterator time: " << it->first);
-            }
-          // else ==> tap_time < it->first ==> use tap_value already set to (0.0,0.0)
-
-          NS_LOG_DEBUG ("Tap: " << tap_time << " [s]; " << woss::Pressure::getTxLossDb (tap_value) << " dB re uPa");
 
-          vectTap.push_back (Tap (Seconds (tap_time), tap_value));
+          NS_LOG_DEBUG ("sparse taps: " << vectTap.size ());
         }
+      else
+        {
+          for (cnt = 0; cnt < n_taps; ++cnt)
+            {
+              double tap_time = start_time + cnt * symbolTime;
+
+              std::complex<double> tap_value (0.0, 0.0);
+
+              if (it == coherentSum->end ())
+                {
+                  break;
+                }
+
+              if (woss::PDouble (tap_time, symbolTime * 1.1 / 2.0) == it->first)
+                { // if |tap_time - it->first| <= ((symbolTime+0.1*symbolTime)/2.0) ==> set tap, advance iterator
+                  tap_value = gain * it->second;
+                  it++;
+                }
+              else if (woss::PDouble (tap_time, symbolTime * 1.1 / 2.0) > it->first)
+                { // if tap_time > it->first ==> fatal error
+                  NS_FATAL_ERROR ("tap_time: " << tap_time << " > iterator time: " << it->first);
+                }
+              // else ==> tap_time < it->first ==> use tap_value already set to (0.0,0.0)
+
+              NS_LOG_DEBUG ("Tap: " << tap_time << " [s]; " << woss::Pressure::getTxLossDb (tap_value) << " dB re uPa");
+
+              vectTap.push_back (Tap (Seconds (tap_time), tap_value));
+            }
 
-        NS_ASSERT (cnt == n_taps);
+          NS_ASSERT (cnt == n_taps);
+        }
     } 
 
+  TruncateTaps (vectTap, ampThres);
+
   if (vectTap.size () == 0)
     {
       // return empty channel
       vectTap.push_back (Tap (Seconds (0.0), std::complex<double> (0.0, 0.0)));
     }
 
-  return (UanPdp (vectTap, Seconds (symbolTime)));
+  UanPdp pdp (vectTap, Seconds (symbolTime));
+
+  if (profiling)
+    {
+      RecordStage (WossProfiler::PDP_CREATION, startTime, vectTap.size ());
+    }
+
+  return pdp;
+}
+
+void
+WossPropModel::TruncateTaps (std::vector< Tap > &taps, double ampThres)
+{
+  if ( (taps.size () < 2) || ( (m_truncEnergyFraction <= 0.0) && m_truncDelayWindow.IsZero () ) )
+    {
+      return;
+    }
+
+  // first usable tap, same test of WossChannel::ComputeRxPowerAndDelay and GetFirstTapDelay
+  double powerThres = ampThres * ampThres;
+  size_t first = 0;
+
+  while ( (first < taps.size ()) && (std::norm (taps[first].GetAmp ()) < powerThres) )
+    {
+      ++first;
+    }
+
+  if (first == taps.size ())
+    {
+      // no usable tap, the window starts at the first arrival
+      first = 0;
+    }
+
+  size_t end = taps.size ();
+
+  if (m_truncDelayWindow.IsStrictlyPositive ())
+    {
+      Time lastDelay = taps[first].GetDelay () + m_truncDelayWindow;
+
+      // taps are sorted by delay, the first usable tap is always kept
+      while ( (end > first + 1) && (taps[end - 1].GetDelay () > lastDelay) )
+        {
+          --end;
+        }
+    }
+
+  double totalEnergy = 0.0;
+  double removedEnergy = 0.0;
+
+  for (size_t i = 0; i < taps.size (); ++i)
+    {
+      double tapEnergy = std::norm (taps[i].GetAmp ());
+
+      totalEnergy += tapEnergy;
+
+      if (i >= end)
+        {
+          removedEnergy += tapEnergy;
+        }
+    }
+
+  if (m_truncEnergyFraction > 0.0)
+    {
+      double maxRemovedEnergy = m_truncEnergyFraction * totalEnergy;
+
+      while ( (end > first + 1) && (removedEnergy + std::norm (taps[end - 1].GetAmp ()) <= maxRemovedEnergy) )
+        {
+          removedEnergy += std::norm (taps[end - 1].GetAmp ());
+          --end;
+        }
+    }
+
+  if (end == taps.size ())
+    {
+      return;
+    }
+
+  double removedFraction = totalEnergy > 0.0 ? removedEnergy / totalEnergy : 0.0;
+
+  NS_LOG_DEBUG ("truncated taps: " << taps.size () << " -> " << end << "; removed energy fraction: " << removedFraction);
+
+  m_pdpTruncationTrace (taps.size (), end, removedFraction);
+
+  taps.erase (taps.begin () + end, taps.end ());
 }
 
 WossPropModel::UanPdpVector
-WossPropModel::CreateUanPdpVector (woss::TimeArrVector& timeArrVector, double symbolTime)
+WossPropModel::CreateUanPdpVector (woss::TimeArrVector& timeArrVector, double symbolTime, double ampThres)
 {
   NS_LOG_FUNCTION (this);
 
   UanPdpVector retVal;
 
+  retVal.reserve (timeArrVector.size ());
+
   for ( woss::TimeArrVector::iterator it = timeArrVector.begin (); it != timeArrVector.end (); ++it )
     {
-      retVal.push_back (CreateUanPdp (std::move(*it), symbolTime));
+      retVal.push_back (CreateUanPdp (std::move(*it), symbolTime, 1.0, ampThres));
     }
 
   return retVal;
@@ -243,24 +841,64 @@ WossPropModel::CreateCoordZ (Ptr<MobilityModel> mobModel)
 {
   NS_LOG_FUNCTION (this);
 
+  // native geographic position, no cartesian round trip
+  Ptr<WossGeoWaypointMobilityModel> geoMobModel = DynamicCast<WossGeoWaypointMobilityModel> (mobModel);
+
+  if (geoMobModel != nullptr)
+    {
+      return geoMobModel->GetCoordZ ();
+    }
+
   Vector vect = mobModel->GetPosition ();
 
-  return (woss::CoordZ::getCoordZFromCartesianCoords (vect.x, 
-                                                      vect.y, 
-                                                      vect.z, 
-                                                      woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84));
+  auto it = m_coordZCache.find (mobModel);
+
+  if (it != m_coordZCache.end () && it->second.position == vect)
+    {
+      return it->second.coordZ;
+    }
+
+  woss::CoordZ coordZ = woss::CoordZ::getCoordZFromCartesianCoords (vect.x, 
+                                                                    vect.y, 
+                                                                    vect.z, 
+                                                                    woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  ++m_coordZConversions;
+
+  if (it != m_coordZCache.end ())
+    {
+      it->second = CoordZCacheEntry { vect, coordZ };
+      return coordZ;
+    }
+
+  // the cache holds a reference to its keys, so their address can't be reused by a new mobility model;
+  // models referenced only by the caches have been released by their node and are dropped here
+  if (m_coordZCache.size () >= m_coordZPurgeSize)
+    {
+      PurgeReleasedModels ();
+
+      m_coordZPurgeSize = std::max<size_t> (WOSS_PROP_MODEL_MIN_COORDZ_PURGE_SIZE, 2 * m_coordZCache.size ());
+    }
+
+  m_coordZCache.emplace (mobModel, CoordZCacheEntry { vect, coordZ });
+
+  return coordZ;
 }
 
-woss::CoordZPairVect
+const woss::CoordZPairVect &
 WossPropModel::CreateCoordzPairVector ( Ptr<MobilityModel> tx, MobModelVector& rxs)
 {
   NS_LOG_FUNCTION (this);
 
-  woss::CoordZPairVect retVal;
+  woss::CoordZPairVect &retVal = m_coordzPairBuffer;
+  woss::CoordZ txCoordZ = CreateCoordZ (tx);
+
+  retVal.clear ();
+  retVal.reserve (rxs.size ());
 
   for ( MobModelVector::iterator it = rxs.begin (); it != rxs.end (); ++it )
     {
-      retVal.push_back (std::make_pair (CreateCoordZ (tx), CreateCoordZ (*it)));
+      retVal.push_back (std::make_pair (txCoordZ, CreateCoordZ (*it)));
     }
 
   return retVal;
@@ -273,47 +911,101 @@ WossPropModel::GetDelay (const woss::CoordZ &a, const woss::CoordZ &b, UanTxMode
 
   double startFreq = mode.GetCenterFreqHz ();
   double endFreq = startFreq;
+  double gain = 1.0;
+
+  // same request of the wideband PDPs, so the results of the wideband links are reused
+  if (IsWideband (mode))
+    {
+      startFreq = m_widebandStartFreq;
+      endFreq = m_widebandEndFreq;
+      gain = GetWidebandGain (mode, GetCartesianDistance (a, b));
+    }
 
   NS_LOG_DEBUG ("a: " << a << "; b: " << b << "; startFreq: " << startFreq << "; endFreq: " << endFreq);
 
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
   auto currTimeArr = m_wossManager->getWossTimeArr (a, b, startFreq, endFreq);
 
+  if (profiling)
+    {
+      RecordStage (WossProfiler::TIME_ARR_RETRIEVAL, startTime, 1);
+    }
+
   NS_ASSERT ( currTimeArr != NULL );
 
   NS_LOG_DEBUG ("timeArr: " << *currTimeArr);
 
-  UanPdp uanPdp = CreateUanPdp (std::move (currTimeArr), (1.0 / mode.GetPhyRateSps ()));
+  Time delay = GetFirstTapDelay (*currTimeArr, (1.0 / mode.GetPhyRateSps ()), chAttThresDb, gain);
 
   if (m_memOptimization)
   {
     m_wossManager->reset();
   }
-     
-  NS_LOG_DEBUG ("UanPdp size: " << uanPdp.GetNTaps ());
 
-  UanPdp::Iterator it = uanPdp.GetBegin ();
+  return delay;
+}
 
-  Time delay = it->GetDelay ();
+Time
+WossPropModel::GetFirstTapDelay (const woss::TimeArr &timeArr, double symbolTime, double chAttThresDb, double gain)
+{
+  NS_LOG_FUNCTION (this << symbolTime << chAttThresDb << gain);
 
-  for (int tapCnt = 0; it != uanPdp.GetEnd (); ++it, ++tapCnt)
+  bool profiling = IsProfiling ();
+  double startTime = profiling ? WossProfiler::GetWallTime () : 0.0;
+
+  // same coherent sum of CreateUanPdp, so the taps match the PDP ones
+  auto coherentSum = timeArr.coherentSumSample (symbolTime);
+
+  if (profiling)
+    {
+      RecordStage (WossProfiler::COHERENT_SUM, startTime, coherentSum->size ());
+    }
+
+  if (coherentSum->size () == 0)
     {
-      double attChDb = -20.0 * std::log10 (std::abs (it->GetAmp ()));
+      // CreateUanPdp returns a single empty tap
+      return Seconds (0.0);
+    }
 
-      NS_LOG_DEBUG ("tap: " << tapCnt << "; attChDb: " << attChDb << "dB" );
+  double start_time = coherentSum->begin ()->first;
+  double end_time = coherentSum->rbegin ()->first;
 
-      if ( (attChDb < 0.0) || (attChDb <= chAttThresDb) )
-        {
-          NS_LOG_DEBUG ("tap: " << tapCnt << "; attenuation below threshold, attChDb: " << attChDb << "dB" );
+  int n_taps = 1;
 
-          delay = it->GetDelay ();
+  if (start_time < end_time)
+    {
+      n_taps = std::ceil ((end_time - start_time) / symbolTime);
+    }
 
-          NS_LOG_DEBUG ("found delay: " << delay.GetSeconds ());
+  // attChDb <= chAttThresDb  <==>  |amp|^2 >= 10^(-chAttThresDb / 10), taps with positive gain always pass.
+  // TruncateTaps keeps the first usable tap of the PDP, so the truncation can't move this delay
+  double powerThres = std::pow (10.0, -std::max (chAttThresDb, 0.0) / 10.0) / (gain * gain);
 
+  for (woss::TimeArrCIt it = coherentSum->begin (); it != coherentSum->end (); ++it)
+    {
+      // index of the PDP tap holding this arrival, taps beyond n_taps are not part of the PDP
+      long tapCnt = std::lround ((it->first - start_time) / symbolTime);
+
+      if (tapCnt >= n_taps)
+        {
           break;
         }
+
+      if (std::norm (it->second) >= powerThres)
+        {
+          double tap_time = start_time + tapCnt * symbolTime;
+
+          NS_LOG_DEBUG ("tap: " << tapCnt << "; attenuation below threshold, found delay: " << tap_time);
+
+          return Seconds (tap_time);
+        }
     }
 
-  return delay;
+  NS_LOG_DEBUG ("no tap below threshold, delay of the first tap: " << start_time);
+
+  return Seconds (start_time);
 }
 
 } // namespace ns3
@@ -24,7 +24,14 @@
 #define WOSS_PROP_MODEL_H
 
 #include <memory>
+#include <map>
+#include <set>
+#include <tuple>
 #include "ns3/uan-prop-model-thorp.h"
+#include "ns3/traced-callback.h"
+#include "ns3/nstime.h"
+#include "woss-profiler.h"
+#include "woss-freq-response.h"
 #include <woss-manager.h>
 
 namespace ns3 {
@@ -37,6 +44,26 @@ class Time;
  *
  * Propagation Model that retrieves a power delay profile from the WOSS framework
  * and converts it in a UanPdp object
+ *
+ * By default the channel is computed at the carrier of each UanTxMode. If the "WidebandStartFreq" and
+ * "WidebandEndFreq" attributes are set, the whole band is requested once per link (Bellhop runs at every
+ * WossHelper "WossFrequencyStep" inside the band) and cached per link until one of the nodes moves.
+ * The PDP of every mode whose carrier is in the band is derived from the cached result, with the
+ * Thorp absorption corrected from the band center to the mode carrier, so multi-carrier networks and
+ * frequency hopping modes do not multiply the ray tracing cost. With the WOSS time evolution active
+ * (see SetTimeEvolution, called by WossHelper) the cached arrivals are also valid only within the evolution time
+ * slot they were computed in. GetDelay requests the same band for in-band modes.
+ *
+ * woss::WossManager returns the arrivals averaged over the frequency steps of the band, which the wideband mode
+ * takes as the channel at the band center: the band should be narrow with respect to the carriers.
+ * Each link costs (WidebandEndFreq - WidebandStartFreq) / WossFrequencyStep + 1 Bellhop runs, so a fine
+ * WossFrequencyStep multiplies the ray tracing cost.
+ *
+ * If the "FreqResponse" attribute is set, the WossFreqResponse of every link is also built from the arrivals
+ * of its last PDP, per link and carrier, and cached alongside it, so PHY models can read per-subcarrier gains (see GetFreqResponse)
+ * without any further WOSS request. In wideband mode the response is built once per wideband cache miss from the
+ * band arrivals, with the band center as carrier and without the Thorp correction of the modes, and it is shared
+ * by all the in-band modes.
  */
 class WossPropModel : public UanPropModelThorp
 {
@@ -44,6 +71,24 @@ public:
   typedef ::std::vector< UanPdp > UanPdpVector; //!< ::std::vector of ns3::UanPDP objects
   typedef ::std::vector< Ptr<MobilityModel> > MobModelVector; //!< ::std::vector of ns3::MobilityModel smart pointers
 
+  /**
+   * TracedCallback signature for WOSS stage latencies.
+   *
+   * \param [in] stage The WossProfiler::Stage value.
+   * \param [in] latency The stage wall clock latency.
+   * \param [in] items The number of items processed by the stage.
+   */
+  typedef void (* StageLatencyTracedCallback) (uint32_t stage, Time latency, uint32_t items);
+
+  /**
+   * TracedCallback signature for PDP truncations.
+   *
+   * \param [in] tapsBefore The number of taps before the truncation.
+   * \param [in] tapsAfter The number of taps kept.
+   * \param [in] removedEnergy The fraction of the PDP energy removed.
+   */
+  typedef void (* PdpTruncationTracedCallback) (uint32_t tapsBefore, uint32_t tapsAfter, double removedEnergy);
+
   WossPropModel (); //!< Default constructor
   virtual ~WossPropModel () = default; //!< Default destructor
 
@@ -66,6 +111,19 @@ public:
    */
   std::shared_ptr<woss::WossManager> const GetWossManager (void);
 
+  /**
+   * Sets the time evolution of the environment, as configured in the woss::WossManager and in the
+   * woss::Woss creator. WossHelper class will automatically call it.
+   * \param active true if the time evolution is active
+   * \param quantum evolution time quantum [s], not positive if the environment evolves at every time
+   */
+  void SetTimeEvolution (bool active, double quantum);
+
+  /**
+   * returns the WossProfiler object, or a null pointer if profiling is disabled
+   */
+  Ptr<WossProfiler> GetProfiler (void) const;
+
   /**
    * This function is not supported by the UAN-WOSS framework
    */
@@ -86,9 +144,10 @@ public:
    * \param a transmitter mobility model
    * \param b vector of receiver mobility model
    * \param mode transmission mode used by the transmitter
+   * \param ampThres amplitude threshold of the first usable tap, the PDP truncation starts there
    * \returns the vector of the calculated power delay profiles
    */
-  virtual UanPdpVector GetPdpVector (Ptr<MobilityModel> a, MobModelVector& b, UanTxMode mode);
+  virtual UanPdpVector GetPdpVector (Ptr<MobilityModel> a, MobModelVector& b, UanTxMode mode, double ampThres = 0.0);
 
   /**
    * This function is not supported by the UAN-WOSS framework
@@ -103,26 +162,78 @@ public:
    * \param mode transmitter mode
    * \param chAttThresDb The first channel tap that gives a SNR (dB)
    * greater than the threshold will be used as delay.
-   * \returns the delay in seconds
+   * \returns the delay in seconds, computed on the wideband arrivals if mode is in the wideband band
    */
   virtual Time GetDelay (const woss::CoordZ &a, const woss::CoordZ &b, UanTxMode mode, double chAttThresDb);
 
+  /**
+   * Returns the frequency response of a link, built with its last PDP at the carrier of mode.
+   * The "FreqResponse" attribute must be set. The in-band modes of the wideband mode share the response
+   * at the band center.
+   * \param a transmitter mobility model
+   * \param b receiver mobility model
+   * \param mode transmission mode
+   * \param response the frequency response
+   * \returns false if no PDP has been computed for the link and mode at the current node positions
+   */
+  bool GetFreqResponse (Ptr<MobilityModel> a, Ptr<MobilityModel> b, UanTxMode mode, WossFreqResponse &response) const;
+
+  /**
+   * \returns the number of cartesian to geodetic conversions run by CreateCoordZ
+   */
+  uint64_t GetCoordZConversions (void) const;
+
+  /**
+   * \returns the number of mobility models in the geodetic position cache
+   */
+  uint32_t GetCoordZCacheSize (void) const;
+
 
 protected:
   std::shared_ptr<woss::WossManager> m_wossManager; //!< woss::WossManager object used to trigger acoustic channel computations
 
   virtual void DoInitialize (void) override;
 
+  virtual void DoDispose (void) override;
+
   /**
    * Converts a ns3::UanPdp from a woss::TimeArr object, and symbol time in seconds
    * \param timeArr pointer to a woss::TimeArr object
    * \param symbolTime the modulation symbol time in seconds
+   * \param gain amplitude gain applied to all the taps
+   * \param ampThres amplitude threshold of the first usable tap, see TruncateTaps
    * \returns a ns3::UanPdp object
    */
-  UanPdp CreateUanPdp (std::unique_ptr<woss::TimeArr> timeArr, double symbolTime); // seconds
+  UanPdp CreateUanPdp (std::unique_ptr<woss::TimeArr> timeArr, double symbolTime, double gain = 1.0,
+                       double ampThres = 0.0); // seconds
+
+  /**
+   * Returns the delay of the first tap of the PDP that CreateUanPdp would build, whose attenuation is below the threshold.
+   * The coherent sum is scanned directly, without creating the zero filled taps of the PDP,
+   * and the scan stops at the first usable tap. TruncateTaps never removes the first usable tap,
+   * so the delay is the one of the truncated PDP built with the same threshold.
+   * \param timeArr the time arrivals
+   * \param symbolTime the modulation symbol time in seconds
+   * \param chAttThresDb channel attenuation threshold in dB
+   * \param gain amplitude gain applied to all the arrivals, as in CreateUanPdp
+   * \returns the delay of the first usable tap, or of the first tap if none is usable
+   */
+  Time GetFirstTapDelay (const woss::TimeArr &timeArr, double symbolTime, double chAttThresDb, double gain = 1.0);
+
+  /**
+   * Removes the tail taps outside the "TruncationDelayWindow" from the first usable tap, and then the last taps,
+   * from the latest backwards, as long as their energy sum is within the "TruncationEnergyFraction" of the PDP energy.
+   * The first usable tap, the first one with amplitude not below the threshold, is always kept;
+   * if no tap is usable, the window starts at the first tap.
+   * \param taps the PDP taps, sorted by delay
+   * \param ampThres amplitude threshold of the first usable tap, linear
+   */
+  void TruncateTaps (std::vector< Tap > &taps, double ampThres);
 
   /**
-   * Returns a woss::CoordZ object from the current position of the given mobility model
+   * Returns a woss::CoordZ object from the current position of the given mobility model.
+   * Conversions are cached per mobility model and run again only if the node has moved.
+   * A WossGeoWaypointMobilityModel returns its geographic position directly, without any conversion.
    * \param mobModel smart pointer to a node's mobility model
    * \returns a woss::CoordZ object
    */
@@ -132,21 +243,152 @@ protected:
    * Converts a ns3::UanPdp from a woss::TimeArrVector object, and symbol time in seconds
    * \param timeArr reference to a woss::TimeArrVector object
    * \param symbolTime the modulation symbol time in seconds
+   * \param ampThres amplitude threshold of the first usable tap, see TruncateTaps
    * \returns a ns3::UanPdpVector object
    */
-  UanPdpVector CreateUanPdpVector (woss::TimeArrVector& timeArr, double symbolTime); // seconds
+  UanPdpVector CreateUanPdpVector (woss::TimeArrVector& timeArr, double symbolTime, double ampThres = 0.0); // seconds
 
   /**
-   * Creates a woss::CoordZPairVect from a woss::TimeArr object, and symbol time in seconds
+   * Creates a woss::CoordZPairVect from a woss::TimeArr object, and symbol time in seconds.
+   * The vector is a buffer reused by every call, valid until the next call.
    * \param tx transmitter mobility model
    * \param rx reference to a vector of mobility models (receivers)
-   * \returns a ns3::CoordZPairVect object
+   * \returns a reference to a ns3::CoordZPairVect object
+   */
+  const woss::CoordZPairVect &CreateCoordzPairVector (Ptr<MobilityModel> tx, MobModelVector& rxs);
+
+  /**
+   * \param mode transmission mode
+   * \returns true if the wideband band is set and contains the carrier of mode
    */
-  woss::CoordZPairVect CreateCoordzPairVector (Ptr<MobilityModel> tx, MobModelVector& rxs);
+  bool IsWideband (UanTxMode mode) const;
+
+  /**
+   * The wideband arrivals are averaged over the band by woss::WossManager, they are taken as the channel
+   * at the band center and only the Thorp absorption is moved to the carrier.
+   * \param mode transmission mode
+   * \param range link range [m]
+   * \returns the amplitude gain moving the Thorp absorption from the band center to the carrier of mode
+   */
+  double GetWidebandGain (UanTxMode mode, double range) const;
+
+  /**
+   * Returns the wideband time arrivals of the links, from the per-link cache.
+   * All the links missing from the cache are requested to the woss::WossManager at once.
+   * \param tx transmitter mobility model
+   * \param rxs receiver mobility models
+   * \returns one time arrivals object per receiver
+   */
+  std::vector< std::shared_ptr<const woss::TimeArr> > GetWidebandTimeArr (Ptr<MobilityModel> tx, MobModelVector& rxs);
+
+  /**
+   * Builds and caches the frequency response of a link, if the "FreqResponse" attribute is set
+   * \param a transmitter mobility model
+   * \param b receiver mobility model
+   * \param timeArr the arrivals of the link
+   * \param carrierFreq the carrier frequency [Hz] of the arrivals
+   * \param gain amplitude gain applied to all the arrivals
+   */
+  void StoreFreqResponse (Ptr<MobilityModel> a, Ptr<MobilityModel> b, const woss::TimeArr &timeArr,
+                          double carrierFreq, double gain);
+
+  /**
+   * \returns true if either a WossProfiler is set or the StageLatency trace is connected
+   */
+  bool IsProfiling (void) const;
+
+  /**
+   * Records a stage execution into the WossProfiler and fires the StageLatency trace
+   * \param stage the profiled stage
+   * \param startTime the stage start time, as returned by WossProfiler::GetWallTime ()
+   * \param items number of items processed by the stage
+   */
+  void RecordStage (WossProfiler::Stage stage, double startTime, uint32_t items);
+
+  /**
+   * \returns the evolution time slot of the current simulation time, zero if the time evolution is not active
+   */
+  int64_t GetEvolutionSlot (void) const;
+
+  /**
+   * Removes the cache entries of the mobility models released by their nodes, i.e. referenced only by the caches
+   */
+  void PurgeReleasedModels (void);
 
 private:
+  /**
+   * Cached geodetic conversion of a node position
+   */
+  struct CoordZCacheEntry
+  {
+    Vector position; //!< last converted cartesian position
+    woss::CoordZ coordZ; //!< geodetic conversion of position
+  };
+
+  typedef std::map< Ptr<MobilityModel>, CoordZCacheEntry > CoordZCacheMap; //!< map of cached conversions, keyed by mobility model
+
+  CoordZCacheMap m_coordZCache; //!< per-node geodetic position cache
+  size_t m_coordZPurgeSize; //!< cache size that triggers the removal of entries of released mobility models
+  uint64_t m_coordZConversions; //!< number of cartesian to geodetic conversions
+
+  /**
+   * Cached wideband time arrivals of a link
+   */
+  struct WidebandCacheEntry
+  {
+    Vector txPosition; //!< transmitter position of timeArr
+    Vector rxPosition; //!< receiver position of timeArr
+    int64_t evolutionSlot; //!< evolution time slot of timeArr, see GetEvolutionSlot
+    std::shared_ptr<const woss::TimeArr> timeArr; //!< wideband time arrivals
+  };
+
+  typedef std::pair< Ptr<MobilityModel>, Ptr<MobilityModel> > LinkKey; //!< link key, transmitter and receiver
+  typedef std::map< LinkKey, WidebandCacheEntry > WidebandCacheMap; //!< map of cached time arrivals, keyed by link
+
+  WidebandCacheMap m_widebandCache; //!< per-link wideband time arrivals cache
+  size_t m_linkPurgeSize; //!< link cache size that triggers the removal of entries of released mobility models
+
+  /**
+   * Cached frequency response of a link
+   */
+  struct FreqResponseCacheEntry
+  {
+    Vector txPosition; //!< transmitter position of response
+    Vector rxPosition; //!< receiver position of response
+    WossFreqResponse response; //!< frequency response
+  };
+
+  typedef std::tuple< Ptr<MobilityModel>, Ptr<MobilityModel>, double > FreqResponseKey; //!< link and carrier [Hz] key
+  typedef std::map< FreqResponseKey, FreqResponseCacheEntry > FreqResponseCacheMap; //!< map of cached responses
+
+  FreqResponseCacheMap m_freqResponseCache; //!< per-link and carrier frequency response cache
+  size_t m_freqResponsePurgeSize; //!< response cache size that triggers the removal of entries of released mobility models
+
+  bool m_freqResponse; //!< if true the frequency response of every link is cached
+
+  bool m_sparsePdp; //!< if true the PDPs hold only the non zero taps
+
+  double m_truncEnergyFraction; //!< maximum fraction of the PDP energy removed from the tail, zero disables it
+
+  Time m_truncDelayWindow; //!< maximum delay of the kept taps, from the first tap, zero disables it
+
+  TracedCallback<uint32_t, uint32_t, double> m_pdpTruncationTrace; //!< trace fired at every PDP truncation
+
+  double m_widebandStartFreq; //!< wideband start frequency [Hz], wideband disabled if not lower than m_widebandEndFreq
+  double m_widebandEndFreq; //!< wideband end frequency [Hz]
+
+  bool m_timeEvolution; //!< true if the WOSS time evolution is active
+  double m_evolutionQuantum; //!< WOSS evolution time quantum [s], not positive if the environment evolves at every time
+
+  Ptr<WossProfiler> m_profiler; //!< optional profiler, if null profiling is disabled
+
+  TracedCallback<uint32_t, Time, uint32_t> m_stageLatencyTrace; //!< trace fired at the end of every profiled stage
 
   bool m_memOptimization; //!< If true, WOSS objects are freed as soon as possible. 
+
+  woss::CoordZPairVect m_coordzPairBuffer; //!< coordinates buffer of CreateCoordzPairVector, reused across transmissions
+
+  std::vector< Tap > m_tapBuffer; //!< taps buffer of CreateUanPdp, reused across PDPs
 };
 
 }
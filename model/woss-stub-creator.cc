@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <cmath>
+#include <complex>
+#include "ns3/log.h"
+#include "woss-stub-creator.h"
+#include <pressure-definitions.h>
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossStubCreator");
+
+
+WossStub::WossStub (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &startTime, const woss::Time &endTime,
+                    double startFreq, double endFreq)
+  : woss::Woss (tx, rx, startTime, endTime, startFreq, endFreq),
+    m_txCoordZ (tx),
+    m_rxCoordZ (rx),
+    m_centerFreq ((startFreq + endFreq) / 2.0),
+    m_waterDepth (WossStubCreator::DEFAULT_WATER_DEPTH),
+    m_soundSpeed (WossStubCreator::DEFAULT_SOUND_SPEED),
+    m_maxReflOrder (WossStubCreator::DEFAULT_MAX_REFL_ORDER),
+    m_bottomReflCoeff (WossStubCreator::DEFAULT_BOTTOM_REFL_COEFF),
+    m_arrivals ()
+{
+}
+
+void
+WossStub::SetParameters (double waterDepth, double soundSpeed, uint32_t maxReflOrder, double bottomReflCoeff)
+{
+  m_waterDepth = waterDepth;
+  m_soundSpeed = soundSpeed;
+  m_maxReflOrder = maxReflOrder;
+  m_bottomReflCoeff = bottomReflCoeff;
+}
+
+double
+WossStub::GetThorpAttenuationDbKm (double frequency)
+{
+  double fKhz = frequency / 1000.0;
+  double fKhz2 = fKhz * fKhz;
+
+  return 0.11 * fKhz2 / (1.0 + fKhz2) + 44.0 * fKhz2 / (4100.0 + fKhz2) + 2.75E-4 * fKhz2 + 0.003;
+}
+
+bool
+WossStub::initialize ()
+{
+  return true;
+}
+
+bool
+WossStub::run ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_arrivals = woss::TimeArr ();
+
+  double range = m_txCoordZ.getGreatCircleDistance (m_rxCoordZ);
+  double txDepth = std::min (std::max (m_txCoordZ.getDepth (), 0.0), m_waterDepth);
+  double rxDepth = std::min (std::max (m_rxCoordZ.getDepth (), 0.0), m_waterDepth);
+  double attDbPerMeter = GetThorpAttenuationDbKm (m_centerFreq) / 1000.0;
+
+  // image method: for every bottom reflection order n four image families exist
+  for (uint32_t n = 0; n <= m_maxReflOrder; ++n)
+    {
+      double verticalDist[4] = { 2.0 * n * m_waterDepth + rxDepth - txDepth,
+                                 2.0 * n * m_waterDepth + rxDepth + txDepth,
+                                 2.0 * (n + 1) * m_waterDepth - rxDepth - txDepth,
+                                 2.0 * (n + 1) * m_waterDepth - rxDepth + txDepth };
+      uint32_t surfRefl[4] = { n, n + 1, n, n + 1 };
+      uint32_t bottomRefl[4] = { n, n, n + 1, n + 1 };
+
+      for (int image = 0; image < 4; ++image)
+        {
+          if (bottomRefl[image] > m_maxReflOrder)
+            {
+              continue;
+            }
+
+          double pathLength = std::sqrt (range * range + verticalDist[image] * verticalDist[image]);
+          pathLength = std::max (pathLength, 1.0);
+
+          double amp = std::pow (m_bottomReflCoeff, bottomRefl[image]) / pathLength
+                       * std::pow (10.0, -attDbPerMeter * pathLength / 20.0);
+
+          if (surfRefl[image] % 2 == 1)
+            {
+              amp = -amp;
+            }
+
+          double delay = pathLength / m_soundSpeed;
+
+          NS_LOG_DEBUG ("image:" << image << "; order:" << n << "; pathLength:" << pathLength
+                                 << "; delay:" << delay << "; amp:" << amp);
+
+          m_arrivals.insertValue (delay, std::complex<double> (amp, 0.0));
+        }
+    }
+
+  return true;
+}
+
+bool
+WossStub::timeEvolve (const woss::Time &timeValue)
+{
+  return true;
+}
+
+bool
+WossStub::isValid () const
+{
+  return true;
+}
+
+std::unique_ptr<woss::Pressure>
+WossStub::getWossPressure (double frequency, double txDepth, double startRxDepth,
+                           double startRxRange, double endRxDepth, double endRxRange) const
+{
+  return std::make_unique<woss::Pressure> (m_arrivals);
+}
+
+std::unique_ptr<woss::TimeArr>
+WossStub::getWossTimeArr (double frequency, double txDepth, double startRxDepth,
+                          double startRxRange, double endRxDepth, double endRxRange) const
+{
+  return std::make_unique<woss::TimeArr> (m_arrivals);
+}
+
+
+constexpr double WossStubCreator::DEFAULT_WATER_DEPTH;
+constexpr double WossStubCreator::DEFAULT_SOUND_SPEED;
+constexpr uint32_t WossStubCreator::DEFAULT_MAX_REFL_ORDER;
+constexpr double WossStubCreator::DEFAULT_BOTTOM_REFL_COEFF;
+
+WossStubCreator::WossStubCreator ()
+  : woss::WossCreator (),
+    m_waterDepth (DEFAULT_WATER_DEPTH),
+    m_soundSpeed (DEFAULT_SOUND_SPEED),
+    m_maxReflOrder (DEFAULT_MAX_REFL_ORDER),
+    m_bottomReflCoeff (DEFAULT_BOTTOM_REFL_COEFF),
+    m_createdWossCount (0)
+{
+}
+
+std::unique_ptr<woss::Woss>
+WossStubCreator::createWoss (const woss::CoordZ &tx, const woss::CoordZ &rx,
+                             const woss::Time &startTime, const woss::Time &endTime,
+                             double startFreq, double endFreq) const
+{
+  NS_LOG_FUNCTION (this);
+
+  auto wossStub = std::make_unique<WossStub> (tx, rx, startTime, endTime, startFreq, endFreq);
+
+  // debug flags, work path, runs, frequency step and time evolution are set as for any other woss::Woss
+  initializeWoss (wossStub.get (), tx, rx);
+
+  wossStub->SetParameters (m_waterDepth, m_soundSpeed, m_maxReflOrder, m_bottomReflCoeff);
+  wossStub->initialize ();
+
+  m_createdWossCount++;
+
+  return wossStub;
+}
+
+void
+WossStubCreator::SetWaterDepth (double waterDepth)
+{
+  NS_ASSERT (waterDepth > 0.0);
+
+  m_waterDepth = waterDepth;
+}
+
+void
+WossStubCreator::SetSoundSpeed (double soundSpeed)
+{
+  NS_ASSERT (soundSpeed > 0.0);
+
+  m_soundSpeed = soundSpeed;
+}
+
+void
+WossStubCreator::SetMaxReflectionOrder (uint32_t maxReflOrder)
+{
+  m_maxReflOrder = maxReflOrder;
+}
+
+void
+WossStubCreator::SetBottomReflCoeff (double bottomReflCoeff)
+{
+  NS_ASSERT (bottomReflCoeff >= 0.0 && bottomReflCoeff <= 1.0);
+
+  m_bottomReflCoeff = bottomReflCoeff;
+}
+
+uint64_t
+WossStubCreator::GetCreatedWossCount (void) const
+{
+  return m_createdWossCount;
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
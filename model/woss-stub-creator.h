@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_STUB_CREATOR_H
+#define WOSS_STUB_CREATOR_H
+
+#include <atomic>
+#include <memory>
+#include <woss.h>
+#include <woss-creator.h>
+#include <time-arr.h>
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossStub
+ * \brief In-process channel simulator stand-in that computes deterministic multipath from geometry
+ *
+ * The WossStub replaces the external channel simulator (e.g. Bellhop) with the image method
+ * applied to an iso-velocity waveguide of constant depth. Arrivals are the direct path and the
+ * surface / bottom reflected paths up to the given reflection order. Every arrival is attenuated
+ * by spherical spreading, Thorp absorption at the center frequency, a -1 surface reflection
+ * coefficient and a constant bottom reflection coefficient.
+ * No file is written and no external process is spawned, results are fully deterministic.
+ */
+class WossStub : public woss::Woss
+{
+public:
+  /**
+   * \param tx transmitter coordinates
+   * \param rx receiver coordinates
+   * \param startTime simulation start time
+   * \param endTime simulation end time
+   * \param startFreq start frequency [Hz]
+   * \param endFreq end frequency [Hz]
+   */
+  WossStub (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &startTime, const woss::Time &endTime,
+            double startFreq, double endFreq);
+
+  virtual ~WossStub () = default; //!< Default destructor
+
+  /**
+   * Sets the stub channel parameters
+   * \param waterDepth waveguide depth [m]
+   * \param soundSpeed sound speed [m/s]
+   * \param maxReflOrder maximum number of bottom reflections of a path
+   * \param bottomReflCoeff bottom reflection coefficient, range [0,1]
+   */
+  void SetParameters (double waterDepth, double soundSpeed, uint32_t maxReflOrder, double bottomReflCoeff);
+
+  virtual bool initialize () override;
+
+  /**
+   * Computes all the arrivals
+   * \returns true
+   */
+  virtual bool run () override;
+
+  /**
+   * The stub channel is static, nothing is recomputed
+   * \returns true
+   */
+  virtual bool timeEvolve (const woss::Time &timeValue) override;
+
+  virtual bool isValid () const override;
+
+  virtual std::unique_ptr<woss::Pressure> getWossPressure (double frequency, double txDepth, double startRxDepth,
+                                                            double startRxRange, double endRxDepth, double endRxRange) const override;
+
+  virtual std::unique_ptr<woss::TimeArr> getWossTimeArr (double frequency, double txDepth, double startRxDepth,
+                                                          double startRxRange, double endRxDepth, double endRxRange) const override;
+
+  /**
+   * \param frequency frequency [Hz]
+   * \returns the Thorp absorption [dB/km]
+   */
+  static double GetThorpAttenuationDbKm (double frequency);
+
+private:
+  woss::CoordZ m_txCoordZ; //!< transmitter coordinates
+  woss::CoordZ m_rxCoordZ; //!< receiver coordinates
+  double m_centerFreq; //!< center frequency [Hz]
+  double m_waterDepth; //!< waveguide depth [m]
+  double m_soundSpeed; //!< sound speed [m/s]
+  uint32_t m_maxReflOrder; //!< maximum number of bottom reflections
+  double m_bottomReflCoeff; //!< bottom reflection coefficient
+  woss::TimeArr m_arrivals; //!< computed arrivals
+};
+
+/**
+ * \ingroup WOSS
+ * \class WossStubCreator
+ * \brief woss::WossCreator that allocates WossStub objects
+ *
+ * It can be selected through the WossHelper "WossUseStubCreator" attribute, in order to run the full
+ * WossChannel - WossPropModel - woss::WossManager pipeline without any external channel simulator.
+ */
+class WossStubCreator : public woss::WossCreator
+{
+public:
+  static constexpr double DEFAULT_WATER_DEPTH = 100.0; //!< default waveguide depth [m]
+  static constexpr double DEFAULT_SOUND_SPEED = 1500.0; //!< default sound speed [m/s]
+  static constexpr uint32_t DEFAULT_MAX_REFL_ORDER = 3; //!< default maximum number of bottom reflections
+  static constexpr double DEFAULT_BOTTOM_REFL_COEFF = 0.5; //!< default bottom reflection coefficient
+
+  WossStubCreator (); //!< Default constructor
+
+  virtual ~WossStubCreator () = default; //!< Default destructor
+
+  virtual std::unique_ptr<woss::Woss> createWoss (const woss::CoordZ &tx, const woss::CoordZ &rx,
+                                                  const woss::Time &startTime, const woss::Time &endTime,
+                                                  double startFreq, double endFreq) const override;
+
+  /**
+   * \param waterDepth waveguide depth [m]
+   */
+  void SetWaterDepth (double waterDepth);
+
+  /**
+   * \param soundSpeed sound speed [m/s]
+   */
+  void SetSoundSpeed (double soundSpeed);
+
+  /**
+   * \param maxReflOrder maximum number of bottom reflections of a path
+   */
+  void SetMaxReflectionOrder (uint32_t maxReflOrder);
+
+  /**
+   * \param bottomReflCoeff bottom reflection coefficient, range [0,1]
+   */
+  void SetBottomReflCoeff (double bottomReflCoeff);
+
+  /**
+   * \returns the number of WossStub objects created so far, i.e. the number of channel simulator runs
+   */
+  uint64_t GetCreatedWossCount (void) const;
+
+private:
+  double m_waterDepth; //!< waveguide depth [m]
+  double m_soundSpeed; //!< sound speed [m/s]
+  uint32_t m_maxReflOrder; //!< maximum number of bottom reflections
+  double m_bottomReflCoeff; //!< bottom reflection coefficient
+  mutable std::atomic<uint64_t> m_createdWossCount; //!< number of created WossStub objects
+};
+
+}
+
+#endif /* WOSS_STUB_CREATOR_H */
+
+#endif /* NS3_WOSS_SUPPORT */
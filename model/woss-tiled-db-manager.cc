@@ -0,0 +1,985 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "woss-tiled-db-manager.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WossTiledDbManager");
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = { 'W', 'O', 'S', 'S', 'E', 'N', 'V', '1' }; //!< snapshot file magic
+const uint32_t SNAPSHOT_VERSION = 1; //!< snapshot format version
+const uint32_t SNAPSHOT_SEDIM_TYPE_LENGTH = 32; //!< maximum sediment type name length, including the terminator
+
+/**
+ * Snapshot grid record
+ */
+struct SnapshotGrid
+{
+  double latMin; //!< minimum latitude [dec degrees]
+  double lonMin; //!< minimum longitude [dec degrees]
+  double step; //!< tile size [dec degrees]
+  uint32_t nLat; //!< number of tiles along the latitude
+  uint32_t nLon; //!< number of tiles along the longitude
+};
+
+/**
+ * Snapshot file header. All the offsets are in bytes from the file start, 8 bytes aligned.
+ * Layout: header, bathymetry floats, SSP index, SSP (depth, speed) pairs, sediment records
+ */
+struct SnapshotHeader
+{
+  char magic[8]; //!< SNAPSHOT_MAGIC
+  uint32_t version; //!< SNAPSHOT_VERSION
+  int32_t sspMonth; //!< month of the SSP tiles
+  double sspDepthPrecision; //!< depth precision of the SSP tiles
+  SnapshotGrid bathyGrid; //!< bathymetry grid
+  SnapshotGrid sspGrid; //!< SSP grid
+  SnapshotGrid sedimGrid; //!< sediment grid
+  uint64_t bathyOffset; //!< offset of the bathymetry floats, one per tile
+  uint64_t sspIndexOffset; //!< offset of the SSP index, one SnapshotSspIndex per tile
+  uint64_t sspDataOffset; //!< offset of the SSP (depth, speed) double pairs
+  uint64_t sspDataCount; //!< number of SSP (depth, speed) pairs
+  uint64_t sedimOffset; //!< offset of the sediment records, one SnapshotSediment per tile
+  uint64_t fileSize; //!< total file size
+};
+
+/**
+ * Snapshot SSP index record
+ */
+struct SnapshotSspIndex
+{
+  uint32_t begin; //!< first (depth, speed) pair
+  uint32_t count; //!< number of pairs, 0 if not available
+};
+
+/**
+ * Snapshot sediment record
+ */
+struct SnapshotSediment
+{
+  char type[SNAPSHOT_SEDIM_TYPE_LENGTH]; //!< sediment type name, empty if not available
+  double velocityC; //!< compressional wave velocity [m/s]
+  double velocityS; //!< shear wave velocity [m/s]
+  double density; //!< density [g/cm^3]
+  double attenuationC; //!< compressional wave attenuation [db/wavelength]
+  double attenuationS; //!< shear wave attenuation [db/wavelength]
+};
+
+/**
+ * \param offset a file offset
+ * \returns the offset aligned to 8 bytes
+ */
+uint64_t
+AlignOffset (uint64_t offset)
+{
+  return (offset + 7) & ~uint64_t (7);
+}
+
+/**
+ * \param grid a snapshot grid record
+ * \returns true if the grid has a valid step and its tile count fits a TileGrid
+ */
+bool
+IsValidSnapshotGrid (const SnapshotGrid &grid)
+{
+  return std::isfinite (grid.latMin) && std::isfinite (grid.lonMin) && std::isfinite (grid.step) && grid.step > 0.0
+         && (uint64_t) grid.nLat * grid.nLon <= std::numeric_limits<uint32_t>::max ();
+}
+
+/**
+ * \param offset block offset [bytes]
+ * \param count number of items of the block
+ * \param itemSize item size [bytes]
+ * \param fileSize file size [bytes]
+ * \returns true if the block is 8 bytes aligned and fits the file
+ */
+bool
+IsValidSnapshotBlock (uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t fileSize)
+{
+  return offset % 8 == 0 && offset >= sizeof (SnapshotHeader) && offset <= fileSize
+         && count <= (fileSize - offset) / itemSize;
+}
+
+/**
+ * \param grid a tile grid
+ * \returns the snapshot grid record
+ */
+SnapshotGrid
+ToSnapshotGrid (const WossTiledDbManager::TileGrid &grid)
+{
+  return SnapshotGrid { grid.latMin, grid.lonMin, grid.step, grid.nLat, grid.nLon };
+}
+
+/**
+ * \param grid a snapshot grid record
+ * \returns the tile grid
+ */
+WossTiledDbManager::TileGrid
+FromSnapshotGrid (const SnapshotGrid &grid)
+{
+  WossTiledDbManager::TileGrid retVal;
+  retVal.latMin = grid.latMin;
+  retVal.lonMin = grid.lonMin;
+  retVal.step = grid.step;
+  retVal.nLat = grid.nLat;
+  retVal.nLon = grid.nLon;
+  return retVal;
+}
+
+} // namespace
+
+bool
+WossTiledDbManager::TileGrid::GetIndex (const woss::Coord &coord, uint32_t &index) const
+{
+  if (step <= 0.0)
+    {
+      return false;
+    }
+
+  double latIdx = std::floor ((coord.getLatitude () - latMin) / step);
+  double lonIdx = std::floor ((coord.getLongitude () - lonMin) / step);
+
+  if (latIdx < 0.0 || lonIdx < 0.0 || latIdx >= nLat || lonIdx >= nLon)
+    {
+      return false;
+    }
+
+  index = static_cast<uint32_t> (latIdx) * nLon + static_cast<uint32_t> (lonIdx);
+
+  return true;
+}
+
+woss::Coord
+WossTiledDbManager::TileGrid::GetCenter (uint32_t index) const
+{
+  NS_ASSERT (index < GetSize ());
+
+  return woss::Coord (latMin + (index / nLon + 0.5) * step, lonMin + (index % nLon + 0.5) * step);
+}
+
+uint32_t
+WossTiledDbManager::TileGrid::GetSize (void) const
+{
+  return nLat * nLon;
+}
+
+WossTiledDbManager::WossTiledDbManager ()
+  : woss::WossDbManager (),
+    m_bathyTileSize (1.0 / 120.0),
+    m_sspTileSize (0.25),
+    m_sedimTileSize (1.0 / 60.0),
+    m_isPreloaded (false),
+    m_bathyGrid (),
+    m_bathyTiles (),
+    m_bathyData (nullptr),
+    m_sspGrid (),
+    m_sspTiles (),
+    m_sspMonth (0),
+    m_sspDepthPrecision (SSP_CUSTOM_DEPTH_PRECISION),
+    m_sedimGrid (),
+    m_sedimTiles (),
+    m_bathyField (),
+    m_sspField (),
+    m_mappedData (nullptr),
+    m_mappedSize (0),
+    m_transectQuantum (0.0),
+    m_transectCacheSize (0),
+    m_bathyCache (),
+    m_sspCache (),
+    m_sedimCache (),
+    m_cacheHits (0),
+    m_cacheMisses (0),
+    m_tileHits (0),
+    m_tileMisses (0),
+    m_fieldHits (0)
+{
+}
+
+WossTiledDbManager::~WossTiledDbManager ()
+{
+  UnmapSnapshot ();
+}
+
+void
+WossTiledDbManager::SetBathymetryTileSize (double tileSize)
+{
+  NS_ASSERT (tileSize > 0.0);
+
+  m_bathyTileSize = tileSize;
+}
+
+void
+WossTiledDbManager::SetSspTileSize (double tileSize)
+{
+  NS_ASSERT (tileSize > 0.0);
+
+  m_sspTileSize = tileSize;
+}
+
+void
+WossTiledDbManager::SetSedimentTileSize (double tileSize)
+{
+  NS_ASSERT (tileSize > 0.0);
+
+  m_sedimTileSize = tileSize;
+}
+
+namespace {
+
+/**
+ * \param tx transmitter coordinates
+ * \param rx sample coordinates
+ * \param bearing the initial bearing of the transect
+ * \param range the range of the sample
+ */
+void
+GetTransectPosition (const woss::CoordZ &tx, const woss::CoordZ &rx, double &bearing, double &range)
+{
+  range = tx.getGreatCircleDistance (rx);
+  bearing = (range > 0.0) ? tx.getInitialBearing (rx) : 0.0;
+}
+
+/**
+ * \param timeValue SSP time
+ * \returns a key unique to each second of timeValue
+ */
+int64_t
+GetTimeKey (const woss::Time &timeValue)
+{
+  int64_t days = ((int64_t) timeValue.getYear () * 12 + timeValue.getMonth ()) * 31 + timeValue.getDay ();
+
+  return ((days * 24 + timeValue.getHours ()) * 60 + timeValue.getMinutes ()) * 60 + timeValue.getSeconds ();
+}
+
+} // namespace
+
+bool
+WossTiledDbManager::HasCustomBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  double bearing = 0.0;
+  double range = 0.0;
+  GetTransectPosition (tx, rx, bearing, range);
+
+  woss::Bathymetry depth = woss::WossDbManager::getCustomBathymetry (tx, bearing, range);
+
+  return std::isfinite (depth) && depth > 0.0;
+}
+
+bool
+WossTiledDbManager::HasCustomSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  double bearing = 0.0;
+  double range = 0.0;
+  GetTransectPosition (tx, rx, bearing, range);
+
+  std::unique_ptr<woss::Sediment> sediment = woss::WossDbManager::getCustomSediment (tx, bearing, range);
+
+  return sediment != nullptr && sediment->isValid ();
+}
+
+bool
+WossTiledDbManager::HasCustomSsp (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue) const
+{
+  double bearing = 0.0;
+  double range = 0.0;
+  GetTransectPosition (tx, rx, bearing, range);
+
+  std::unique_ptr<woss::SSP> ssp = woss::WossDbManager::getCustomSSP (tx, bearing, range, timeValue);
+
+  return ssp != nullptr && ssp->isValid ();
+}
+
+WossTiledDbManager::TileGrid
+WossTiledDbManager::CreateGrid (const woss::Coord &minCoord, const woss::Coord &maxCoord, double step)
+{
+  TileGrid grid;
+
+  // the grid is aligned to multiples of step, so the tiles match the database cells
+  grid.step = step;
+  grid.latMin = std::floor (minCoord.getLatitude () / step) * step;
+  grid.lonMin = std::floor (minCoord.getLongitude () / step) * step;
+  grid.nLat = std::floor ((maxCoord.getLatitude () - grid.latMin) / step) + 1;
+  grid.nLon = std::floor ((maxCoord.getLongitude () - grid.lonMin) / step) + 1;
+
+  return grid;
+}
+
+void
+WossTiledDbManager::Preload (const woss::Coord &minCoord, const woss::Coord &maxCoord, const woss::Time &sspTime,
+                             long double sspDepthPrecision)
+{
+  NS_LOG_FUNCTION (this << minCoord << maxCoord);
+
+  NS_ASSERT (minCoord.getLatitude () <= maxCoord.getLatitude () && minCoord.getLongitude () <= maxCoord.getLongitude ());
+
+  ClearTiles ();
+
+  m_bathyGrid = CreateGrid (minCoord, maxCoord, m_bathyTileSize);
+  m_bathyTiles.resize (m_bathyGrid.GetSize ());
+
+  for (uint32_t i = 0; i < m_bathyGrid.GetSize (); ++i)
+    {
+      woss::CoordZ center (m_bathyGrid.GetCenter (i), 0.0);
+
+      // custom data would be served to every transect crossing the tile, the tile is left to woss::WossDbManager
+      if (HasCustomBathymetry (center, center))
+        {
+          m_bathyTiles[i] = std::numeric_limits<float>::quiet_NaN ();
+          continue;
+        }
+
+      woss::Bathymetry depth = woss::WossDbManager::getBathymetry (center, center);
+
+      m_bathyTiles[i] = (depth > 0.0 && std::isfinite (depth)) ? depth : std::numeric_limits<float>::quiet_NaN ();
+    }
+
+  m_bathyData = m_bathyTiles.data ();
+
+  m_sspGrid = CreateGrid (minCoord, maxCoord, m_sspTileSize);
+  m_sspTiles.resize (m_sspGrid.GetSize ());
+  m_sspMonth = sspTime.getMonth ();
+  m_sspDepthPrecision = sspDepthPrecision;
+
+  for (uint32_t i = 0; i < m_sspGrid.GetSize (); ++i)
+    {
+      woss::CoordZ center (m_sspGrid.GetCenter (i), 0.0);
+
+      if (HasCustomSsp (center, center, sspTime))
+        {
+          continue;
+        }
+
+      std::unique_ptr<woss::SSP> ssp = woss::WossDbManager::getSSP (center, center, sspTime, sspDepthPrecision);
+
+      if (ssp != nullptr && ssp->isValid ())
+        {
+          m_sspTiles[i] = std::move (ssp);
+        }
+    }
+
+  m_sedimGrid = CreateGrid (minCoord, maxCoord, m_sedimTileSize);
+  m_sedimTiles.resize (m_sedimGrid.GetSize ());
+
+  for (uint32_t i = 0; i < m_sedimGrid.GetSize (); ++i)
+    {
+      woss::CoordZ center (m_sedimGrid.GetCenter (i), 0.0);
+
+      if (HasCustomSediment (center, center))
+        {
+          continue;
+        }
+
+      std::unique_ptr<woss::Sediment> sediment = woss::WossDbManager::getSediment (center, center);
+
+      if (sediment != nullptr && sediment->isValid ())
+        {
+          m_sedimTiles[i] = std::move (sediment);
+        }
+    }
+
+  m_isPreloaded = true;
+
+  NS_LOG_DEBUG ("preloaded bathymetry tiles=" << m_bathyGrid.GetSize () << "; SSP tiles=" << m_sspGrid.GetSize ()
+                                              << "; sediment tiles=" << m_sedimGrid.GetSize ());
+}
+
+void
+WossTiledDbManager::SetBathymetryField (std::shared_ptr<const WossGridField> field)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (field == nullptr || field->IsProfile () == false);
+
+  m_bathyField = field;
+  ClearTransectCache ();
+}
+
+void
+WossTiledDbManager::SetSspField (std::shared_ptr<const WossGridField> field)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT (field == nullptr || field->IsProfile () == true);
+
+  m_sspField = field;
+  ClearTransectCache ();
+}
+
+void
+WossTiledDbManager::ClearTiles (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_isPreloaded = false;
+  m_bathyGrid = TileGrid ();
+  m_bathyTiles.clear ();
+  m_bathyData = nullptr;
+  m_sspGrid = TileGrid ();
+  m_sspTiles.clear ();
+  m_sedimGrid = TileGrid ();
+  m_sedimTiles.clear ();
+
+  UnmapSnapshot ();
+  ClearTransectCache ();
+}
+
+void
+WossTiledDbManager::UnmapSnapshot (void)
+{
+  if (m_mappedData != nullptr)
+    {
+      ::munmap (m_mappedData, m_mappedSize);
+      m_mappedData = nullptr;
+      m_mappedSize = 0;
+    }
+}
+
+bool
+WossTiledDbManager::SaveSnapshot (const std::string &fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  if (m_isPreloaded == false)
+    {
+      NS_LOG_ERROR ("no tiles to save");
+      return false;
+    }
+
+  std::vector<SnapshotSspIndex> sspIndex (m_sspGrid.GetSize (), SnapshotSspIndex { 0, 0 });
+  std::vector<double> sspData;
+
+  for (uint32_t i = 0; i < m_sspGrid.GetSize (); ++i)
+    {
+      if (m_sspTiles[i] == nullptr)
+        {
+          continue;
+        }
+
+      sspIndex[i].begin = sspData.size () / 2;
+
+      for (auto it = m_sspTiles[i]->begin (); it != m_sspTiles[i]->end (); ++it)
+        {
+          sspData.push_back (it->first);
+          sspData.push_back (it->second);
+          sspIndex[i].count++;
+        }
+    }
+
+  std::vector<SnapshotSediment> sedimData (m_sedimGrid.GetSize ());
+
+  for (uint32_t i = 0; i < m_sedimGrid.GetSize (); ++i)
+    {
+      SnapshotSediment &record = sedimData[i];
+      std::memset (&record, 0, sizeof (SnapshotSediment));
+
+      if (m_sedimTiles[i] == nullptr)
+        {
+          continue;
+        }
+
+      const woss::Sediment &sediment = *m_sedimTiles[i];
+      std::string type = sediment.getType ().empty () ? "sediment" : sediment.getType ();
+
+      std::strncpy (record.type, type.c_str (), SNAPSHOT_SEDIM_TYPE_LENGTH - 1);
+      record.velocityC = sediment.getVelocityC ();
+      record.velocityS = sediment.getVelocityS ();
+      record.density = sediment.getDensity ();
+      record.attenuationC = sediment.getAttenuationC ();
+      record.attenuationS = sediment.getAttenuationS ();
+    }
+
+  SnapshotHeader header;
+  std::memset (&header, 0, sizeof (SnapshotHeader));
+  std::memcpy (header.magic, SNAPSHOT_MAGIC, sizeof (SNAPSHOT_MAGIC));
+  header.version = SNAPSHOT_VERSION;
+  header.sspMonth = m_sspMonth;
+  header.sspDepthPrecision = m_sspDepthPrecision;
+  header.bathyGrid = ToSnapshotGrid (m_bathyGrid);
+  header.sspGrid = ToSnapshotGrid (m_sspGrid);
+  header.sedimGrid = ToSnapshotGrid (m_sedimGrid);
+  header.bathyOffset = AlignOffset (sizeof (SnapshotHeader));
+  header.sspIndexOffset = AlignOffset (header.bathyOffset + m_bathyGrid.GetSize () * sizeof (float));
+  header.sspDataOffset = AlignOffset (header.sspIndexOffset + sspIndex.size () * sizeof (SnapshotSspIndex));
+  header.sspDataCount = sspData.size () / 2;
+  header.sedimOffset = AlignOffset (header.sspDataOffset + sspData.size () * sizeof (double));
+  header.fileSize = header.sedimOffset + sedimData.size () * sizeof (SnapshotSediment);
+
+  std::ofstream out (fileName, std::ios::binary | std::ios::trunc);
+
+  if (!out.is_open ())
+    {
+      NS_LOG_ERROR ("can't open " << fileName);
+      return false;
+    }
+
+  // writes a block at the given offset, zero padding the gap
+  auto writeBlock = [&out] (uint64_t offset, const void *data, uint64_t size)
+    {
+      static const char padding[8] = { 0 };
+      uint64_t position = out.tellp ();
+      out.write (padding, offset - position);
+      out.write (static_cast<const char *> (data), size);
+    };
+
+  writeBlock (0, &header, sizeof (SnapshotHeader));
+  writeBlock (header.bathyOffset, m_bathyData, m_bathyGrid.GetSize () * sizeof (float));
+  writeBlock (header.sspIndexOffset, sspIndex.data (), sspIndex.size () * sizeof (SnapshotSspIndex));
+  writeBlock (header.sspDataOffset, sspData.data (), sspData.size () * sizeof (double));
+  writeBlock (header.sedimOffset, sedimData.data (), sedimData.size () * sizeof (SnapshotSediment));
+
+  out.close ();
+
+  if (out.fail ())
+    {
+      NS_LOG_ERROR ("error while writing " << fileName);
+      return false;
+    }
+
+  NS_LOG_DEBUG ("snapshot " << fileName << " written, size=" << header.fileSize);
+
+  return true;
+}
+
+bool
+WossTiledDbManager::LoadSnapshot (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  ClearTiles ();
+
+  int fd = ::open (fileName.c_str (), O_RDONLY);
+
+  if (fd < 0)
+    {
+      NS_LOG_ERROR ("can't open " << fileName);
+      return false;
+    }
+
+  struct stat fileStat;
+
+  if (::fstat (fd, &fileStat) != 0 || (size_t) fileStat.st_size < sizeof (SnapshotHeader))
+    {
+      NS_LOG_ERROR (fileName << " is not a valid snapshot");
+      ::close (fd);
+      return false;
+    }
+
+  // read only shared mapping, the pages are shared among all the processes loading the snapshot
+  void *mapped = ::mmap (nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close (fd);
+
+  if (mapped == MAP_FAILED)
+    {
+      NS_LOG_ERROR ("can't map " << fileName);
+      return false;
+    }
+
+  m_mappedData = mapped;
+  m_mappedSize = fileStat.st_size;
+
+  const char *base = static_cast<const char *> (mapped);
+  const SnapshotHeader *header = reinterpret_cast<const SnapshotHeader *> (base);
+
+  // a truncated or corrupted file must not lead to reads outside the mapping
+  if (std::memcmp (header->magic, SNAPSHOT_MAGIC, sizeof (SNAPSHOT_MAGIC)) != 0 || header->version != SNAPSHOT_VERSION
+      || header->fileSize != m_mappedSize
+      || !IsValidSnapshotGrid (header->bathyGrid) || !IsValidSnapshotGrid (header->sspGrid)
+      || !IsValidSnapshotGrid (header->sedimGrid))
+    {
+      NS_LOG_ERROR (fileName << " is not a valid snapshot");
+      UnmapSnapshot ();
+      return false;
+    }
+
+  TileGrid bathyGrid = FromSnapshotGrid (header->bathyGrid);
+  TileGrid sspGrid = FromSnapshotGrid (header->sspGrid);
+  TileGrid sedimGrid = FromSnapshotGrid (header->sedimGrid);
+
+  if (!IsValidSnapshotBlock (header->bathyOffset, bathyGrid.GetSize (), sizeof (float), m_mappedSize)
+      || !IsValidSnapshotBlock (header->sspIndexOffset, sspGrid.GetSize (), sizeof (SnapshotSspIndex), m_mappedSize)
+      || !IsValidSnapshotBlock (header->sspDataOffset, header->sspDataCount, 2 * sizeof (double), m_mappedSize)
+      || !IsValidSnapshotBlock (header->sedimOffset, sedimGrid.GetSize (), sizeof (SnapshotSediment), m_mappedSize))
+    {
+      NS_LOG_ERROR (fileName << " is not a valid snapshot");
+      UnmapSnapshot ();
+      return false;
+    }
+
+  m_bathyGrid = bathyGrid;
+  m_bathyData = reinterpret_cast<const float *> (base + header->bathyOffset);
+
+  m_sspGrid = sspGrid;
+  m_sspMonth = header->sspMonth;
+  m_sspDepthPrecision = header->sspDepthPrecision;
+  m_sspTiles.resize (m_sspGrid.GetSize ());
+
+  const SnapshotSspIndex *sspIndex = reinterpret_cast<const SnapshotSspIndex *> (base + header->sspIndexOffset);
+  const double *sspData = reinterpret_cast<const double *> (base + header->sspDataOffset);
+
+  for (uint32_t i = 0; i < m_sspGrid.GetSize (); ++i)
+    {
+      if (sspIndex[i].count == 0 || (uint64_t) sspIndex[i].begin + sspIndex[i].count > header->sspDataCount)
+        {
+          continue;
+        }
+
+      m_sspTiles[i] = std::make_unique<woss::SSP> (m_sspDepthPrecision);
+
+      for (uint32_t j = sspIndex[i].begin; j < sspIndex[i].begin + sspIndex[i].count; ++j)
+        {
+          m_sspTiles[i]->insertValue (sspData[2 * j], sspData[2 * j + 1]);
+        }
+    }
+
+  m_sedimGrid = sedimGrid;
+  m_sedimTiles.resize (m_sedimGrid.GetSize ());
+
+  const SnapshotSediment *sedimData = reinterpret_cast<const SnapshotSediment *> (base + header->sedimOffset);
+
+  for (uint32_t i = 0; i < m_sedimGrid.GetSize (); ++i)
+    {
+      const SnapshotSediment &record = sedimData[i];
+
+      if (record.type[0] == '\0')
+        {
+          continue;
+        }
+
+      std::string type (record.type, strnlen (record.type, SNAPSHOT_SEDIM_TYPE_LENGTH));
+
+      m_sedimTiles[i] = std::make_unique<woss::Sediment> (type, record.velocityC, record.velocityS, record.density,
+                                                          record.attenuationC, record.attenuationS);
+    }
+
+  m_isPreloaded = true;
+
+  NS_LOG_DEBUG ("snapshot " << fileName << " loaded, bathymetry tiles=" << m_bathyGrid.GetSize ()
+                            << "; SSP tiles=" << m_sspGrid.GetSize () << "; sediment tiles=" << m_sedimGrid.GetSize ());
+
+  return true;
+}
+
+bool
+WossTiledDbManager::SampleKey::operator== (const SampleKey &other) const
+{
+  return txLat == other.txLat && txLon == other.txLon && rxLat == other.rxLat && rxLon == other.rxLon
+         && time == other.time && precision == other.precision;
+}
+
+size_t
+WossTiledDbManager::SampleKeyHash::operator() (const SampleKey &key) const
+{
+  // boost::hash_combine
+  size_t seed = 0;
+
+  for (int64_t value : { key.txLat, key.txLon, key.rxLat, key.rxLon, key.time })
+    {
+      seed ^= std::hash<int64_t> () (value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+  return seed;
+}
+
+void
+WossTiledDbManager::SetTransectCache (double quantum, uint32_t maxEntries)
+{
+  NS_LOG_FUNCTION (this << quantum << maxEntries);
+
+  NS_ASSERT (quantum >= 0.0);
+
+  ClearTransectCache ();
+
+  m_transectQuantum = quantum;
+  m_transectCacheSize = maxEntries;
+}
+
+void
+WossTiledDbManager::ClearTransectCache (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::unique_lock<std::shared_mutex> bathyLock (m_bathyCache.mutex);
+  m_bathyCache.samples.clear ();
+  bathyLock.unlock ();
+
+  std::unique_lock<std::shared_mutex> sspLock (m_sspCache.mutex);
+  m_sspCache.samples.clear ();
+  sspLock.unlock ();
+
+  std::unique_lock<std::shared_mutex> sedimLock (m_sedimCache.mutex);
+  m_sedimCache.samples.clear ();
+}
+
+uint64_t
+WossTiledDbManager::GetTransectCacheHits (void) const
+{
+  return m_cacheHits.load ();
+}
+
+uint64_t
+WossTiledDbManager::GetTransectCacheMisses (void) const
+{
+  return m_cacheMisses.load ();
+}
+
+WossTiledDbManager::SampleKey
+WossTiledDbManager::CreateSampleKey (const woss::CoordZ &tx, const woss::CoordZ &rx, int64_t time,
+                                     long double precision) const
+{
+  // depths are not part of the key, all the environmental data is a function of the geographic coordinates only
+  auto quantize = [this] (double value)
+    {
+      return static_cast<int64_t> (std::llround (value / m_transectQuantum));
+    };
+
+  return SampleKey { quantize (tx.getLatitude ()), quantize (tx.getLongitude ()),
+                     quantize (rx.getLatitude ()), quantize (rx.getLongitude ()),
+                     time, precision };
+}
+
+template <typename T>
+bool
+WossTiledDbManager::FindSample (SampleCache<T> &cache, const SampleKey &key, T &value) const
+{
+  std::shared_lock<std::shared_mutex> lock (cache.mutex);
+
+  auto it = cache.samples.find (key);
+
+  if (it == cache.samples.end ())
+    {
+      m_cacheMisses.fetch_add (1, std::memory_order_relaxed);
+      return false;
+    }
+
+  value = it->second;
+  m_cacheHits.fetch_add (1, std::memory_order_relaxed);
+
+  return true;
+}
+
+template <typename T>
+void
+WossTiledDbManager::InsertSample (SampleCache<T> &cache, const SampleKey &key, const T &value) const
+{
+  std::unique_lock<std::shared_mutex> lock (cache.mutex);
+
+  if (cache.samples.size () >= m_transectCacheSize)
+    {
+      NS_LOG_DEBUG ("transect cache full, flushing " << cache.samples.size () << " samples");
+      cache.samples.clear ();
+    }
+
+  // another worker may have inserted the same sample meanwhile, the first one is kept
+  cache.samples.emplace (key, value);
+}
+
+bool
+WossTiledDbManager::IsPreloaded (void) const
+{
+  return m_isPreloaded;
+}
+
+uint64_t
+WossTiledDbManager::GetTileHits (void) const
+{
+  return m_tileHits.load ();
+}
+
+uint64_t
+WossTiledDbManager::GetTileMisses (void) const
+{
+  return m_tileMisses.load ();
+}
+
+uint64_t
+WossTiledDbManager::GetFieldHits (void) const
+{
+  return m_fieldHits.load ();
+}
+
+woss::Bathymetry
+WossTiledDbManager::LookupBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  uint32_t index = 0;
+  double depth = 0.0;
+
+  // precedence: custom transects, gridded field, tiles, woss::WossDbManager
+  if ((m_bathyField != nullptr || m_isPreloaded) && !HasCustomBathymetry (tx, rx))
+    {
+      if (m_bathyField != nullptr && m_bathyField->GetValue (rx, depth))
+        {
+          m_fieldHits.fetch_add (1, std::memory_order_relaxed);
+          return depth;
+        }
+
+      if (m_isPreloaded && m_bathyGrid.GetIndex (rx, index) && !std::isnan (m_bathyData[index]))
+        {
+          m_tileHits.fetch_add (1, std::memory_order_relaxed);
+          return m_bathyData[index];
+        }
+    }
+
+  m_tileMisses.fetch_add (1, std::memory_order_relaxed);
+
+  return woss::WossDbManager::getBathymetry (tx, rx);
+}
+
+std::unique_ptr<woss::Sediment>
+WossTiledDbManager::LookupSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  uint32_t index = 0;
+
+  if (m_isPreloaded && m_sedimGrid.GetIndex (rx, index) && m_sedimTiles[index] != nullptr
+      && !HasCustomSediment (tx, rx))
+    {
+      m_tileHits.fetch_add (1, std::memory_order_relaxed);
+      return std::unique_ptr<woss::Sediment> (m_sedimTiles[index]->clone ());
+    }
+
+  m_tileMisses.fetch_add (1, std::memory_order_relaxed);
+
+  return woss::WossDbManager::getSediment (tx, rx);
+}
+
+std::unique_ptr<woss::SSP>
+WossTiledDbManager::LookupSSP (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue,
+                               long double sspDepthPrecision) const
+{
+  uint32_t index = 0;
+
+  // reused across lookups, getSSP is called from the woss::WossManagerResDbMT worker threads
+  static thread_local std::vector<double> speeds;
+
+  // precedence: custom transects, gridded field, tiles, woss::WossDbManager
+  if ((m_sspField != nullptr || m_isPreloaded) && !HasCustomSsp (tx, rx, timeValue))
+    {
+      if (m_sspField != nullptr && m_sspField->GetProfile (rx, speeds))
+        {
+          const std::vector<double> &depths = m_sspField->GetDepths ();
+          std::unique_ptr<woss::SSP> ssp = std::make_unique<woss::SSP> (sspDepthPrecision);
+
+          for (size_t i = 0; i < depths.size (); ++i)
+            {
+              if (!std::isnan (speeds[i]))
+                {
+                  ssp->insertValue (depths[i], speeds[i]);
+                }
+            }
+
+          m_fieldHits.fetch_add (1, std::memory_order_relaxed);
+          return ssp;
+        }
+
+      // the WOA databases are monthly, a tile is valid for the whole month it was sampled in,
+      // custom SSPs set for any other time of the month have been checked above
+      if (m_isPreloaded && timeValue.getMonth () == m_sspMonth && sspDepthPrecision == m_sspDepthPrecision
+          && m_sspGrid.GetIndex (rx, index) && m_sspTiles[index] != nullptr)
+        {
+          m_tileHits.fetch_add (1, std::memory_order_relaxed);
+          return std::unique_ptr<woss::SSP> (m_sspTiles[index]->clone ());
+        }
+    }
+
+  m_tileMisses.fetch_add (1, std::memory_order_relaxed);
+
+  return woss::WossDbManager::getSSP (tx, rx, timeValue, sspDepthPrecision);
+}
+
+woss::Bathymetry
+WossTiledDbManager::getBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  if (m_transectQuantum <= 0.0)
+    {
+      return LookupBathymetry (tx, rx);
+    }
+
+  SampleKey key = CreateSampleKey (tx, rx, 0, 0.0);
+  woss::Bathymetry depth = 0.0;
+
+  if (FindSample (m_bathyCache, key, depth) == false)
+    {
+      depth = LookupBathymetry (tx, rx);
+      InsertSample (m_bathyCache, key, depth);
+    }
+
+  return depth;
+}
+
+std::unique_ptr<woss::Sediment>
+WossTiledDbManager::getSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const
+{
+  if (m_transectQuantum <= 0.0)
+    {
+      return LookupSediment (tx, rx);
+    }
+
+  SampleKey key = CreateSampleKey (tx, rx, 0, 0.0);
+  std::shared_ptr<const woss::Sediment> sediment;
+
+  if (FindSample (m_sedimCache, key, sediment) == false)
+    {
+      sediment = LookupSediment (tx, rx);
+      InsertSample (m_sedimCache, key, sediment);
+    }
+
+  return sediment == nullptr ? nullptr : std::unique_ptr<woss::Sediment> (sediment->clone ());
+}
+
+std::unique_ptr<woss::SSP>
+WossTiledDbManager::getSSP (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue,
+                            long double sspDepthPrecision) const
+{
+  if (m_transectQuantum <= 0.0)
+    {
+      return LookupSSP (tx, rx, timeValue, sspDepthPrecision);
+    }
+
+  // the WOA databases are monthly, but a custom SSP can be set for any time
+  SampleKey key = CreateSampleKey (tx, rx, GetTimeKey (timeValue), sspDepthPrecision);
+  std::shared_ptr<const woss::SSP> ssp;
+
+  if (FindSample (m_sspCache, key, ssp) == false)
+    {
+      ssp = LookupSSP (tx, rx, timeValue, sspDepthPrecision);
+      InsertSample (m_sspCache, key, ssp);
+    }
+
+  return ssp == nullptr ? nullptr : std::unique_ptr<woss::SSP> (ssp->clone ());
+}
+
+} // namespace ns3
+
+#endif /* NS3_WOSS_SUPPORT */
@@ -0,0 +1,401 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Federico Guerra
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Federico Guerra <WOSS@guerra-tlc.com>
+ */
+
+#ifdef NS3_WOSS_SUPPORT
+
+#ifndef WOSS_TILED_DB_MANAGER_H
+#define WOSS_TILED_DB_MANAGER_H
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <woss-db-manager.h>
+#include <ssp-definitions.h>
+#include <sediment-definitions.h>
+#include "woss-grid-field.h"
+
+
+namespace ns3 {
+
+/**
+ * \ingroup WOSS
+ * \class WossTiledDbManager
+ * \brief woss::WossDbManager with a preloaded in-memory tile cache of the environmental databases
+ *
+ * Preload samples bathymetry, SSP and sediment over a geographic bounding box, one value per tile, through the
+ * woss::WossDbManager lookups of the GEBCO, WOA and DECK41 databases.
+ * Afterwards every lookup whose receiver falls inside the box is a plain array access, without any NetCDF I/O.
+ * Lookups outside the box, for a different SSP month or for missing data are forwarded to woss::WossDbManager.
+ * Before Preload is called the behaviour is the one of woss::WossDbManager.
+ *
+ * Each data type has its own tile size, matching the resolution of the respective database.
+ * Tiles only hold database values: a tile whose center is covered by custom data is left empty, and
+ * a lookup for which custom data exists (for its transmitter, bearing, range and time) skips the tiles,
+ * so custom transects keep their precedence over the databases.
+ * The tiles are read only after Preload, so lookups are safe from the woss::WossManagerResDbMT worker threads.
+ *
+ * The tiles can be saved into a single binary snapshot file (SaveSnapshot) and loaded back (LoadSnapshot) without
+ * opening any database. The snapshot is memory mapped: the bathymetry tiles are read in place, so all the processes
+ * loading the same snapshot share its pages, while the few SSP and sediment tiles are copied into new objects at
+ * load time and are not served from the mapping. A snapshot holds the database tiles only: custom transects and
+ * gridded fields are not saved and must be set again after LoadSnapshot.
+ * Snapshots are written in the native byte order and are meant to be used on the same architecture.
+ *
+ * Gridded custom bathymetry and SSP fields (see WossGridField), e.g. from surveys, can be set with
+ * SetBathymetryField and SetSspField. They are bilinearly interpolated at the receiver coordinates of every
+ * lookup, so they serve any transect. The SSP field is valid at any time and its profiles are built with the
+ * requested SSP depth precision.
+ *
+ * Each lookup is served, in order of precedence, by the custom transects set for its transmitter, bearing,
+ * range and time (woss::WossDbManager::setCustomBathymetry, setCustomSSP, ...), by the gridded fields,
+ * by the tiles and finally by woss::WossDbManager. Lookups outside a field or a box, or where they have no data,
+ * fall back to the next source.
+ *
+ * Each Bellhop run samples the environment along the transmitter to receiver great circle, one lookup per range step.
+ * The optional transect cache (SetTransectCache) stores these samples keyed by the transmitter and by the sample
+ * coordinates, both quantized, so that the transects of nearby links are built from the already extracted samples.
+ * The cache is shared by all the woss::WossManagerResDbMT worker threads and guarded by a std::shared_mutex per data
+ * type: hits only take the shared lock. The quantization step should be finer than the range step of the transects.
+ * SSP samples are keyed by the full lookup time, since custom SSPs can be set for any time, so with time evolution
+ * the SSP samples are shared only by the transects of the same time step.
+ * The cache is flushed by Preload, LoadSnapshot and by the field setters. The custom data setters of
+ * woss::WossDbManager don't flush it: WossHelper calls ClearTransectCache after every custom setter, importer and
+ * eraser, direct callers must do the same.
+ */
+class WossTiledDbManager : public woss::WossDbManager
+{
+public:
+  /**
+   * Regular latitude / longitude grid of tiles
+   */
+  struct TileGrid
+  {
+    double latMin = 0.0; //!< minimum latitude [dec degrees]
+    double lonMin = 0.0; //!< minimum longitude [dec degrees]
+    double step = 0.0; //!< tile size [dec degrees]
+    uint32_t nLat = 0; //!< number of tiles along the latitude
+    uint32_t nLon = 0; //!< number of tiles along the longitude
+
+    /**
+     * \param coord geographic coordinates
+     * \param index the tile index, if found
+     * \returns true if coord falls inside the grid
+     */
+    bool GetIndex (const woss::Coord &coord, uint32_t &index) const;
+
+    /**
+     * \param index the tile index
+     * \returns the center of the tile
+     */
+    woss::Coord GetCenter (uint32_t index) const;
+
+    /**
+     * \returns the total number of tiles
+     */
+    uint32_t GetSize (void) const;
+  };
+
+  WossTiledDbManager (); //!< Default constructor
+
+  virtual ~WossTiledDbManager (); //!< Destructor, unmaps the snapshot
+
+  /**
+   * \param tileSize bathymetry tile size [dec degrees]
+   */
+  void SetBathymetryTileSize (double tileSize);
+
+  /**
+   * \param tileSize SSP tile size [dec degrees]
+   */
+  void SetSspTileSize (double tileSize);
+
+  /**
+   * \param tileSize sediment tile size [dec degrees]
+   */
+  void SetSedimentTileSize (double tileSize);
+
+  /**
+   * Samples all the environmental data of the bounding box into memory.
+   * The databases must be already connected, i.e. the woss::WossController must be initialized.
+   * \param minCoord south west corner of the bounding box
+   * \param maxCoord north east corner of the bounding box
+   * \param sspTime time of the SSP samples, SSP tiles are used for lookups of the same month
+   * \param sspDepthPrecision SSP depth precision, SSP tiles are used for lookups with the same precision
+   */
+  void Preload (const woss::Coord &minCoord, const woss::Coord &maxCoord, const woss::Time &sspTime,
+                long double sspDepthPrecision);
+
+  /**
+   * Writes all the tiles into a snapshot file. Tiles must be preloaded or loaded.
+   * Custom transects and gridded fields are not written.
+   * \param fileName the snapshot file name
+   * \returns true on success
+   */
+  bool SaveSnapshot (const std::string &fileName) const;
+
+  /**
+   * Replaces all the tiles with the ones of a snapshot file written by SaveSnapshot.
+   * Only the bathymetry is read in place, SSP and sediment tiles are copied.
+   * \param fileName the snapshot file name
+   * \returns true on success, false if the file can't be mapped or is not a valid snapshot
+   */
+  bool LoadSnapshot (const std::string &fileName);
+
+  /**
+   * \param field gridded bathymetry field, nullptr to remove it. It must not be modified afterwards.
+   */
+  void SetBathymetryField (std::shared_ptr<const WossGridField> field);
+
+  /**
+   * \param field gridded 3-D SSP field, nullptr to remove it. It must not be modified afterwards.
+   */
+  void SetSspField (std::shared_ptr<const WossGridField> field);
+
+  /**
+   * Enables the transect cache
+   * \param quantum quantization step of the transmitter and sample coordinates [dec degrees], 0 disables the cache
+   * \param maxEntries maximum number of cached samples of each data type, the cache is flushed when it is exceeded
+   */
+  void SetTransectCache (double quantum, uint32_t maxEntries);
+
+  /**
+   * Frees all the cached transect samples
+   */
+  void ClearTransectCache (void);
+
+  /**
+   * \returns the number of lookups served by the transect cache
+   */
+  uint64_t GetTransectCacheHits (void) const;
+
+  /**
+   * \returns the number of lookups not found in the transect cache
+   */
+  uint64_t GetTransectCacheMisses (void) const;
+
+  /**
+   * Frees all the tiles, lookups are forwarded to woss::WossDbManager again
+   */
+  void ClearTiles (void);
+
+  /**
+   * \returns true if Preload has been called
+   */
+  bool IsPreloaded (void) const;
+
+  /**
+   * \returns the number of lookups served by the tiles
+   */
+  uint64_t GetTileHits (void) const;
+
+  /**
+   * \returns the number of lookups forwarded to woss::WossDbManager
+   */
+  uint64_t GetTileMisses (void) const;
+
+  /**
+   * \returns the number of lookups served by the gridded fields
+   */
+  uint64_t GetFieldHits (void) const;
+
+  virtual woss::Bathymetry getBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const override;
+
+  virtual std::unique_ptr<woss::Sediment> getSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const override;
+
+  virtual std::unique_ptr<woss::SSP> getSSP (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue,
+                                             long double sspDepthPrecision = SSP_CUSTOM_DEPTH_PRECISION) const override;
+
+protected:
+  /**
+   * Transect cache key, coordinates are quantized
+   */
+  struct SampleKey
+  {
+    int64_t txLat; //!< transmitter latitude
+    int64_t txLon; //!< transmitter longitude
+    int64_t rxLat; //!< sample latitude
+    int64_t rxLon; //!< sample longitude
+    int64_t time; //!< SSP time, 0 for bathymetry and sediment
+    long double precision; //!< SSP depth precision, 0 for bathymetry and sediment
+
+    /**
+     * \param other the other key
+     * \returns true if the keys are equal
+     */
+    bool operator== (const SampleKey &other) const;
+  };
+
+  /**
+   * Hash of SampleKey
+   */
+  struct SampleKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash value
+     */
+    size_t operator() (const SampleKey &key) const;
+  };
+
+  /**
+   * Transect cache of a data type
+   */
+  template <typename T>
+  struct SampleCache
+  {
+    std::shared_mutex mutex; //!< shared for lookups, exclusive for insertions
+    std::unordered_map<SampleKey, T, SampleKeyHash> samples; //!< cached samples
+  };
+
+  /**
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \param time SSP time, 0 for bathymetry and sediment
+   * \param precision SSP depth precision, 0 for bathymetry and sediment
+   * \returns the cache key
+   */
+  SampleKey CreateSampleKey (const woss::CoordZ &tx, const woss::CoordZ &rx, int64_t time, long double precision) const;
+
+  /**
+   * \param cache the cache
+   * \param key the key
+   * \param value the cached value, if found
+   * \returns true if found
+   */
+  template <typename T>
+  bool FindSample (SampleCache<T> &cache, const SampleKey &key, T &value) const;
+
+  /**
+   * Inserts a sample, the cache is flushed if it is full
+   * \param cache the cache
+   * \param key the key
+   * \param value the value
+   */
+  template <typename T>
+  void InsertSample (SampleCache<T> &cache, const SampleKey &key, const T &value) const;
+
+  /**
+   * Bathymetry lookup through the fields, the tiles and woss::WossDbManager
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \returns the bathymetry
+   */
+  woss::Bathymetry LookupBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const;
+
+  /**
+   * Sediment lookup through the tiles and woss::WossDbManager
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \returns the sediment
+   */
+  std::unique_ptr<woss::Sediment> LookupSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const;
+
+  /**
+   * SSP lookup through the fields, the tiles and woss::WossDbManager
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \param timeValue SSP time
+   * \param sspDepthPrecision SSP depth precision
+   * \returns the SSP
+   */
+  std::unique_ptr<woss::SSP> LookupSSP (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue,
+                                        long double sspDepthPrecision) const;
+
+  /**
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \returns true if custom bathymetry is set for the transect sample
+   */
+  bool HasCustomBathymetry (const woss::CoordZ &tx, const woss::CoordZ &rx) const;
+
+  /**
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \returns true if a custom sediment is set for the transect sample
+   */
+  bool HasCustomSediment (const woss::CoordZ &tx, const woss::CoordZ &rx) const;
+
+  /**
+   * \param tx transmitter coordinates
+   * \param rx sample coordinates
+   * \param timeValue SSP time
+   * \returns true if a custom SSP is set for the transect sample
+   */
+  bool HasCustomSsp (const woss::CoordZ &tx, const woss::CoordZ &rx, const woss::Time &timeValue) const;
+
+  /**
+   * Creates a grid covering the bounding box
+   * \param minCoord south west corner
+   * \param maxCoord north east corner
+   * \param step tile size [dec degrees]
+   * \returns the grid
+   */
+  static TileGrid CreateGrid (const woss::Coord &minCoord, const woss::Coord &maxCoord, double step);
+
+  /**
+   * Unmaps the snapshot file, if any
+   */
+  void UnmapSnapshot (void);
+
+  double m_bathyTileSize; //!< bathymetry tile size [dec degrees]
+  double m_sspTileSize; //!< SSP tile size [dec degrees]
+  double m_sedimTileSize; //!< sediment tile size [dec degrees]
+
+  bool m_isPreloaded; //!< true if the tiles are valid
+
+  TileGrid m_bathyGrid; //!< bathymetry grid
+  std::vector<float> m_bathyTiles; //!< seafloor depth of each tile [m], NaN if not available
+  const float *m_bathyData; //!< bathymetry tiles in use, either m_bathyTiles or the mapped snapshot
+
+  TileGrid m_sspGrid; //!< SSP grid
+  std::vector<std::unique_ptr<woss::SSP> > m_sspTiles; //!< SSP of each tile, nullptr if not available
+  int m_sspMonth; //!< month of the SSP tiles
+  long double m_sspDepthPrecision; //!< depth precision of the SSP tiles
+
+  TileGrid m_sedimGrid; //!< sediment grid
+  std::vector<std::unique_ptr<woss::Sediment> > m_sedimTiles; //!< sediment of each tile, nullptr if not available
+
+  std::shared_ptr<const WossGridField> m_bathyField; //!< gridded bathymetry field, nullptr if none
+  std::shared_ptr<const WossGridField> m_sspField; //!< gridded SSP field, nullptr if none
+
+  void *m_mappedData; //!< mapped snapshot, nullptr if none
+  size_t m_mappedSize; //!< size of the mapped snapshot [bytes]
+
+  double m_transectQuantum; //!< transect cache quantization step [dec degrees], 0 if disabled
+  uint32_t m_transectCacheSize; //!< maximum number of cached samples of each data type
+  mutable SampleCache<woss::Bathymetry> m_bathyCache; //!< cached bathymetry samples
+  mutable SampleCache<std::shared_ptr<const woss::SSP> > m_sspCache; //!< cached SSP samples
+  mutable SampleCache<std::shared_ptr<const woss::Sediment> > m_sedimCache; //!< cached sediment samples
+  mutable std::atomic<uint64_t> m_cacheHits; //!< lookups served by the transect cache
+  mutable std::atomic<uint64_t> m_cacheMisses; //!< lookups not found in the transect cache
+
+  mutable std::atomic<uint64_t> m_tileHits; //!< lookups served by the tiles
+  mutable std::atomic<uint64_t> m_tileMisses; //!< lookups forwarded to woss::WossDbManager
+  mutable std::atomic<uint64_t> m_fieldHits; //!< lookups served by the gridded fields
+};
+
+}
+
+#endif /* WOSS_TILED_DB_MANAGER_H */
+
+#endif /* NS3_WOSS_SUPPORT */
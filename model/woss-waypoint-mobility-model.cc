@@ -45,6 +45,15 @@ WossWaypointMobilityModel::GetTypeId (void)
   return tid;
 }
 
+WossWaypointMobilityModel::WossWaypointMobilityModel ()
+  : WaypointMobilityModel (),
+    m_leg (),
+    m_legStartTime (),
+    m_legEnd (),
+    m_isLegValid (false)
+{
+}
+
 void
 WossWaypointMobilityModel::DoDispose (void)
 {
@@ -105,50 +114,19 @@ WossWaypointMobilityModel::Update (void) const
 
   if ( now > m_current.time ) // Won't ever be less, but may be equal
     {
-      const double tSpan = (m_next.time - m_current.time).GetSeconds ();
-
-      const double tDiff = (now - m_current.time).GetSeconds ();
-
-      NS_LOG_DEBUG ("tSpan=" << tSpan << "; tDiff=" << tDiff);
+      NS_LOG_DEBUG ("tSpan=" << (m_next.time - m_current.time).GetSeconds ()
+                    << "; tDiff=" << (now - m_current.time).GetSeconds ());
 
-      woss::CoordZ cCurrent = woss::CoordZ::getCoordZFromCartesianCoords (m_current.position.x,
-                                                                          m_current.position.y,
-                                                                          m_current.position.z,
-                                                                          woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84
-                                                                         );
+      UpdateLeg ();
 
-      woss::CoordZ cNext = woss::CoordZ::getCoordZFromCartesianCoords (m_next.position.x,
-                                                                       m_next.position.y,
-                                                                       m_next.position.z,
-                                                                       woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84
-                                                                      );
+      // the ratio is taken from the leg start, so the leg constants stay valid until m_next changes
+      double ratio = (now - m_legStartTime).GetSeconds () / (m_next.time - m_legStartTime).GetSeconds ();
 
-      NS_LOG_DEBUG ("cCurrent=" << cCurrent << "; cNext=" << cNext);
-
-      double circleDist = cCurrent.getGreatCircleDistance (cNext);
-      double depthDiff = cNext.getDepth () - cCurrent.getDepth (); // signed!
-      double ratio = tDiff / tSpan;
-
-      NS_LOG_DEBUG ("circleDist=" << circleDist << "; depthDiff=" << depthDiff << "; ratio=" << ratio);
+      NS_LOG_DEBUG ("angularDist=" << m_leg.GetAngularDistance () << "; depthDiff=" << m_leg.GetDepthDiff () << "; ratio=" << ratio);
 
       NS_ASSERT (ratio <= 1.0);
 
-      woss::Coord cNew = cCurrent;
-      double newDepth = cCurrent.getDepth ();
-
-      if (circleDist > 0.0)
-        {
-          cNew = woss::Coord::getCoordAlongGreatCircle (cCurrent, cNext, ratio * circleDist);
-        }
-
-      if (depthDiff != 0.0)
-        {
-          newDepth += ratio * (depthDiff);
-        }
-
-      NS_LOG_DEBUG ("cNew=" << cNew << "; newDepth=" << newDepth);
-
-      woss::CoordZ czNew = woss::CoordZ (cNew, newDepth);
+      woss::CoordZ czNew = m_leg.GetCoordZ (ratio);
 
       NS_LOG_DEBUG ("czNew=" << czNew);
 
@@ -168,6 +146,34 @@ WossWaypointMobilityModel::Update (void) const
     }
 }
 
+void
+WossWaypointMobilityModel::UpdateLeg (void) const
+{
+  if (m_isLegValid == true && m_legEnd.time == m_next.time && m_legEnd.position == m_next.position)
+    {
+      return;
+    }
+
+  // one geodetic conversion per leg end point, instead of two per Update ()
+  woss::CoordZ cCurrent = woss::CoordZ::getCoordZFromCartesianCoords (m_current.position.x,
+                                                                      m_current.position.y,
+                                                                      m_current.position.z,
+                                                                      woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84
+                                                                     );
+
+  woss::CoordZ cNext = woss::CoordZ::getCoordZFromCartesianCoords (m_next.position.x,
+                                                                   m_next.position.y,
+                                                                   m_next.position.z,
+                                                                   woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84
+                                                                  );
+
+  NS_LOG_DEBUG ("new leg: cCurrent=" << cCurrent << "; cNext=" << cNext);
+
+  m_leg = WossGreatCircleLeg (cCurrent, cNext);
+  m_legStartTime = m_current.time;
+  m_legEnd = m_next;
+  m_isLegValid = true;
+}
 
 } // namespace ns3
 
@@ -25,6 +25,7 @@
 
 
 #include "ns3/waypoint-mobility-model.h"
+#include "woss-great-circle.h"
 
 
 namespace ns3 {
@@ -49,7 +50,7 @@ public:
    */
   static TypeId GetTypeId (void);
 
-  WossWaypointMobilityModel () = default; //!< Default constructor
+  WossWaypointMobilityModel (); //!< Default constructor
 
   virtual ~WossWaypointMobilityModel () = default; //!< Default destructor
 
@@ -60,6 +61,15 @@ private:
   virtual void Update (void) const override;
   virtual void DoDispose (void) override;
 
+  /**
+   * Recomputes the current leg if m_next has changed since the last computation
+   */
+  void UpdateLeg (void) const;
+
+  mutable WossGreatCircleLeg m_leg; //!< precomputed great circle leg from m_legStartTime to m_next
+  mutable Time m_legStartTime; //!< time of the leg start
+  mutable Waypoint m_legEnd; //!< waypoint the leg has been computed for
+  mutable bool m_isLegValid; //!< true if m_leg has been computed at least once
 
 };
 
@@ -40,6 +40,23 @@
 #include "ns3/boolean.h"
 #include "ns3/integer.h"
 #include "ns3/string.h"
+#include "ns3/woss-stub-creator.h"
+#include "ns3/woss-grid-field.h"
+#include "ns3/woss-pdp-kernel.h"
+#include "ns3/woss-profiler.h"
+#include "ns3/woss-location.h"
+#include "ns3/woss-phy-calc-sinr.h"
+#include "ns3/woss-tiled-db-manager.h"
+#include "ns3/woss-waypoint-mobility-model.h"
+#include "ns3/woss-geo-waypoint-mobility-model.h"
+#include "ns3/woss-great-circle.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -425,6 +442,2206 @@ WossTest::DoRun (void)
 }
 
 
+/**
+ * \ingroup woss
+ *
+ * WOSS stub creator test
+ *
+ * It checks that the WossStub channel simulator is deterministic, reciprocal,
+ * and that the first arrival is the direct path
+ */
+class WossStubTest : public TestCase
+{
+public:
+  WossStubTest ();
+
+  virtual void DoRun (void);
+};
+
+WossStubTest::WossStubTest ()
+  : TestCase ("WOSS stub creator")
+{
+}
+
+void
+WossStubTest::DoRun (void)
+{
+  WossStubCreator creator;
+  creator.SetWaterDepth (100.0);
+  creator.SetSoundSpeed (1500.0);
+
+  woss::CoordZ txCoordz (42.59, 10.125, 30.0);
+  woss::CoordZ rxCoordz (woss::Coord::getCoordFromBearing (txCoordz, M_PI / 2.0, 1000.0), 60.0);
+  woss::Time simTime;
+
+  auto wossStub = creator.createWoss (txCoordz, rxCoordz, simTime, simTime, 22000.0, 22000.0);
+  auto wossReverse = creator.createWoss (rxCoordz, txCoordz, simTime, simTime, 22000.0, 22000.0);
+  wossStub->run ();
+  wossReverse->run ();
+
+  NS_TEST_ASSERT_MSG_EQ (creator.GetCreatedWossCount (), 2, "Unexpected number of created WossStub objects");
+
+  auto timeArr = wossStub->getWossTimeArr (22000.0, 30.0, 60.0, 1000.0, 60.0, 1000.0);
+  auto timeArrReverse = wossReverse->getWossTimeArr (22000.0, 60.0, 30.0, 1000.0, 30.0, 1000.0);
+
+  NS_TEST_ASSERT_MSG_GT (timeArr->size (), 1, "Multipath arrivals expected");
+  NS_TEST_ASSERT_MSG_EQ (timeArr->size (), timeArrReverse->size (), "Channel is not reciprocal");
+
+  double range = txCoordz.getGreatCircleDistance (rxCoordz);
+  double directDelay = std::sqrt (range * range + 30.0 * 30.0) / 1500.0;
+  double firstDelay = timeArr->begin ()->first;
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (firstDelay, directDelay, 1.0E-6, "First arrival is not the direct path");
+  NS_TEST_ASSERT_MSG_EQ_TOL (std::abs (timeArr->begin ()->second), std::abs (timeArrReverse->begin ()->second),
+                             1.0E-12, "Direct path amplitude is not reciprocal");
+}
+
+/**
+ * \ingroup woss
+ *
+ * WOSS bulk position allocation test
+ *
+ * It checks that WossGridPositionAllocator::GetNextN, single and multi threaded,
+ * returns the same positions of repeated GetNext calls, for both layouts
+ */
+class WossPositionAllocatorTest : public TestCase
+{
+public:
+  WossPositionAllocatorTest ();
+
+  virtual void DoRun (void);
+};
+
+WossPositionAllocatorTest::WossPositionAllocatorTest ()
+  : TestCase ("WOSS bulk position allocation")
+{
+}
+
+void
+WossPositionAllocatorTest::DoRun (void)
+{
+  const uint32_t count = 5000;
+
+  for (auto layout : {WossGridPositionAllocator::ROW_FIRST, WossGridPositionAllocator::COLUMN_FIRST})
+    {
+      for (uint32_t threads : {1, 4})
+        {
+          Ptr<WossGridPositionAllocator> singleAlloc = CreateObject<WossGridPositionAllocator> ();
+          Ptr<WossGridPositionAllocator> bulkAlloc = CreateObject<WossGridPositionAllocator> ();
+
+          for (auto alloc : {singleAlloc, bulkAlloc})
+            {
+              alloc->SetMinLatitude (42.59);
+              alloc->SetMinLongitude (10.125);
+              alloc->SetDepth (70.0);
+              alloc->SetDeltaLatitude (100.0);
+              alloc->SetDeltaLongitude (150.0);
+              alloc->SetN (70);
+              alloc->SetLayoutType (layout);
+            }
+
+          // the bulk allocation must continue from the current index
+          singleAlloc->GetNext ();
+          bulkAlloc->GetNext ();
+
+          std::vector<Vector> positions = bulkAlloc->GetNextN (count, threads);
+
+          NS_TEST_ASSERT_MSG_EQ (positions.size (), count, "Unexpected number of positions");
+
+          for (uint32_t i = 0; i < count; ++i)
+            {
+              Vector expected = singleAlloc->GetNext ();
+
+              NS_TEST_ASSERT_MSG_EQ ((positions[i] == expected), true, "GetNextN differs from GetNext at index " << i + 1
+                                     << ", layout " << layout << ", threads " << threads);
+            }
+
+          NS_TEST_ASSERT_MSG_EQ ((bulkAlloc->GetNext () == singleAlloc->GetNext ()), true, "GetNext differs after GetNextN");
+        }
+    }
+}
+
+/**
+ * \ingroup woss
+ *
+ * WOSS bathymetry aware position allocation test
+ *
+ * The synthetic bathymetry is a seafloor sloping from 100 m at 10.2 degrees of longitude down by 10 m every 0.001
+ * degrees westwards, with land east of 10.2 degrees: a tile spans about 40 m of depth.
+ * It checks that all the positions are in water at the configured altitude above the seafloor at the position,
+ * that land tiles are rejected from the cache without further bathymetry queries, that water positions of a
+ * coastal tile whose center is on land are kept, and that AssignStreams reaches the inner allocator.
+ */
+class WossBathymetryPositionAllocatorTest : public TestCase
+{
+public:
+  WossBathymetryPositionAllocatorTest ();
+
+  virtual void DoRun (void);
+
+  /**
+   * Synthetic bathymetry
+   * \param coord the geographic coordinates
+   * \returns the seafloor depth in meters, -1 on land
+   */
+  static double GetTestBathymetry (const woss::Coord &coord);
+
+  static uint32_t s_bathymetryQueries; //!< number of GetTestBathymetry calls
+};
+
+uint32_t WossBathymetryPositionAllocatorTest::s_bathymetryQueries = 0;
+
+WossBathymetryPositionAllocatorTest::WossBathymetryPositionAllocatorTest ()
+  : TestCase ("WOSS bathymetry aware position allocation")
+{
+}
+
+double
+WossBathymetryPositionAllocatorTest::GetTestBathymetry (const woss::Coord &coord)
+{
+  s_bathymetryQueries++;
+
+  return (coord.getLongitude () < 10.2) ? 100.0 + 10000.0 * (10.2 - coord.getLongitude ()) : -1.0;
+}
+
+void
+WossBathymetryPositionAllocatorTest::DoRun (void)
+{
+  Ptr<WossRandomRectanglePositionAllocator> innerAlloc = CreateObject<WossRandomRectanglePositionAllocator> ();
+  innerAlloc->SetLatitude (CreateObjectWithAttributes<UniformRandomVariable> ("Min", DoubleValue (42.5), "Max", DoubleValue (42.6)));
+  innerAlloc->SetLongitude (CreateObjectWithAttributes<UniformRandomVariable> ("Min", DoubleValue (10.1), "Max", DoubleValue (10.3)));
+  innerAlloc->SetDepth (0.0);
+
+  Ptr<WossBathymetryPositionAllocator> alloc = CreateObject<WossBathymetryPositionAllocator> ();
+  alloc->SetInnerAllocator (innerAlloc);
+  alloc->SetAltitude (CreateObjectWithAttributes<UniformRandomVariable> ("Min", DoubleValue (5.0), "Max", DoubleValue (20.0)));
+  alloc->SetBathymetryCallback (MakeCallback (&WossBathymetryPositionAllocatorTest::GetTestBathymetry));
+
+  double tileSize = 1.0 / 240.0;
+  alloc->SetAttribute ("TileSize", DoubleValue (tileSize));
+
+  for (uint32_t i = 0; i < 200; ++i)
+    {
+      Vector position = alloc->GetNext ();
+      woss::CoordZ coordz = woss::CoordZ::getCoordZFromCartesianCoords (position.x, position.y, position.z,
+                                                                        woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+      double altitude = 100.0 + 10000.0 * (10.2 - coordz.getLongitude ()) - coordz.getDepth ();
+
+      NS_TEST_ASSERT_MSG_LT (coordz.getLongitude (), 10.2, "Position allocated on land");
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (altitude, 5.0 - 1.0E-2, "Position too close to the seafloor");
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (altitude, 20.0 + 1.0E-2, "Position too far from the seafloor");
+    }
+
+  NS_TEST_ASSERT_MSG_GT (alloc->GetRejectedCount (), 0, "Land positions should have been rejected");
+
+  // water and land positions alternate inside one water tile and one land tile
+  Ptr<WossListPositionAllocator> listAlloc = CreateObject<WossListPositionAllocator> ();
+  listAlloc->Add (woss::CoordZ (42.551, 10.1510, 0.0));
+  listAlloc->Add (woss::CoordZ (42.551, 10.2510, 0.0));
+  listAlloc->Add (woss::CoordZ (42.551, 10.1512, 0.0));
+  listAlloc->Add (woss::CoordZ (42.551, 10.2512, 0.0));
+  listAlloc->Add (woss::CoordZ (42.551, 10.1514, 0.0));
+
+  Ptr<WossBathymetryPositionAllocator> tileAlloc = CreateObject<WossBathymetryPositionAllocator> ();
+  tileAlloc->SetInnerAllocator (listAlloc);
+  tileAlloc->SetAltitude (CreateObjectWithAttributes<ConstantRandomVariable> ("Constant", DoubleValue (10.0)));
+  tileAlloc->SetBathymetryCallback (MakeCallback (&WossBathymetryPositionAllocatorTest::GetTestBathymetry));
+  tileAlloc->SetAttribute ("TileSize", DoubleValue (tileSize));
+
+  s_bathymetryQueries = 0;
+
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      tileAlloc->GetNext ();
+    }
+
+  // five queries per tile (center and corners) plus one per accepted position
+  NS_TEST_ASSERT_MSG_EQ (tileAlloc->GetTileCacheSize (), 2, "Unexpected number of cached tiles");
+  NS_TEST_ASSERT_MSG_EQ (tileAlloc->GetRejectedCount (), 2, "Land positions not rejected");
+  NS_TEST_ASSERT_MSG_EQ (s_bathymetryQueries, 13, "Tile cache not hit");
+
+  // the tile spanning 10.1875 to 10.21875 degrees has its center on land and its western corners in water
+  Ptr<WossListPositionAllocator> coastAlloc = CreateObject<WossListPositionAllocator> ();
+  coastAlloc->Add (woss::CoordZ (42.551, 10.21, 0.0));
+  coastAlloc->Add (woss::CoordZ (42.551, 10.19, 0.0));
+
+  Ptr<WossBathymetryPositionAllocator> coastTileAlloc = CreateObject<WossBathymetryPositionAllocator> ();
+  coastTileAlloc->SetInnerAllocator (coastAlloc);
+  coastTileAlloc->SetAltitude (CreateObjectWithAttributes<ConstantRandomVariable> ("Constant", DoubleValue (10.0)));
+  coastTileAlloc->SetBathymetryCallback (MakeCallback (&WossBathymetryPositionAllocatorTest::GetTestBathymetry));
+  coastTileAlloc->SetAttribute ("TileSize", DoubleValue (1.0 / 32.0));
+
+  Vector coastPosition = coastTileAlloc->GetNext ();
+  woss::CoordZ coastCoordz = woss::CoordZ::getCoordZFromCartesianCoords (coastPosition.x, coastPosition.y, coastPosition.z,
+                                                                         woss::CoordZ::CoordZSpheroidType::COORDZ_WGS84);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (coastCoordz.getLongitude (), 10.19, 1.0E-6, "Water position of a coastal tile rejected");
+  NS_TEST_ASSERT_MSG_EQ_TOL (coastCoordz.getDepth (), 190.0, 5.0E-2, "Wrong depth in a coastal tile");
+  NS_TEST_ASSERT_MSG_EQ (coastTileAlloc->GetRejectedCount (), 1, "Land position of a coastal tile accepted");
+
+  // one stream for the altitude, one for each of the latitude and longitude of the inner allocator
+  NS_TEST_ASSERT_MSG_EQ (alloc->AssignStreams (10), 3, "Streams of the inner allocator not assigned");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS gridded field test
+ *
+ * A 3 x 3 bathymetry grid, with a missing node, is imported from CSV, saved as a binary raster and imported again.
+ * It checks the bilinear interpolation, the handling of missing nodes and of coordinates outside the grid.
+ */
+class WossGridFieldTest : public TestCase
+{
+public:
+  WossGridFieldTest ();
+
+  virtual void DoRun (void);
+};
+
+WossGridFieldTest::WossGridFieldTest ()
+  : TestCase ("WOSS gridded field")
+{
+}
+
+void
+WossGridFieldTest::DoRun (void)
+{
+  std::string csvFile = CreateTempDirFilename ("woss-grid-field.csv");
+  std::string binFile = CreateTempDirFilename ("woss-grid-field.bin");
+
+  std::ofstream out (csvFile);
+  out << "# latMin, lonMin, latStep, lonStep, nLat, nLon, nDepth\n"
+      << "42.0, 10.0, 0.1, 0.1, 3, 3, 0\n"
+      << "100, 200, 300\n"
+      << "100, 200, 300\n"
+      << "nan, 200, 300\n";
+  out.close ();
+
+  WossGridField csvField;
+  NS_TEST_ASSERT_MSG_EQ (csvField.Import (csvFile), true, "CSV grid not imported");
+  NS_TEST_ASSERT_MSG_EQ (csvField.IsProfile (), false, "2-D grid imported as 3-D");
+  NS_TEST_ASSERT_MSG_EQ (csvField.SaveBinary (binFile), true, "binary raster not saved");
+
+  WossGridField binField;
+  NS_TEST_ASSERT_MSG_EQ (binField.Import (binFile), true, "binary raster not imported");
+
+  for (const WossGridField *field : { &csvField, &binField })
+    {
+      double value = 0.0;
+
+      NS_TEST_ASSERT_MSG_EQ (field->GetValue (woss::Coord (42.05, 10.05), value), true, "value not found");
+      NS_TEST_ASSERT_MSG_EQ_TOL (value, 150.0, 1.0E-3, "wrong bilinear interpolation");
+
+      NS_TEST_ASSERT_MSG_EQ (field->GetValue (woss::Coord (42.2, 10.2), value), true, "value not found");
+      NS_TEST_ASSERT_MSG_EQ_TOL (value, 300.0, 1.0E-3, "wrong value on the grid corner");
+
+      // the missing node is excluded and the remaining weights renormalized
+      NS_TEST_ASSERT_MSG_EQ (field->GetValue (woss::Coord (42.15, 10.05), value), true, "value not found");
+      NS_TEST_ASSERT_MSG_EQ_TOL (value, 500.0 / 3.0, 1.0E-3, "missing node not excluded");
+
+      NS_TEST_ASSERT_MSG_EQ (field->GetValue (woss::Coord (42.2, 10.0), value), false, "missing node returned");
+      NS_TEST_ASSERT_MSG_EQ (field->GetValue (woss::Coord (42.3, 10.1), value), false, "value outside the grid");
+    }
+}
+
+/**
+ * WossPropModel exposing the protected PDP conversion and delay search
+ */
+class WossDelayPropModel : public WossPropModel
+{
+public:
+  using WossPropModel::CreateUanPdp;
+  using WossPropModel::GetFirstTapDelay;
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS delay fast path test
+ *
+ * Sparse arrivals, spanning many symbols, are converted into a PDP.
+ * It checks that WossPropModel::GetFirstTapDelay returns the delay of the first PDP tap below each threshold.
+ */
+class WossDelayTest : public TestCase
+{
+public:
+  WossDelayTest ();
+
+  virtual void DoRun (void);
+};
+
+WossDelayTest::WossDelayTest ()
+  : TestCase ("WOSS delay fast path")
+{
+}
+
+void
+WossDelayTest::DoRun (void)
+{
+  const double symbolTime = 1.0 / 200.0;
+  Ptr<WossDelayPropModel> wossProp = CreateObject<WossDelayPropModel> ();
+
+  woss::TimeArr timeArr;
+  timeArr.insertValue (0.6667, std::polar (1.0E-5, 0.1));
+  timeArr.insertValue (0.6667 + 7 * symbolTime, std::polar (1.0E-3, 0.5));
+  timeArr.insertValue (0.6667 + 40 * symbolTime, std::polar (1.0E-2, 1.2));
+  timeArr.insertValue (0.6667 + 95 * symbolTime, std::polar (2.0E-4, 2.0));
+
+  UanPdp pdp = wossProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr.clone ()), symbolTime);
+
+  for (double chAttThresDb : { -100.0, 30.0, 45.0, 70.0, 120.0 })
+    {
+      // reference: first PDP tap below the threshold
+      UanPdp::Iterator it = pdp.GetBegin ();
+      Time expected = it->GetDelay ();
+
+      for (; it != pdp.GetEnd (); ++it)
+        {
+          double attChDb = -20.0 * std::log10 (std::abs (it->GetAmp ()));
+
+          if ( (attChDb < 0.0) || (attChDb <= chAttThresDb) )
+            {
+              expected = it->GetDelay ();
+              break;
+            }
+        }
+
+      Time delay = wossProp->GetFirstTapDelay (timeArr, symbolTime, chAttThresDb);
+
+      NS_TEST_ASSERT_MSG_EQ_TOL (delay.GetSeconds (), expected.GetSeconds (), 1.0E-9,
+                                 "wrong delay with threshold " << chAttThresDb << " dB");
+    }
+}
+
+/**
+ * \ingroup woss
+ *
+ * WOSS PDP kernel test
+ *
+ * The same taps are stored in a dense PDP, zero filled at symbol time, and in a sparse PDP.
+ * It checks the window energies of both kernels against the tap sums, and the kernel registry lifetime.
+ */
+class WossPdpKernelTest : public TestCase
+{
+public:
+  WossPdpKernelTest ();
+
+  virtual void DoRun (void);
+};
+
+WossPdpKernelTest::WossPdpKernelTest ()
+  : TestCase ("WOSS PDP kernel")
+{
+}
+
+void
+WossPdpKernelTest::DoRun (void)
+{
+  const double symbolTime = 1.0 / 4800.0;
+  const double firstDelay = 0.66671234;
+
+  std::vector<Tap> denseTaps;
+  std::vector<Tap> sparseTaps;
+
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      std::complex<double> amp (0.0, 0.0);
+
+      if (i % 37 == 0)
+        {
+          amp = std::polar (1.0 / (1.0 + i), 0.3 * i);
+          sparseTaps.push_back (Tap (Seconds (firstDelay + i * symbolTime), amp));
+        }
+
+      denseTaps.push_back (Tap (Seconds (firstDelay + i * symbolTime), amp));
+    }
+
+  UanPdp densePdp (denseTaps, Seconds (symbolTime));
+  UanPdp sparsePdp (sparseTaps, Seconds (symbolTime));
+
+  WossPdpKernel denseKernel (densePdp);
+  WossPdpKernel sparseKernel (sparsePdp);
+
+  NS_TEST_ASSERT_MSG_EQ (denseKernel.GetMaxTapDelay (), Seconds (firstDelay), "wrong strongest tap");
+  NS_TEST_ASSERT_MSG_EQ_TOL (denseKernel.GetTotalEnergy (), sparseKernel.GetTotalEnergy (), 1.0E-12, "wrong total energy");
+
+  for (double start : { 0.0, firstDelay, firstDelay + 37 * symbolTime, firstDelay + 0.1, firstDelay + 0.3 })
+    {
+      for (double window : { symbolTime, 0.05, 1.0 })
+        {
+          double expected = 0.0;
+
+          for (const Tap &tap : sparseTaps)
+            {
+              if (tap.GetDelay () >= Seconds (start) && tap.GetDelay () < Seconds (start + window))
+                {
+                  expected += std::norm (tap.GetAmp ());
+                }
+            }
+
+          NS_TEST_ASSERT_MSG_EQ_TOL (denseKernel.GetWindowEnergy (Seconds (start), Seconds (start + window)), expected,
+                                     1.0E-12, "wrong dense window energy, start " << start << " window " << window);
+          NS_TEST_ASSERT_MSG_EQ_TOL (sparseKernel.GetWindowEnergy (Seconds (start), Seconds (start + window)), expected,
+                                     1.0E-12, "wrong sparse window energy, start " << start << " window " << window);
+        }
+    }
+
+  WossPdpKernelRegistry::Clear ();
+
+  Ptr<Packet> packet = Create<Packet> (100);
+  WossPdpKernelRegistry::Publish (packet, std::make_shared<const WossPdpKernel> (sparsePdp));
+
+  NS_TEST_ASSERT_MSG_EQ ( (WossPdpKernelRegistry::Lookup (packet) != nullptr), true, "kernel not published");
+  NS_TEST_ASSERT_MSG_EQ ( (WossPdpKernelRegistry::Lookup (packet->Copy ()) == nullptr), true, "kernel of another packet");
+
+  WossPdpKernelRegistry::Purge ();
+  NS_TEST_ASSERT_MSG_EQ (WossPdpKernelRegistry::GetSize (), 1, "referenced packet purged");
+
+  packet = nullptr;
+  WossPdpKernelRegistry::Purge ();
+  NS_TEST_ASSERT_MSG_EQ (WossPdpKernelRegistry::GetSize (), 0, "unreferenced packet not purged");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS great circle test
+ *
+ * It checks angular distance, initial bearing and intermediate points against closed form cases
+ * (equator and meridian legs) and against the LAX to JFK example of the Aviation Formulary.
+ */
+class WossGreatCircleTest : public TestCase
+{
+public:
+  WossGreatCircleTest ();
+
+  virtual void DoRun (void);
+};
+
+WossGreatCircleTest::WossGreatCircleTest ()
+  : TestCase ("WOSS great circle")
+{
+}
+
+void
+WossGreatCircleTest::DoRun (void)
+{
+  WossGreatCircleLeg equator (woss::CoordZ (0.0, 0.0, 10.0), woss::CoordZ (0.0, 90.0, 30.0));
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (equator.GetAngularDistance (), M_PI / 2.0, 1.0E-12, "wrong equator angular distance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (equator.GetInitialBearing (), M_PI / 2.0, 1.0E-12, "wrong equator bearing");
+  NS_TEST_ASSERT_MSG_EQ_TOL (equator.GetCoordZ (0.5).getLatitude (), 0.0, 1.0E-9, "wrong equator midpoint latitude");
+  NS_TEST_ASSERT_MSG_EQ_TOL (equator.GetCoordZ (0.5).getLongitude (), 45.0, 1.0E-9, "wrong equator midpoint longitude");
+  NS_TEST_ASSERT_MSG_EQ_TOL (equator.GetCoordZ (0.5).getDepth (), 20.0, 1.0E-9, "wrong midpoint depth");
+
+  WossGreatCircleLeg meridian (woss::CoordZ (0.0, 10.0, 0.0), woss::CoordZ (45.0, 10.0, 0.0));
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (meridian.GetAngularDistance (), M_PI / 4.0, 1.0E-12, "wrong meridian angular distance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (meridian.GetInitialBearing (), 0.0, 1.0E-12, "wrong meridian bearing");
+  NS_TEST_ASSERT_MSG_EQ_TOL (meridian.GetCoordZ (0.5).getLatitude (), 22.5, 1.0E-9, "wrong meridian midpoint latitude");
+  NS_TEST_ASSERT_MSG_EQ_TOL (meridian.GetCoordZ (0.5).getLongitude (), 10.0, 1.0E-9, "wrong meridian midpoint longitude");
+
+  // LAX (33 57'N, 118 24'W) to JFK (40 38'N, 73 47'W): 0.623585 rad (2144 nm), initial course 65.892 degrees,
+  // 40% of the way at 38 40.167'N, 101 37.7'W
+  woss::CoordZ lax (33.0 + 57.0 / 60.0, -(118.0 + 24.0 / 60.0), 0.0);
+  woss::CoordZ jfk (40.0 + 38.0 / 60.0, -(73.0 + 47.0 / 60.0), 0.0);
+  WossGreatCircleLeg leg (lax, jfk);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (leg.GetAngularDistance (), 0.623585, 1.0E-6, "wrong LAX-JFK angular distance");
+  NS_TEST_ASSERT_MSG_EQ_TOL (leg.GetInitialBearing () * 180.0 / M_PI, 65.892, 1.0E-3, "wrong LAX-JFK initial bearing");
+
+  woss::CoordZ point = leg.GetCoordZ (0.4);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (point.getLatitude (), 38.0 + 40.167 / 60.0, 1.0E-3, "wrong LAX-JFK intermediate latitude");
+  NS_TEST_ASSERT_MSG_EQ_TOL (point.getLongitude (), -(101.0 + 37.7 / 60.0), 5.0E-3, "wrong LAX-JFK intermediate longitude");
+
+  // the intermediate point lies on the great circle
+  double distance = leg.GetDistance ();
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (lax.getGreatCircleDistance (point) / distance, 0.4, 1.0E-4, "intermediate point not on the leg");
+  NS_TEST_ASSERT_MSG_EQ_TOL (point.getGreatCircleDistance (jfk) / distance, 0.6, 1.0E-4, "intermediate point not on the leg");
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (leg.GetCoordZ (0.0).getGreatCircleDistance (lax), 0.0, 1.0E-6, "wrong leg start");
+  NS_TEST_ASSERT_MSG_EQ_TOL (leg.GetCoordZ (1.0).getGreatCircleDistance (jfk), 0.0, 1.0E-6, "wrong leg end");
+}
+
+/**
+ * \ingroup woss
+ *
+ * WOSS geodetic waypoint mobility test
+ *
+ * A node follows a single great circle leg. It checks position, velocity and remaining waypoints
+ * before, during and after the leg.
+ */
+class WossGeoWaypointMobilityTest : public TestCase
+{
+public:
+  WossGeoWaypointMobilityTest ();
+
+  virtual void DoRun (void);
+};
+
+WossGeoWaypointMobilityTest::WossGeoWaypointMobilityTest ()
+  : TestCase ("WOSS geodetic waypoint mobility")
+{
+}
+
+void
+WossGeoWaypointMobilityTest::DoRun (void)
+{
+  woss::CoordZ start (42.59, 10.125, 20.0);
+  woss::CoordZ end (42.65, 10.25, 60.0);
+  WossGreatCircleLeg leg (start, end);
+
+  Ptr<WossGeoWaypointMobilityModel> mob = CreateObject<WossGeoWaypointMobilityModel> ();
+  mob->AddWaypoint (Seconds (10.0), start);
+  mob->AddWaypoint (Seconds (110.0), end);
+
+  Simulator::Schedule (Seconds (5.0), [this, mob, start] ()
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetCoordZ ().getGreatCircleDistance (start), 0.0, 1.0E-6, "node moved before the first waypoint");
+      NS_TEST_EXPECT_MSG_EQ (mob->WaypointsLeft (), 1, "wrong waypoints left before the leg");
+    });
+
+  Simulator::Schedule (Seconds (50.0), [this, mob, leg] ()
+    {
+      woss::CoordZ expected = leg.GetCoordZ (0.4);
+      woss::CoordZ coordZ = mob->GetCoordZ ();
+
+      NS_TEST_EXPECT_MSG_EQ_TOL (coordZ.getLatitude (), expected.getLatitude (), 1.0E-9, "wrong interpolated latitude");
+      NS_TEST_EXPECT_MSG_EQ_TOL (coordZ.getLongitude (), expected.getLongitude (), 1.0E-9, "wrong interpolated longitude");
+      NS_TEST_EXPECT_MSG_EQ_TOL (coordZ.getDepth (), 36.0, 1.0E-9, "wrong interpolated depth");
+      NS_TEST_EXPECT_MSG_EQ (mob->WaypointsLeft (), 0, "wrong waypoints left during the leg");
+
+      Vector position = mob->GetPosition ();
+      Vector expectedPosition = leg.GetCartesian (0.4);
+      NS_TEST_EXPECT_MSG_LT (CalculateDistance (position, expectedPosition), 1.0E-3, "wrong cartesian position");
+
+      // the leg is covered at a constant cartesian velocity
+      Vector velocity = mob->GetVelocity ();
+      double expectedSpeed = CalculateDistance (leg.GetCartesian (0.0), leg.GetCartesian (1.0)) / 100.0;
+      NS_TEST_EXPECT_MSG_EQ_TOL (velocity.GetLength (), expectedSpeed, 1.0E-9, "wrong leg speed");
+    });
+
+  Simulator::Schedule (Seconds (150.0), [this, mob, end] ()
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetCoordZ ().getGreatCircleDistance (end), 0.0, 1.0E-6, "node not at the last waypoint");
+      NS_TEST_EXPECT_MSG_EQ_TOL (mob->GetCoordZ ().getDepth (), 60.0, 1.0E-9, "wrong depth at the last waypoint");
+      NS_TEST_EXPECT_MSG_EQ (mob->GetVelocity ().GetLength (), 0.0, "node still moving after the last waypoint");
+    });
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS waypoint mobility test
+ *
+ * A node follows two great circle legs given as cartesian waypoints. Positions are queried several times per leg,
+ * so the cached leg of WossWaypointMobilityModel::UpdateLeg is reused and replaced at each waypoint.
+ * It checks the positions against the great circle interpolation of the geodetic waypoints.
+ */
+class WossWaypointMobilityTest : public TestCase
+{
+public:
+  WossWaypointMobilityTest ();
+
+  virtual void DoRun (void);
+};
+
+WossWaypointMobilityTest::WossWaypointMobilityTest ()
+  : TestCase ("WOSS waypoint mobility")
+{
+}
+
+void
+WossWaypointMobilityTest::DoRun (void)
+{
+  woss::CoordZ first (42.59, 10.125, 20.0);
+  woss::CoordZ second (42.65, 10.25, 60.0);
+  woss::CoordZ third (42.55, 10.3, 40.0);
+  WossGreatCircleLeg firstLeg (first, second);
+  WossGreatCircleLeg secondLeg (second, third);
+
+  Ptr<WossWaypointMobilityModel> mob = CreateObject<WossWaypointMobilityModel> ();
+  mob->AddWaypoint (Waypoint (Seconds (0.0), CreateVectorFromCoordZ (first)));
+  mob->AddWaypoint (Waypoint (Seconds (100.0), CreateVectorFromCoordZ (second)));
+  mob->AddWaypoint (Waypoint (Seconds (200.0), CreateVectorFromCoordZ (third)));
+
+  for (double time : { 0.0, 25.0, 50.0, 75.0, 100.0, 125.0, 150.0, 175.0, 200.0, 250.0 })
+    {
+      Simulator::Schedule (Seconds (time), [this, mob, time, firstLeg, secondLeg] ()
+        {
+          Vector expected;
+
+          if (time <= 100.0)
+            {
+              expected = firstLeg.GetCartesian (time / 100.0);
+            }
+          else
+            {
+              expected = secondLeg.GetCartesian (std::min (1.0, (time - 100.0) / 100.0));
+            }
+
+          NS_TEST_EXPECT_MSG_LT (CalculateDistance (mob->GetPosition (), expected), 1.0E-2,
+                                 "wrong position at " << time << "s");
+        });
+    }
+
+  Simulator::Schedule (Seconds (250.0), [this, mob] ()
+    {
+      NS_TEST_EXPECT_MSG_EQ (mob->GetVelocity ().GetLength (), 0.0, "node still moving after the last waypoint");
+      NS_TEST_EXPECT_MSG_EQ (mob->WaypointsLeft (), 0, "waypoints left after the last one");
+    });
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * WossTiledDbManager with synthetic tiles, no database is needed
+ */
+class WossTestTiledDbManager : public WossTiledDbManager
+{
+public:
+  /**
+   * Fills the tiles of the bounding box as Preload would do. The values change from tile to tile:
+   * bathymetry 100 m + tile index, SSP 1500 m/s + tile index at the surface, sediment density 1.5 + tile index.
+   * \param minCoord south west corner of the bounding box
+   * \param maxCoord north east corner of the bounding box
+   * \param sspTime time of the SSP tiles
+   */
+  void Fill (const woss::Coord &minCoord, const woss::Coord &maxCoord, const woss::Time &sspTime)
+  {
+    ClearTiles ();
+
+    m_bathyGrid = CreateGrid (minCoord, maxCoord, m_bathyTileSize);
+    m_bathyTiles.resize (m_bathyGrid.GetSize ());
+
+    for (uint32_t i = 0; i < m_bathyGrid.GetSize (); ++i)
+      {
+        m_bathyTiles[i] = 100.0 + i;
+      }
+
+    m_bathyData = m_bathyTiles.data ();
+
+    m_sspGrid = CreateGrid (minCoord, maxCoord, m_sspTileSize);
+    m_sspTiles.resize (m_sspGrid.GetSize ());
+    m_sspMonth = sspTime.getMonth ();
+    m_sspDepthPrecision = SSP_CUSTOM_DEPTH_PRECISION;
+
+    for (uint32_t i = 0; i < m_sspGrid.GetSize (); ++i)
+      {
+        m_sspTiles[i] = std::make_unique<woss::SSP> ();
+        m_sspTiles[i]->insertValue (0.0, 1500.0 + i);
+        m_sspTiles[i]->insertValue (100.0, 1490.0 + i);
+      }
+
+    m_sedimGrid = CreateGrid (minCoord, maxCoord, m_sedimTileSize);
+    m_sedimTiles.resize (m_sedimGrid.GetSize ());
+
+    for (uint32_t i = 0; i < m_sedimGrid.GetSize (); ++i)
+      {
+        m_sedimTiles[i] = std::make_unique<woss::Sediment> ("test", 1600.0, 200.0, 1.5 + i, 0.1, 0.2);
+      }
+
+    m_isPreloaded = true;
+  }
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS tiled environment and custom transect test
+ *
+ * A custom bathymetry transect is set inside a preloaded box.
+ * It checks that the custom transect is returned for its transmitter and bearing,
+ * while the tiles serve the same sample from any other transmitter.
+ */
+class WossTiledCustomDataTest : public TestCase
+{
+public:
+  WossTiledCustomDataTest ();
+
+  virtual void DoRun (void);
+};
+
+WossTiledCustomDataTest::WossTiledCustomDataTest ()
+  : TestCase ("WOSS tiled environment and custom transects")
+{
+}
+
+void
+WossTiledCustomDataTest::DoRun (void)
+{
+  WossTestTiledDbManager manager;
+  woss::Time sspTime;
+  manager.Fill (woss::Coord (42.5, 10.0), woss::Coord (42.7, 10.3), sspTime);
+
+  woss::CoordZ tx (42.55, 10.05, 10.0);
+  woss::CoordZ rx (42.6, 10.2, 10.0);
+  woss::CoordZ otherTx (42.65, 10.25, 10.0);
+
+  woss::Bathymetry tileDepth = manager.getBathymetry (otherTx, rx);
+  NS_TEST_ASSERT_MSG_EQ ((tileDepth >= 100.0), true, "tile not used");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTileHits (), 1, "tile not hit");
+
+  double range = tx.getGreatCircleDistance (rx);
+  double bearing = tx.getInitialBearing (rx);
+  manager.setCustomBathymetry (50.0, tx, bearing, range);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (tx, rx), 50.0, 1.0E-9, "custom transect shadowed by the tiles");
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (otherTx, rx), tileDepth, 1.0E-9, "tile not used for another transmitter");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTileHits (), 2, "custom transect counted as a tile hit");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTileMisses (), 1, "custom transect not forwarded to woss::WossDbManager");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS environment snapshot test
+ *
+ * Synthetic tiles are saved into a snapshot and loaded into another WossTiledDbManager.
+ * It checks that bathymetry, SSP and sediment lookups are identical, and that truncated or corrupted
+ * snapshots are rejected.
+ */
+class WossSnapshotTest : public TestCase
+{
+public:
+  WossSnapshotTest ();
+
+  virtual void DoRun (void);
+};
+
+WossSnapshotTest::WossSnapshotTest ()
+  : TestCase ("WOSS environment snapshot")
+{
+}
+
+void
+WossSnapshotTest::DoRun (void)
+{
+  std::string snapshotFile = CreateTempDirFilename ("woss-snapshot.bin");
+  std::string corruptFile = CreateTempDirFilename ("woss-snapshot-corrupt.bin");
+
+  woss::Time sspTime;
+  woss::Coord minCoord (42.5, 10.0);
+  woss::Coord maxCoord (42.7, 10.3);
+
+  WossTestTiledDbManager saved;
+  saved.Fill (minCoord, maxCoord, sspTime);
+  NS_TEST_ASSERT_MSG_EQ (saved.SaveSnapshot (snapshotFile), true, "snapshot not saved");
+
+  WossTiledDbManager loaded;
+  NS_TEST_ASSERT_MSG_EQ (loaded.LoadSnapshot (snapshotFile), true, "snapshot not loaded");
+  NS_TEST_ASSERT_MSG_EQ (loaded.IsPreloaded (), true, "snapshot tiles not in use");
+
+  woss::CoordZ tx (42.6, 10.15, 10.0);
+
+  for (double lat = 42.501; lat < 42.7; lat += 0.013)
+    {
+      for (double lon = 10.001; lon < 10.3; lon += 0.017)
+        {
+          woss::CoordZ rx (lat, lon, 10.0);
+
+          NS_TEST_ASSERT_MSG_EQ (loaded.getBathymetry (tx, rx), saved.getBathymetry (tx, rx), "different bathymetry at " << rx);
+
+          std::unique_ptr<woss::SSP> savedSsp = saved.getSSP (tx, rx, sspTime);
+          std::unique_ptr<woss::SSP> loadedSsp = loaded.getSSP (tx, rx, sspTime);
+          NS_TEST_ASSERT_MSG_EQ ((savedSsp != nullptr && loadedSsp != nullptr), true, "SSP not found at " << rx);
+
+          auto savedIt = savedSsp->begin ();
+          auto loadedIt = loadedSsp->begin ();
+
+          for (; savedIt != savedSsp->end () && loadedIt != loadedSsp->end (); ++savedIt, ++loadedIt)
+            {
+              NS_TEST_ASSERT_MSG_EQ (loadedIt->first, savedIt->first, "different SSP depth at " << rx);
+              NS_TEST_ASSERT_MSG_EQ (loadedIt->second, savedIt->second, "different SSP speed at " << rx);
+            }
+
+          NS_TEST_ASSERT_MSG_EQ ((savedIt == savedSsp->end () && loadedIt == loadedSsp->end ()), true,
+                                 "different SSP size at " << rx);
+
+          std::unique_ptr<woss::Sediment> savedSediment = saved.getSediment (tx, rx);
+          std::unique_ptr<woss::Sediment> loadedSediment = loaded.getSediment (tx, rx);
+          NS_TEST_ASSERT_MSG_EQ ((savedSediment != nullptr && loadedSediment != nullptr), true, "sediment not found at " << rx);
+          NS_TEST_ASSERT_MSG_EQ (loadedSediment->getType (), savedSediment->getType (), "different sediment type at " << rx);
+          NS_TEST_ASSERT_MSG_EQ (loadedSediment->getDensity (), savedSediment->getDensity (), "different sediment at " << rx);
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (loaded.GetTileMisses (), 0, "lookups not served by the snapshot");
+
+  std::ifstream in (snapshotFile, std::ios::binary);
+  std::string content ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  in.close ();
+
+  // the file is truncated, a tile count is out of range, the magic is wrong
+  std::string truncated = content.substr (0, content.size () / 2);
+
+  std::string overflow = content;
+  const uint32_t hugeCount = 0xFFFFFFFF;
+  const size_t bathyTileCountOffset = 48; // SnapshotHeader::bathyGrid nLat and nLon
+  std::memcpy (&overflow[bathyTileCountOffset], &hugeCount, sizeof (hugeCount));
+  std::memcpy (&overflow[bathyTileCountOffset + sizeof (hugeCount)], &hugeCount, sizeof (hugeCount));
+
+  std::string badMagic = content;
+  badMagic[0] = 'X';
+
+  for (const std::string &corrupt : { truncated, overflow, badMagic, std::string () })
+    {
+      std::ofstream out (corruptFile, std::ios::binary | std::ios::trunc);
+      out.write (corrupt.data (), corrupt.size ());
+      out.close ();
+
+      NS_TEST_ASSERT_MSG_EQ (loaded.LoadSnapshot (corruptFile), false, "corrupted snapshot of size " << corrupt.size () << " loaded");
+      NS_TEST_ASSERT_MSG_EQ (loaded.IsPreloaded (), false, "tiles left in use after a failed load");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (loaded.LoadSnapshot (CreateTempDirFilename ("woss-snapshot-missing.bin")), false, "missing snapshot loaded");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS string parsers test
+ *
+ * It feeds valid and malformed strings to WossHelper::SetAngles, SetCustomBathymetry, SetCustomSsp
+ * and SetCustomSediment, and malformed numbers to the WossGridField CSV reader.
+ * Malformed strings must be rejected without leaving partial custom data.
+ */
+class WossParserTest : public TestCase
+{
+public:
+  WossParserTest ();
+
+  virtual void DoRun (void);
+};
+
+WossParserTest::WossParserTest ()
+  : TestCase ("WOSS string parsers")
+{
+}
+
+void
+WossParserTest::DoRun (void)
+{
+  Ptr<WossPropModel> wossProp = CreateObject<WossPropModel> ();
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+  wossHelper->SetAttribute ("ResDbUseBinary", BooleanValue (false));
+  wossHelper->SetAttribute ("ResDbFilePath", StringValue ("./woss-test-output/res-db/"));
+  wossHelper->SetAttribute ("WossWorkDirPath", StringValue ("./woss-test-output/work-dir/"));
+  wossHelper->SetAttribute ("WossSimTime", StringValue ("1|10|2012|0|1|1|1|10|2012|0|1|1"));
+  wossHelper->SetAttribute ("WossUseStubCreator", BooleanValue (true));
+  wossHelper->Initialize (wossProp);
+
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->SetAngles ("-10.5|+20"), true, "valid angles rejected");
+
+  for (const char *angles : { "", "10", "10|", "10|abc", "10|20x", "1e400|0", " |20" })
+    {
+      NS_TEST_ASSERT_MSG_EQ (wossHelper->SetAngles (angles), false, "malformed angles accepted: " << angles);
+    }
+
+  woss::Coord txCoord (42.59, 10.125);
+  woss::Coord otherTxCoord (42.6, 10.13);
+  double bearing = M_PI / 4.0;
+
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomBathymetry ("+2|0.0|100.0|500.0| 1.2e2 ", txCoord, bearing), true,
+                         "valid bathymetry rejected");
+  NS_TEST_ASSERT_MSG_EQ_TOL (wossHelper->GetCustomBathymetry (txCoord, bearing, 500.0), 120.0, 1.0E-9,
+                             "wrong custom bathymetry");
+
+  for (const char *bathymetry : { "2|0|100|500", "2|0|100|abc|120", "2|0|100|500|120x", "x|0|100", "0|", "2|0|-100|500|120",
+                                  "2|0|100|500|1e400" })
+    {
+      NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomBathymetry (bathymetry, otherTxCoord, bearing), false,
+                             "malformed bathymetry accepted: " << bathymetry);
+    }
+
+  // the first pair of a rejected line must not be stored
+  NS_TEST_ASSERT_MSG_EQ ((wossHelper->GetCustomBathymetry (otherTxCoord, bearing, 0.0) != 100.0), true,
+                         "partial bathymetry transect stored");
+
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomSsp ("3|0|1508.42|10|1508.02|20|1507.71", txCoord), true, "valid SSP rejected");
+  NS_TEST_ASSERT_MSG_EQ ((wossHelper->GetCustomSsp (txCoord) != nullptr), true, "custom SSP not stored");
+
+  for (const char *ssp : { "3|0|1508.42|10|1508.02", "2|0|1508.42|10|15O8.02", "2|0|1508.42|10", "-1|0|1508.42" })
+    {
+      NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomSsp (ssp, otherTxCoord), false, "malformed SSP accepted: " << ssp);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomSediment ("TestSediment|1560.0|200.0|1.5|0.9|0.8"), true,
+                         "valid sediment rejected");
+
+  for (const char *sediment : { "TestSediment|1560.0|200.0|1.5|0.9", "TestSediment", "TestSediment|1560.0|2OO.0|1.5|0.9|0.8" })
+    {
+      NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomSediment (sediment, otherTxCoord), false,
+                             "malformed sediment accepted: " << sediment);
+    }
+
+  std::string csvFile = CreateTempDirFilename ("woss-parser-field.csv");
+
+  for (const char *header : { "42.0, 10.0, 0.1x, 0.1, 2, 2, 0\n", "42.0, 10.0, 0.1, 0.1, 2, 2.5, 0\n" })
+    {
+      std::ofstream out (csvFile);
+      out << header << "100, 200\n100, 200\n";
+      out.close ();
+
+      WossGridField field;
+      NS_TEST_ASSERT_MSG_EQ (field.Import (csvFile), false, "malformed CSV grid imported: " << header);
+    }
+
+  std::ofstream out (csvFile);
+  out << "+42.0,10.0,0.1,0.1,2,2,0\n1e2,200\n100 , nan\n";
+  out.close ();
+
+  WossGridField field;
+  double value = 0.0;
+  NS_TEST_ASSERT_MSG_EQ (field.Import (csvFile), true, "valid CSV grid rejected");
+  NS_TEST_ASSERT_MSG_EQ (field.GetValue (woss::Coord (42.0, 10.0), value), true, "value not found");
+  NS_TEST_ASSERT_MSG_EQ_TOL (value, 100.0, 1.0E-3, "wrong CSV value");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS gridded field precedence test
+ *
+ * Bathymetry and SSP fields cover part of a preloaded box, and custom transects are set for one transmitter.
+ * It checks that custom transects win over the fields, the fields over the tiles, and that field hits are
+ * counted apart from the tile hits.
+ */
+class WossGridFieldPrecedenceTest : public TestCase
+{
+public:
+  WossGridFieldPrecedenceTest ();
+
+  virtual void DoRun (void);
+};
+
+WossGridFieldPrecedenceTest::WossGridFieldPrecedenceTest ()
+  : TestCase ("WOSS gridded field precedence")
+{
+}
+
+void
+WossGridFieldPrecedenceTest::DoRun (void)
+{
+  WossTestTiledDbManager manager;
+  woss::Time sspTime;
+  manager.Fill (woss::Coord (42.5, 10.0), woss::Coord (42.7, 10.3), sspTime);
+
+  std::shared_ptr<WossGridField> bathyField = std::make_shared<WossGridField> ();
+  NS_TEST_ASSERT_MSG_EQ (bathyField->SetGrid (42.55, 10.1, 0.1, 0.1, 2, 2, {}, { 300.0f, 300.0f, 300.0f, 300.0f }),
+                         true, "bathymetry field not set");
+  manager.SetBathymetryField (bathyField);
+
+  std::shared_ptr<WossGridField> sspField = std::make_shared<WossGridField> ();
+  NS_TEST_ASSERT_MSG_EQ (sspField->SetGrid (42.55, 10.1, 0.1, 0.1, 2, 2, { 0.0, 100.0 },
+                                            { 1520.0f, 1510.0f, 1520.0f, 1510.0f, 1520.0f, 1510.0f, 1520.0f, 1510.0f }),
+                         true, "SSP field not set");
+  manager.SetSspField (sspField);
+
+  woss::CoordZ tx (42.55, 10.05, 10.0);
+  woss::CoordZ otherTx (42.65, 10.25, 10.0);
+  woss::CoordZ fieldRx (42.6, 10.15, 10.0);
+  woss::CoordZ tileRx (42.52, 10.02, 10.0);
+
+  double range = tx.getGreatCircleDistance (fieldRx);
+  double bearing = tx.getInitialBearing (fieldRx);
+  manager.setCustomBathymetry (50.0, tx, bearing, range);
+
+  woss::SSP customSsp;
+  customSsp.insertValue (0.0, 1450.0);
+  customSsp.insertValue (100.0, 1440.0);
+  manager.setCustomSSP (customSsp, tx, bearing, range, sspTime);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (tx, fieldRx), 50.0, 1.0E-9, "custom transect shadowed by the field");
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (otherTx, fieldRx), 300.0, 1.0E-3, "field not used");
+  NS_TEST_ASSERT_MSG_EQ ((manager.getBathymetry (otherTx, tileRx) >= 100.0), true, "tile not used outside the field");
+
+  std::unique_ptr<woss::SSP> ssp = manager.getSSP (tx, fieldRx, sspTime);
+  NS_TEST_ASSERT_MSG_EQ ((ssp != nullptr && ssp->isValid ()), true, "custom SSP not found");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ssp->begin ()->second, 1450.0, 1.0E-9, "custom SSP shadowed by the field");
+
+  ssp = manager.getSSP (otherTx, fieldRx, sspTime);
+  NS_TEST_ASSERT_MSG_EQ ((ssp != nullptr && ssp->isValid ()), true, "field SSP not found");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ssp->begin ()->second, 1520.0, 1.0E-3, "field SSP not used");
+
+  ssp = manager.getSSP (otherTx, tileRx, sspTime);
+  NS_TEST_ASSERT_MSG_EQ ((ssp != nullptr && ssp->isValid ()), true, "tile SSP not found");
+  NS_TEST_ASSERT_MSG_EQ ((ssp->begin ()->second >= 1500.0), true, "tile SSP not used outside the field");
+
+  NS_TEST_ASSERT_MSG_EQ (manager.GetFieldHits (), 2, "wrong field hits");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTileHits (), 2, "field hits counted as tile hits");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTileMisses (), 2, "custom transects not forwarded to woss::WossDbManager");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS transect cache test
+ *
+ * Bathymetry and SSP samples are looked up twice through the transect cache of synthetic tiles.
+ * It checks the cache hits and misses, the flush of a full cache and of ClearTransectCache, and that
+ * a custom SSP set for another time of the same month is not shadowed by the cached samples.
+ * A custom bathymetry set or erased through WossHelper after the first lookup must be visible.
+ */
+class WossTransectCacheTest : public TestCase
+{
+public:
+  WossTransectCacheTest ();
+
+  virtual void DoRun (void);
+};
+
+WossTransectCacheTest::WossTransectCacheTest ()
+  : TestCase ("WOSS transect cache")
+{
+}
+
+void
+WossTransectCacheTest::DoRun (void)
+{
+  woss::Time firstTime;
+  firstTime.setDay (1);
+  firstTime.setMonth (10);
+  firstTime.setYear (2012);
+  firstTime.setHours (0);
+  firstTime.setMinutes (0);
+  firstTime.setSeconds (0);
+
+  woss::Time secondTime = firstTime;
+  secondTime.setDay (15);
+
+  WossTestTiledDbManager manager;
+  manager.Fill (woss::Coord (42.5, 10.0), woss::Coord (42.7, 10.3), firstTime);
+  manager.SetTransectCache (1.0E-4, 3);
+
+  woss::CoordZ tx (42.55, 10.05, 10.0);
+  woss::CoordZ rx (42.6, 10.2, 10.0);
+
+  woss::Bathymetry depth = manager.getBathymetry (tx, rx);
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (tx, rx), depth, 1.0E-9, "different cached bathymetry");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheMisses (), 1, "wrong cache misses");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheHits (), 1, "wrong cache hits");
+
+  // a nearby sample falls into the same quantization step
+  woss::CoordZ nearRx (42.60001, 10.20001, 10.0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (manager.getBathymetry (tx, nearRx), depth, 1.0E-9, "nearby sample not cached");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheHits (), 2, "nearby sample not served by the cache");
+
+  manager.ClearTransectCache ();
+  manager.getBathymetry (tx, rx);
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheMisses (), 2, "cache not flushed by ClearTransectCache");
+
+  // the fourth sample overflows a cache of three samples
+  for (double lon : { 10.21, 10.22, 10.23 })
+    {
+      manager.getBathymetry (tx, woss::CoordZ (42.6, lon, 10.0));
+    }
+
+  manager.getBathymetry (tx, rx);
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheMisses (), 6, "full cache not flushed");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheHits (), 2, "hit after the flush of a full cache");
+
+  // SSP samples are keyed by the full time, not by the month
+  manager.SetTransectCache (1.0E-4, 100);
+
+  double range = tx.getGreatCircleDistance (rx);
+  double bearing = tx.getInitialBearing (rx);
+  woss::SSP customSsp;
+  customSsp.insertValue (0.0, 1450.0);
+  customSsp.insertValue (100.0, 1440.0);
+  manager.setCustomSSP (customSsp, tx, bearing, range, secondTime);
+
+  std::unique_ptr<woss::SSP> ssp = manager.getSSP (tx, rx, firstTime);
+  NS_TEST_ASSERT_MSG_EQ ((ssp != nullptr && ssp->isValid ()), true, "SSP not found");
+
+  ssp = manager.getSSP (tx, rx, firstTime);
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheHits (), 3, "SSP of the same time not cached");
+
+  ssp = manager.getSSP (tx, rx, secondTime);
+  NS_TEST_ASSERT_MSG_EQ ((ssp != nullptr && ssp->isValid ()), true, "custom SSP not found");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ssp->begin ()->second, 1450.0, 1.0E-9, "custom SSP shadowed by the SSP of the same month");
+  NS_TEST_ASSERT_MSG_EQ (manager.GetTransectCacheHits (), 3, "SSP of another time served by the cache");
+
+  // custom data set through the helper after the first lookup
+  Ptr<WossPropModel> wossProp = CreateObject<WossPropModel> ();
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+  wossHelper->SetAttribute ("ResDbUseBinary", BooleanValue (false));
+  wossHelper->SetAttribute ("ResDbFilePath", StringValue ("./woss-test-output/res-db/"));
+  wossHelper->SetAttribute ("WossWorkDirPath", StringValue ("./woss-test-output/work-dir/"));
+  wossHelper->SetAttribute ("WossSimTime", StringValue ("1|10|2012|0|1|1|1|10|2012|0|1|1"));
+  wossHelper->SetAttribute ("WossUseStubCreator", BooleanValue (true));
+  wossHelper->SetAttribute ("WossDbTransectQuantum", DoubleValue (1.0E-4));
+  wossHelper->Initialize (wossProp);
+
+  std::shared_ptr<WossTiledDbManager> helperManager = wossHelper->GetWossDbManager ();
+  std::shared_ptr<WossGridField> bathyField = std::make_shared<WossGridField> ();
+  NS_TEST_ASSERT_MSG_EQ (bathyField->SetGrid (42.55, 10.15, 0.1, 0.1, 2, 2, {}, { 300.0f, 300.0f, 300.0f, 300.0f }),
+                         true, "bathymetry field not set");
+  helperManager->SetBathymetryField (bathyField);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (helperManager->getBathymetry (tx, rx), 300.0, 1.0E-3, "field not used");
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->SetCustomBathymetry (woss::Bathymetry (50.0), tx, bearing, range), true,
+                         "custom bathymetry rejected");
+  NS_TEST_ASSERT_MSG_EQ_TOL (helperManager->getBathymetry (tx, rx), 50.0, 1.0E-9,
+                             "custom bathymetry shadowed by the cached samples");
+
+  wossHelper->EraseCustomBathymetry (tx, bearing, range);
+  NS_TEST_ASSERT_MSG_EQ_TOL (helperManager->getBathymetry (tx, rx), 300.0, 1.0E-3,
+                             "erased custom bathymetry served by the cache");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS wideband delay test
+ *
+ * The PDPs of an in-band mode are derived from the wideband arrivals of the link.
+ * It checks that GetDelay of the same mode returns the first usable tap of its wideband PDP,
+ * and that it reuses the wideband results without running the channel simulator again.
+ */
+class WossWidebandDelayTest : public TestCase
+{
+public:
+  WossWidebandDelayTest ();
+
+  virtual void DoRun (void);
+};
+
+WossWidebandDelayTest::WossWidebandDelayTest ()
+  : TestCase ("WOSS wideband delay")
+{
+}
+
+void
+WossWidebandDelayTest::DoRun (void)
+{
+  Ptr<WossPropModel> wossProp = CreateObjectWithAttributes<WossPropModel> ("WidebandStartFreq", DoubleValue (20000.0),
+                                                                           "WidebandEndFreq", DoubleValue (24000.0));
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+  wossHelper->SetAttribute ("ResDbUseBinary", BooleanValue (false));
+  wossHelper->SetAttribute ("ResDbFilePath", StringValue ("./woss-test-output/res-db/"));
+  wossHelper->SetAttribute ("WossWorkDirPath", StringValue ("./woss-test-output/work-dir/"));
+  wossHelper->SetAttribute ("WossSimTime", StringValue ("1|10|2012|0|1|1|1|10|2012|0|1|1"));
+  wossHelper->SetAttribute ("WossFrequencyStep", DoubleValue (2000.0));
+  wossHelper->SetAttribute ("WossUseStubCreator", BooleanValue (true));
+  wossHelper->Initialize (wossProp);
+
+  woss::CoordZ txCoordz (42.59, 10.125, 30.0);
+  woss::CoordZ rxCoordz (woss::Coord::getCoordFromBearing (txCoordz, M_PI / 2.0, 2000.0), 60.0);
+
+  Ptr<ConstantPositionMobilityModel> tx = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> rx = CreateObject<ConstantPositionMobilityModel> ();
+  tx->SetPosition (CreateVectorFromCoordZ (txCoordz));
+  rx->SetPosition (CreateVectorFromCoordZ (rxCoordz));
+
+  // the carrier is in the band but off its center, so the wideband gain is not unitary
+  UanTxMode mode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 2000, 2000, 21000, 2000, 4, "In-band mode");
+
+  UanPdp pdp = wossProp->GetPdp (tx, rx, mode);
+  uint64_t runs = wossHelper->GetWossStubCreator ()->GetCreatedWossCount ();
+
+  for (double chAttThresDb : { -100.0, 70.0, 120.0 })
+    {
+      UanPdp::Iterator it = pdp.GetBegin ();
+      Time expected = it->GetDelay ();
+
+      for (; it != pdp.GetEnd (); ++it)
+        {
+          double attChDb = -20.0 * std::log10 (std::abs (it->GetAmp ()));
+
+          if ( (attChDb < 0.0) || (attChDb <= chAttThresDb) )
+            {
+              expected = it->GetDelay ();
+              break;
+            }
+        }
+
+      // same coordinates of the PDP request, as converted from the node positions
+      Time delay = wossProp->GetDelay (CreateCoordZFromVector (tx->GetPosition ()), CreateCoordZFromVector (rx->GetPosition ()),
+                                       mode, chAttThresDb);
+
+      NS_TEST_ASSERT_MSG_EQ_TOL (delay.GetSeconds (), expected.GetSeconds (), 1.0E-9,
+                                 "wrong wideband delay with threshold " << chAttThresDb << " dB");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (wossHelper->GetWossStubCreator ()->GetCreatedWossCount (), runs,
+                         "wideband results not reused by GetDelay");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS frequency response test
+ *
+ * It checks that the subcarrier recurrence of WossFreqResponse::GetResponses matches GetResponse,
+ * and that the wideband response of a link is built at the band center and shared by all the in-band modes.
+ */
+class WossFreqResponseTest : public TestCase
+{
+public:
+  WossFreqResponseTest ();
+
+  virtual void DoRun (void);
+};
+
+WossFreqResponseTest::WossFreqResponseTest ()
+  : TestCase ("WOSS frequency response")
+{
+}
+
+void
+WossFreqResponseTest::DoRun (void)
+{
+  woss::TimeArr timeArr;
+  timeArr.insertValue (0.6667, std::polar (1.0E-2, 0.1));
+  timeArr.insertValue (0.6671, std::polar (5.0E-3, 0.5));
+  timeArr.insertValue (0.6702, std::polar (2.0E-3, 1.2));
+  timeArr.insertValue (0.6893, std::polar (1.0E-3, 2.0));
+
+  WossFreqResponse response (timeArr, 22000.0, 0.5);
+  NS_TEST_ASSERT_MSG_EQ (response.GetNArrivals (), 4, "wrong number of arrivals");
+
+  std::complex<double> sum (0.0, 0.0);
+
+  for (woss::TimeArrCIt it = timeArr.begin (); it != timeArr.end (); ++it)
+    {
+      sum += 0.5 * it->second;
+    }
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (std::abs (response.GetResponse (22000.0) - sum), 0.0, 1.0E-12, "wrong response at the carrier");
+
+  const double startFreq = 20000.0;
+  const double spacing = 62.5;
+  const uint32_t nSubcarriers = 65;
+  std::vector<std::complex<double> > responses = response.GetResponses (startFreq, spacing, nSubcarriers);
+  std::vector<double> gainsDb = response.GetGainsDb (startFreq, spacing, nSubcarriers);
+
+  NS_TEST_ASSERT_MSG_EQ (responses.size (), nSubcarriers, "wrong number of subcarriers");
+
+  for (uint32_t n = 0; n < nSubcarriers; ++n)
+    {
+      std::complex<double> expected = response.GetResponse (startFreq + n * spacing);
+
+      NS_TEST_ASSERT_MSG_EQ_TOL (std::abs (responses[n] - expected), 0.0, 1.0E-12, "wrong response of subcarrier " << n);
+      NS_TEST_ASSERT_MSG_EQ_TOL (gainsDb[n], 10.0 * std::log10 (std::norm (expected)), 1.0E-6, "wrong gain of subcarrier " << n);
+    }
+
+  Ptr<WossPropModel> wossProp = CreateObjectWithAttributes<WossPropModel> ("WidebandStartFreq", DoubleValue (20000.0),
+                                                                           "WidebandEndFreq", DoubleValue (24000.0),
+                                                                           "FreqResponse", BooleanValue (true));
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+  wossHelper->SetAttribute ("ResDbUseBinary", BooleanValue (false));
+  wossHelper->SetAttribute ("ResDbFilePath", StringValue ("./woss-test-output/res-db/"));
+  wossHelper->SetAttribute ("WossWorkDirPath", StringValue ("./woss-test-output/work-dir/"));
+  wossHelper->SetAttribute ("WossSimTime", StringValue ("1|10|2012|0|1|1|1|10|2012|0|1|1"));
+  wossHelper->SetAttribute ("WossUseStubCreator", BooleanValue (true));
+  wossHelper->Initialize (wossProp);
+
+  woss::CoordZ txCoordz (42.59, 10.125, 30.0);
+  Ptr<ConstantPositionMobilityModel> tx = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> rx = CreateObject<ConstantPositionMobilityModel> ();
+  tx->SetPosition (CreateVectorFromCoordZ (txCoordz));
+  rx->SetPosition (CreateVectorFromCoordZ (woss::CoordZ (woss::Coord::getCoordFromBearing (txCoordz, M_PI / 2.0, 2000.0), 60.0)));
+
+  UanTxMode lowMode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 2000, 2000, 21000, 2000, 4, "Low in-band mode");
+  UanTxMode highMode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 2000, 2000, 23000, 2000, 4, "High in-band mode");
+
+  WossFreqResponse lowResponse;
+  wossProp->GetPdp (tx, rx, lowMode);
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, lowMode, lowResponse), true, "wideband response not cached");
+  NS_TEST_ASSERT_MSG_EQ_TOL (lowResponse.GetCarrierFreq (), 22000.0, 1.0E-9, "wideband response not at the band center");
+
+  WossFreqResponse highResponse;
+  wossProp->GetPdp (tx, rx, highMode);
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, highMode, highResponse), true, "wideband response not cached");
+  NS_TEST_ASSERT_MSG_EQ (highResponse.GetNArrivals (), lowResponse.GetNArrivals (), "wideband response rebuilt");
+
+  std::vector<std::complex<double> > lowResponses = lowResponse.GetResponses (startFreq, spacing, nSubcarriers);
+  std::vector<std::complex<double> > highResponses = highResponse.GetResponses (startFreq, spacing, nSubcarriers);
+
+  for (uint32_t n = 0; n < nSubcarriers; ++n)
+    {
+      NS_TEST_ASSERT_MSG_EQ (highResponses[n], lowResponses[n], "wideband response depends on the mode at subcarrier " << n);
+    }
+
+  // out of band modes keep a response each on the same link
+  UanTxMode firstMode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 2000, 2000, 30000, 2000, 4, "First out of band mode");
+  UanTxMode secondMode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 2000, 2000, 32000, 2000, 4, "Second out of band mode");
+
+  WossFreqResponse firstResponse;
+  WossFreqResponse secondResponse;
+  wossProp->GetPdp (tx, rx, firstMode);
+  wossProp->GetPdp (tx, rx, secondMode);
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, firstMode, firstResponse), true, "first mode response overwritten");
+  NS_TEST_ASSERT_MSG_EQ_TOL (firstResponse.GetCarrierFreq (), 30000.0, 1.0E-9, "wrong carrier of the first mode response");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, secondMode, secondResponse), true, "second mode response not cached");
+  NS_TEST_ASSERT_MSG_EQ_TOL (secondResponse.GetCarrierFreq (), 32000.0, 1.0E-9, "wrong carrier of the second mode response");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, lowMode, lowResponse), true, "wideband response overwritten");
+
+  rx->SetPosition (rx->GetPosition () + Vector (10.0, 0.0, 0.0));
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetFreqResponse (tx, rx, highMode, highResponse), false, "response of an old position returned");
+}
+
+
+/**
+ * UanTransducerHd recording the time and the context of every reception delivered by the channel
+ */
+class WossRecordingTransducer : public UanTransducerHd
+{
+public:
+  /**
+   * Records the reception, the PHYs are not involved
+   * \param packet the packet
+   * \param rxPowerDb received power [dB]
+   * \param txMode the transmission mode
+   * \param pdp the power delay profile
+   */
+  virtual void Receive (Ptr<Packet> packet, double rxPowerDb, UanTxMode txMode, UanPdp pdp) override
+  {
+    m_rxTimes.push_back (Simulator::Now ());
+    m_rxContexts.push_back (Simulator::GetContext ());
+  }
+
+  std::vector<Time> m_rxTimes; //!< delivery times
+  std::vector<uint32_t> m_rxContexts; //!< delivery contexts
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS delivery test
+ *
+ * The same transmission is delivered to nodes at different ranges, one of them with two devices.
+ * It checks that every reception runs in the context of its own node, and that farther nodes receive later.
+ */
+class WossDeliveryTest : public TestCase
+{
+public:
+  WossDeliveryTest ();
+
+  virtual void DoRun (void);
+};
+
+WossDeliveryTest::WossDeliveryTest ()
+  : TestCase ("WOSS delivery")
+{
+}
+
+void
+WossDeliveryTest::DoRun (void)
+{
+  Ptr<WossPropModel> wossProp = CreateObject<WossPropModel> ();
+  Ptr<WossHelper> wossHelper = CreateObject<WossHelper> ();
+  wossHelper->SetAttribute ("ResDbUseBinary", BooleanValue (false));
+  wossHelper->SetAttribute ("ResDbFilePath", StringValue ("./woss-test-output/res-db/"));
+  wossHelper->SetAttribute ("WossWorkDirPath", StringValue ("./woss-test-output/work-dir/"));
+  wossHelper->SetAttribute ("WossSimTime", StringValue ("1|10|2012|0|1|1|1|10|2012|0|1|1"));
+  wossHelper->SetAttribute ("WossUseStubCreator", BooleanValue (true));
+  wossHelper->Initialize (wossProp);
+
+  Ptr<WossChannel> channel = CreateObjectWithAttributes<WossChannel> ("PropagationModel", PointerValue (wossProp));
+  channel->Initialize ();
+
+  woss::CoordZ txCoordz (42.59, 10.125, 30.0);
+  // the node at 1000 m has two devices
+  const double nodeRanges[] = { 0.0, 1000.0, 1100.0, 1250.0 };
+  const uint32_t nodeIndexes[] = { 0, 1, 1, 2, 3 };
+  std::vector<Ptr<Node> > nodes;
+  std::vector<Ptr<WossRecordingTransducer> > transducers;
+  std::vector<uint32_t> nodeIds;
+
+  for (double range : nodeRanges)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      woss::CoordZ coordz = (range > 0.0) ? woss::CoordZ (woss::Coord::getCoordFromBearing (txCoordz, M_PI / 2.0, range), 60.0)
+                                          : txCoordz;
+      mobility->SetPosition (CreateVectorFromCoordZ (coordz));
+      node->AggregateObject (mobility);
+      nodes.push_back (node);
+    }
+
+  for (uint32_t nodeIndex : nodeIndexes)
+    {
+      Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+      Ptr<WossRecordingTransducer> trans = CreateObject<WossRecordingTransducer> ();
+      nodes[nodeIndex]->AddDevice (dev);
+      channel->AddDevice (dev, trans);
+      transducers.push_back (trans);
+      nodeIds.push_back (nodes[nodeIndex]->GetId ());
+    }
+
+  UanTxMode mode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 200, 200, 22000, 4000, 4, "Test Mode");
+  Ptr<WossRecordingTransducer> src = transducers.front ();
+
+  Simulator::Schedule (Seconds (1.0), [channel, src, mode] ()
+    {
+      channel->TxPacket (src, Create<Packet> (17), 150.0, mode);
+    });
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (transducers.front ()->m_rxTimes.size (), 0, "transmitter received its own packet");
+
+  for (size_t i = 1; i < transducers.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (transducers[i]->m_rxTimes.size (), 1, "receiver " << i << " missed the packet");
+      NS_TEST_ASSERT_MSG_EQ (transducers[i]->m_rxContexts.front (), nodeIds[i], "wrong context of receiver " << i);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (transducers[2]->m_rxTimes.front (), transducers[1]->m_rxTimes.front (),
+                         "devices of the same node delivered at different times");
+  NS_TEST_ASSERT_MSG_GT (transducers[3]->m_rxTimes.front (), transducers[1]->m_rxTimes.front (), "farther node not delivered later");
+  NS_TEST_ASSERT_MSG_GT (transducers[4]->m_rxTimes.front (), transducers[3]->m_rxTimes.front (), "farther node not delivered later");
+}
+
+
+/**
+ * WossChannel exposing the received power and delay computation
+ */
+class WossRxPowerChannel : public WossChannel
+{
+public:
+  using WossChannel::ComputeRxPowerAndDelay;
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS sparse PDP test
+ *
+ * The same arrivals are converted into a dense and into a sparse PDP. The arrivals are tens of symbols
+ * apart, so the dense PDP is zero filled while the sparse one keeps only the non-zero taps: any code that
+ * reads taps by position instead of by delay gives different results on the two.
+ * It checks that both give the same received power and delay in WossChannel, with amplitude thresholds
+ * below the first arrival, between the first and the strongest arrival, and above all but the strongest
+ * one, and the same SINR in WossPhyCalcSinr, with and without equalizer window and interference overlap.
+ * With a zero window and no overlap the SINR must match UanPhyCalcSinrDefault on the dense PDP.
+ */
+class WossSparsePdpTest : public TestCase
+{
+public:
+  WossSparsePdpTest ();
+
+  virtual void DoRun (void);
+};
+
+WossSparsePdpTest::WossSparsePdpTest ()
+  : TestCase ("WOSS sparse PDP")
+{
+}
+
+void
+WossSparsePdpTest::DoRun (void)
+{
+  const double symbolTime = 1.0 / 200.0;
+  Ptr<WossDelayPropModel> denseProp = CreateObjectWithAttributes<WossDelayPropModel> ("SparsePdp", BooleanValue (false));
+  Ptr<WossDelayPropModel> sparseProp = CreateObjectWithAttributes<WossDelayPropModel> ("SparsePdp", BooleanValue (true));
+
+  woss::TimeArr timeArr;
+  timeArr.insertValue (0.6667, std::polar (1.0E-5, 0.1));
+  timeArr.insertValue (0.6667 + 7 * symbolTime, std::polar (1.0E-3, 0.5));
+  timeArr.insertValue (0.6667 + 40 * symbolTime, std::polar (1.0E-2, 1.2));
+  timeArr.insertValue (0.6667 + 95 * symbolTime, std::polar (2.0E-4, 2.0));
+
+  woss::TimeArr intTimeArr;
+  intTimeArr.insertValue (0.8123, std::polar (3.0E-3, 0.7));
+  intTimeArr.insertValue (0.8123 + 60 * symbolTime, std::polar (4.0E-3, 1.9));
+
+  UanPdp densePdp = denseProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr.clone ()), symbolTime);
+  UanPdp sparsePdp = sparseProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr.clone ()), symbolTime);
+  UanPdp denseIntPdp = denseProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (intTimeArr.clone ()), symbolTime);
+  UanPdp sparseIntPdp = sparseProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (intTimeArr.clone ()), symbolTime);
+
+  NS_TEST_ASSERT_MSG_GT (densePdp.GetNTaps (), sparsePdp.GetNTaps (), "dense PDP is not zero filled");
+
+  Ptr<WossRxPowerChannel> channel = CreateObject<WossRxPowerChannel> ();
+
+  for (double ampThres : { 1.0E-6, 5.0E-4, 5.0E-3 })
+    {
+      double denseRxPowerDb = 0.0;
+      double sparseRxPowerDb = 0.0;
+      Time denseDelay;
+      Time sparseDelay;
+
+      channel->ComputeRxPowerAndDelay (densePdp, 150.0, ampThres, denseRxPowerDb, denseDelay);
+      channel->ComputeRxPowerAndDelay (sparsePdp, 150.0, ampThres, sparseRxPowerDb, sparseDelay);
+
+      NS_TEST_ASSERT_MSG_EQ_TOL (sparseRxPowerDb, denseRxPowerDb, 1.0E-9, "different rx power, threshold " << ampThres);
+      NS_TEST_ASSERT_MSG_EQ (sparseDelay, denseDelay, "different delay, threshold " << ampThres);
+    }
+
+  UanTxMode mode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 200, 200, 22000, 4000, 4, "Test Mode");
+  Ptr<Packet> packet = Create<Packet> (17);
+  Ptr<Packet> intPacket = Create<Packet> (17);
+  Time arrTime = Seconds (10.0);
+  const double rxPowerDb = 80.0;
+  const double ambNoiseDb = 40.0;
+
+  // no kernel published, the SINR model builds them from the PDPs
+  WossPdpKernelRegistry::Clear ();
+
+  UanTransducer::ArrivalList denseArrivals;
+  denseArrivals.push_back (UanPacketArrival (packet, rxPowerDb, mode, densePdp, arrTime));
+  denseArrivals.push_back (UanPacketArrival (intPacket, 75.0, mode, denseIntPdp, arrTime + Seconds (0.03)));
+
+  UanTransducer::ArrivalList sparseArrivals;
+  sparseArrivals.push_back (UanPacketArrival (packet, rxPowerDb, mode, sparsePdp, arrTime));
+  sparseArrivals.push_back (UanPacketArrival (intPacket, 75.0, mode, sparseIntPdp, arrTime + Seconds (0.03)));
+
+  Ptr<UanPhyCalcSinrDefault> defaultSinr = CreateObject<UanPhyCalcSinrDefault> ();
+  double defaultSinrDb = defaultSinr->CalcSinrDb (packet, arrTime, rxPowerDb, ambNoiseDb, mode, densePdp, denseArrivals);
+
+  for (Time eqWindow : { Seconds (0.0), Seconds (3 * symbolTime), Seconds (50 * symbolTime) })
+    {
+      for (bool intOverlap : { false, true })
+        {
+          Ptr<WossPhyCalcSinr> sinrModel = CreateObjectWithAttributes<WossPhyCalcSinr> ("EqualizerWindow", TimeValue (eqWindow),
+                                                                                      "InterferenceOverlap", BooleanValue (intOverlap));
+
+          double denseSinrDb = sinrModel->CalcSinrDb (packet, arrTime, rxPowerDb, ambNoiseDb, mode, densePdp, denseArrivals);
+          double sparseSinrDb = sinrModel->CalcSinrDb (packet, arrTime, rxPowerDb, ambNoiseDb, mode, sparsePdp, sparseArrivals);
+
+          NS_TEST_ASSERT_MSG_EQ_TOL (sparseSinrDb, denseSinrDb, 1.0E-9,
+                                     "different SINR, window " << eqWindow << " overlap " << intOverlap);
+
+          if (eqWindow.IsZero () && !intOverlap)
+            {
+              NS_TEST_ASSERT_MSG_EQ_TOL (denseSinrDb, defaultSinrDb, 1.0E-9, "zero window SINR differs from UanPhyCalcSinrDefault");
+            }
+        }
+    }
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS PDP truncation test
+ *
+ * A weak first arrival is followed by the first usable tap and by a tail.
+ * It checks, in dense and sparse mode, that the delay window starts at the first usable tap, that the energy
+ * truncation keeps it, the values of the truncation trace, and that GetFirstTapDelay matches the delay of the
+ * truncated PDP in WossChannel.
+ */
+class WossPdpTruncationTest : public TestCase
+{
+public:
+  WossPdpTruncationTest ();
+
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Stores the values of the last PDP truncation
+   * \param tapsBefore taps before the truncation
+   * \param tapsAfter taps kept
+   * \param removedFraction fraction of the PDP energy removed
+   */
+  void RecordTruncation (uint32_t tapsBefore, uint32_t tapsAfter, double removedFraction);
+
+  uint32_t m_truncations; //!< number of truncations
+  uint32_t m_tapsBefore; //!< taps before the last truncation
+  uint32_t m_tapsAfter; //!< taps after the last truncation
+  double m_removedFraction; //!< energy fraction removed by the last truncation
+};
+
+WossPdpTruncationTest::WossPdpTruncationTest ()
+  : TestCase ("WOSS PDP truncation"),
+    m_truncations (0),
+    m_tapsBefore (0),
+    m_tapsAfter (0),
+    m_removedFraction (0.0)
+{
+}
+
+void
+WossPdpTruncationTest::RecordTruncation (uint32_t tapsBefore, uint32_t tapsAfter, double removedFraction)
+{
+  ++m_truncations;
+  m_tapsBefore = tapsBefore;
+  m_tapsAfter = tapsAfter;
+  m_removedFraction = removedFraction;
+}
+
+void
+WossPdpTruncationTest::DoRun (void)
+{
+  // power of two symbol time, so the arrivals fall exactly on the taps
+  const double symbolTime = 1.0 / 256.0;
+  const double startTime = 0.5;
+  const double usableAmpThres = 5.0E-3;
+
+  // symbol index and amplitude of the arrivals, the first usable one is at index 40
+  const std::vector< std::pair<int, double> > arrivals = { { 0, 1.0E-5 }, { 7, 1.0E-3 }, { 40, 1.0E-2 },
+                                                           { 60, 2.0E-3 }, { 100, 5.0E-4 } };
+  woss::TimeArr timeArr;
+  double totalEnergy = 0.0;
+
+  for (const auto &arrival : arrivals)
+    {
+      timeArr.insertValue (startTime + arrival.first * symbolTime, std::polar (arrival.second, 0.3 * arrival.first));
+      totalEnergy += arrival.second * arrival.second;
+    }
+
+  // the last arrival closes the PDP and is not one of its taps
+  timeArr.insertValue (startTime + 101 * symbolTime, std::polar (1.0E-6, 0.0));
+
+  struct TruncationCase
+  {
+    double energyFraction; //!< TruncationEnergyFraction attribute
+    int delayWindow; //!< TruncationDelayWindow attribute, in symbols
+    double ampThres; //!< usable tap threshold
+    uint32_t denseTaps; //!< dense taps kept
+    uint32_t sparseTaps; //!< sparse taps kept
+    double removedEnergy; //!< energy removed
+  };
+
+  const std::vector<TruncationCase> cases = {
+    // the window starts at the first usable tap and drops only the tap at index 100
+    { 0.0, 30, usableAmpThres, 71, 4, 5.0E-4 * 5.0E-4 },
+    // without a threshold the window starts at the first arrival
+    { 0.0, 30, 0.0, 31, 2, 1.0E-4 + 4.0E-6 + 5.0E-4 * 5.0E-4 },
+    // the tail up to the first usable tap is within the fraction, but the first usable tap is kept
+    { 0.995, 0, usableAmpThres, 41, 3, 4.0E-6 + 5.0E-4 * 5.0E-4 },
+  };
+
+  Ptr<WossRxPowerChannel> channel = CreateObject<WossRxPowerChannel> ();
+
+  for (bool sparse : { false, true })
+    {
+      for (const TruncationCase &truncCase : cases)
+        {
+          Ptr<WossDelayPropModel> wossProp = CreateObjectWithAttributes<WossDelayPropModel> (
+            "SparsePdp", BooleanValue (sparse),
+            "TruncationEnergyFraction", DoubleValue (truncCase.energyFraction),
+            "TruncationDelayWindow", TimeValue (Seconds (truncCase.delayWindow * symbolTime)));
+
+          wossProp->TraceConnectWithoutContext ("PdpTruncation",
+                                                MakeCallback (&WossPdpTruncationTest::RecordTruncation, this));
+          m_truncations = 0;
+
+          UanPdp pdp = wossProp->CreateUanPdp (std::unique_ptr<woss::TimeArr> (timeArr.clone ()), symbolTime, 1.0,
+                                               truncCase.ampThres);
+
+          NS_TEST_ASSERT_MSG_EQ (m_truncations, 1, "one truncation expected, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ (m_tapsBefore, sparse ? 5 : 101, "wrong taps before truncation, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ (m_tapsAfter, sparse ? truncCase.sparseTaps : truncCase.denseTaps,
+                                 "wrong taps after truncation, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ (pdp.GetNTaps (), m_tapsAfter, "trace and PDP disagree, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ_TOL (m_removedFraction, truncCase.removedEnergy / totalEnergy, 1.0E-9,
+                                     "wrong removed energy fraction, sparse " << sparse);
+
+          if (truncCase.ampThres <= 0.0)
+            {
+              continue;
+            }
+
+          double rxPowerDb = -HUGE_VAL;
+          Time delay;
+          double chAttThresDb = -20.0 * std::log10 (truncCase.ampThres);
+
+          channel->ComputeRxPowerAndDelay (pdp, 0.0, truncCase.ampThres, rxPowerDb, delay);
+
+          NS_TEST_ASSERT_MSG_EQ (std::isfinite (rxPowerDb), true, "first usable tap truncated, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ (delay, Seconds (startTime + 40 * symbolTime), "wrong delay, sparse " << sparse);
+          NS_TEST_ASSERT_MSG_EQ (wossProp->GetFirstTapDelay (timeArr, symbolTime, chAttThresDb), delay,
+                                 "GetFirstTapDelay differs from the truncated PDP, sparse " << sparse);
+        }
+    }
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS overlapping interference test
+ *
+ * A reception and an interferer overlap in time, both with a weak tap before the first usable one.
+ * It checks that WossPhyCalcSinr places the interferer in time from its anchor tap, counts the energy of both
+ * packets from the anchor tap on, and that the kernel registry is purged by WossChannel::DoDispose and cleared
+ * by Simulator::Destroy.
+ */
+class WossOverlapSinrTest : public TestCase
+{
+public:
+  WossOverlapSinrTest ();
+
+  virtual void DoRun (void);
+};
+
+WossOverlapSinrTest::WossOverlapSinrTest ()
+  : TestCase ("WOSS overlapping interference")
+{
+}
+
+void
+WossOverlapSinrTest::DoRun (void)
+{
+  const double resolution = 1.0 / 200.0;
+  const Time anchorDelay = Seconds (0.4);
+
+  // weak first tap, first usable tap at the anchor delay, and a tail
+  std::vector<Tap> taps;
+  taps.push_back (Tap (Seconds (0.0), std::complex<double> (0.5, 0.0)));
+  taps.push_back (Tap (anchorDelay, std::complex<double> (1.0, 0.0)));
+  taps.push_back (Tap (Seconds (0.45), std::complex<double> (0.0, 0.5)));
+  UanPdp pdp (taps, Seconds (resolution));
+
+  std::vector<Tap> intTaps;
+  intTaps.push_back (Tap (Seconds (0.0), std::complex<double> (0.5, 0.0)));
+  intTaps.push_back (Tap (anchorDelay, std::complex<double> (1.0, 0.0)));
+  intTaps.push_back (Tap (Seconds (1.7), std::complex<double> (0.0, 0.5)));
+  intTaps.push_back (Tap (Seconds (2.5), std::complex<double> (-0.5, 0.0)));
+  UanPdp intPdp (intTaps, Seconds (resolution));
+
+  WossPdpKernel intKernel (intPdp, anchorDelay);
+
+  NS_TEST_ASSERT_MSG_EQ (intKernel.GetAnchorDelay (), anchorDelay, "wrong anchor delay");
+  NS_TEST_ASSERT_MSG_EQ_TOL (intKernel.GetAnchorEnergy (), 1.5, 1.0E-12, "wrong anchor energy");
+  NS_TEST_ASSERT_MSG_EQ (WossPdpKernel (intPdp).GetAnchorDelay (), Seconds (0.0), "default anchor is not the first tap");
+
+  // 25 bytes at 200 bps, both packets last one second
+  UanTxMode mode = UanTxModeFactory::CreateMode (UanTxMode::PSK, 200, 200, 22000, 4000, 4, "Test Mode");
+  Ptr<Packet> packet = Create<Packet> (25);
+  Ptr<Packet> intPacket = Create<Packet> (25);
+  Time arrTime = Seconds (10.0);
+  Time intArrTime = Seconds (9.5);
+  const double rxPowerDb = 80.0;
+  const double intRxPowerDb = 75.0;
+  const double ambNoiseDb = 40.0;
+
+  WossPdpKernelRegistry::Clear ();
+  WossPdpKernelRegistry::Publish (packet, std::make_shared<const WossPdpKernel> (pdp, anchorDelay));
+  WossPdpKernelRegistry::Publish (intPacket, std::make_shared<const WossPdpKernel> (intPdp, anchorDelay));
+
+  UanTransducer::ArrivalList arrivals;
+  arrivals.push_back (UanPacketArrival (intPacket, intRxPowerDb, mode, intPdp, intArrTime));
+  arrivals.push_back (UanPacketArrival (packet, rxPowerDb, mode, pdp, arrTime));
+
+  Ptr<WossPhyCalcSinr> sinrModel = CreateObjectWithAttributes<WossPhyCalcSinr> ("EqualizerWindow", TimeValue (Seconds (0.02)),
+                                                                              "InterferenceOverlap", BooleanValue (true));
+
+  // useful signal: the anchor tap over the energy from the anchor on
+  double usefulFraction = 1.0 / 1.25;
+  // the interferer anchor tap arrives at 9.5 s, the tap at 1.7 s at 10.8 s, the tap at 2.5 s after the reception
+  double overlapFraction = 1.25 / 1.5;
+  double rxPowerKp = std::pow (10.0, rxPowerDb / 10.0);
+  double intKp = std::pow (10.0, ambNoiseDb / 10.0) + rxPowerKp * (1.0 - usefulFraction)
+    + std::pow (10.0, intRxPowerDb / 10.0) * overlapFraction;
+  double expectedSinrDb = 10.0 * std::log10 (rxPowerKp * usefulFraction) - 10.0 * std::log10 (intKp);
+
+  double sinrDb = sinrModel->CalcSinrDb (packet, arrTime, rxPowerDb, ambNoiseDb, mode, pdp, arrivals);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (sinrDb, expectedSinrDb, 1.0E-9, "wrong SINR of the overlapping arrivals");
+
+  // the registry holds the only reference of the second packet
+  Ptr<WossChannel> channel = CreateObjectWithAttributes<WossChannel> ("PdpKernels", BooleanValue (true));
+  intPacket = nullptr;
+  arrivals.clear ();
+
+  channel->Dispose ();
+  NS_TEST_ASSERT_MSG_EQ (WossPdpKernelRegistry::GetSize (), 1, "unreferenced packet not purged by the channel");
+
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (WossPdpKernelRegistry::GetSize (), 0, "registry not cleared by Simulator::Destroy");
+}
+
+
+/**
+ * WossPropModel exposing the geodetic position conversion
+ */
+class WossCoordZPropModel : public WossPropModel
+{
+public:
+  using WossPropModel::CreateCoordZ;
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS CoordZ cache test
+ *
+ * It checks that the geodetic position of a static node is converted once, that it is converted again
+ * after the node moves, and that the entries of released mobility models are purged.
+ */
+class WossCoordZCacheTest : public TestCase
+{
+public:
+  WossCoordZCacheTest ();
+
+  virtual void DoRun (void);
+};
+
+WossCoordZCacheTest::WossCoordZCacheTest ()
+  : TestCase ("WOSS CoordZ cache")
+{
+}
+
+void
+WossCoordZCacheTest::DoRun (void)
+{
+  Ptr<WossCoordZPropModel> wossProp = CreateObject<WossCoordZPropModel> ();
+  woss::CoordZ coordZ (42.59, 10.125, 30.0);
+
+  Ptr<ConstantPositionMobilityModel> node = CreateObject<ConstantPositionMobilityModel> ();
+  node->SetPosition (CreateVectorFromCoordZ (coordZ));
+
+  woss::CoordZ first = wossProp->CreateCoordZ (node);
+  woss::CoordZ second = wossProp->CreateCoordZ (node);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (first.getGreatCircleDistance (coordZ), 0.0, 1.0E-3, "wrong conversion");
+  NS_TEST_ASSERT_MSG_EQ (second.getLatitude (), first.getLatitude (), "cached latitude differs");
+  NS_TEST_ASSERT_MSG_EQ (second.getDepth (), first.getDepth (), "cached depth differs");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZConversions (), 1, "static node converted twice");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZCacheSize (), 1, "wrong cache size");
+
+  woss::CoordZ moved (woss::Coord::getCoordFromBearing (coordZ, M_PI / 2.0, 500.0), 40.0);
+  node->SetPosition (CreateVectorFromCoordZ (moved));
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (wossProp->CreateCoordZ (node).getGreatCircleDistance (moved), 0.0, 1.0E-3,
+                             "stale position after the move");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZConversions (), 2, "moved node not converted");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZCacheSize (), 1, "moved node cached twice");
+
+  // released models are purged when the cache reaches its purge size, 64 entries
+  for (uint32_t i = 0; i < 64; ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> released = CreateObject<ConstantPositionMobilityModel> ();
+      released->SetPosition (CreateVectorFromCoordZ (woss::CoordZ (coordZ, 10.0 + i)));
+      wossProp->CreateCoordZ (released);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZConversions (), 66, "wrong conversions of the released models");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZCacheSize (), 2, "released models not purged");
+
+  wossProp->CreateCoordZ (node);
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZConversions (), 66, "referenced model purged");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS geodetic position fast path test
+ *
+ * A node moves along a WossGeoWaypointMobilityModel leg. It checks that WossPropModel::CreateCoordZ and
+ * WossLocation::getLocation return the native geographic position of the model, without any cartesian
+ * to geodetic conversion.
+ */
+class WossGeoCoordZTest : public TestCase
+{
+public:
+  WossGeoCoordZTest ();
+
+  virtual void DoRun (void);
+};
+
+WossGeoCoordZTest::WossGeoCoordZTest ()
+  : TestCase ("WOSS geodetic position fast path")
+{
+}
+
+void
+WossGeoCoordZTest::DoRun (void)
+{
+  Ptr<WossCoordZPropModel> wossProp = CreateObject<WossCoordZPropModel> ();
+
+  Ptr<WossGeoWaypointMobilityModel> mob = CreateObject<WossGeoWaypointMobilityModel> ();
+  mob->AddWaypoint (Seconds (10.0), woss::CoordZ (42.59, 10.125, 20.0));
+  mob->AddWaypoint (Seconds (110.0), woss::CoordZ (42.65, 10.25, 60.0));
+
+  WossLocation location (mob);
+
+  for (double time : { 5.0, 30.0, 50.0, 90.0, 150.0 })
+    {
+      Simulator::Schedule (Seconds (time), [this, wossProp, mob, &location, time] ()
+        {
+          woss::CoordZ expected = mob->GetCoordZ ();
+          woss::CoordZ coordZ = wossProp->CreateCoordZ (mob);
+          woss::CoordZ locCoordZ = location.getLocation ();
+
+          // a cartesian round trip would not give back the same bits
+          NS_TEST_EXPECT_MSG_EQ (coordZ.getLatitude (), expected.getLatitude (), "converted latitude at " << time);
+          NS_TEST_EXPECT_MSG_EQ (coordZ.getLongitude (), expected.getLongitude (), "converted longitude at " << time);
+          NS_TEST_EXPECT_MSG_EQ (coordZ.getDepth (), expected.getDepth (), "converted depth at " << time);
+          NS_TEST_EXPECT_MSG_EQ (locCoordZ.getLatitude (), expected.getLatitude (), "converted location latitude at " << time);
+          NS_TEST_EXPECT_MSG_EQ (locCoordZ.getLongitude (), expected.getLongitude (), "converted location longitude at " << time);
+          NS_TEST_EXPECT_MSG_EQ (locCoordZ.getDepth (), expected.getDepth (), "converted location depth at " << time);
+        });
+    }
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZConversions (), 0, "cartesian to geodetic conversion on the fast path");
+  NS_TEST_ASSERT_MSG_EQ (wossProp->GetCoordZCacheSize (), 0, "geodetic model cached");
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS CPU list parser test
+ *
+ * It feeds valid and malformed kernel cpulist strings to WossHelper::ParseCpuList: valid lists must give the
+ * sorted CPU numbers without duplicates, malformed ones must be rejected with an empty list.
+ */
+class WossCpuListTest : public TestCase
+{
+public:
+  WossCpuListTest ();
+
+  virtual void DoRun (void);
+};
+
+WossCpuListTest::WossCpuListTest ()
+  : TestCase ("WOSS CPU list parser")
+{
+}
+
+void
+WossCpuListTest::DoRun (void)
+{
+  std::vector<int> cpus;
+
+  NS_TEST_ASSERT_MSG_EQ (WossHelper::ParseCpuList ("8, 0-3,10-11,2", cpus), true, "valid CPU list rejected");
+  NS_TEST_ASSERT_MSG_EQ ((cpus == std::vector<int> { 0, 1, 2, 3, 8, 10, 11 }), true, "wrong CPUs of a valid list");
+
+  NS_TEST_ASSERT_MSG_EQ (WossHelper::ParseCpuList ("5", cpus), true, "single CPU rejected");
+  NS_TEST_ASSERT_MSG_EQ ((cpus == std::vector<int> { 5 }), true, "wrong single CPU");
+
+  NS_TEST_ASSERT_MSG_EQ (WossHelper::ParseCpuList ("1,,2\n", cpus), true, "blank items not skipped");
+  NS_TEST_ASSERT_MSG_EQ ((cpus == std::vector<int> { 1, 2 }), true, "wrong CPUs with blank items");
+
+  for (const char *cpuList : { "3-1", "a", "1-", "-1", "1-2-3", "0,x", "1.5", "0-4096", "+1", "2 3" })
+    {
+      cpus = { 0 };
+      NS_TEST_ASSERT_MSG_EQ (WossHelper::ParseCpuList (cpuList, cpus), false, "malformed CPU list accepted: " << cpuList);
+      NS_TEST_ASSERT_MSG_EQ (cpus.empty (), true, "partial CPU list kept: " << cpuList);
+    }
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * WOSS profiler test
+ *
+ * Stage executions are recorded by hand. It checks the per-stage counters, the JSON written by WriteJson
+ * (one object per stage, with the latency in its log2 histogram bin), and that the output file is written
+ * again when set after a Simulator::Destroy.
+ */
+class WossProfilerTest : public TestCase
+{
+public:
+  WossProfilerTest ();
+
+  virtual void DoRun (void);
+};
+
+WossProfilerTest::WossProfilerTest ()
+  : TestCase ("WOSS profiler")
+{
+}
+
+void
+WossProfilerTest::DoRun (void)
+{
+  Ptr<WossProfiler> profiler = CreateObject<WossProfiler> ();
+
+  // 1 us and 3 us fall in the bins of 2^9 and 2^11 ns
+  profiler->Record (WossProfiler::TIME_ARR_RETRIEVAL, 1.0E-6, 4);
+  profiler->Record (WossProfiler::TIME_ARR_RETRIEVAL, 3.0E-6, 2);
+  profiler->Record (WossProfiler::TX_SCHEDULING, 1.0E-6);
+
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetCount (WossProfiler::TIME_ARR_RETRIEVAL), 2, "wrong stage count");
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetItems (WossProfiler::TIME_ARR_RETRIEVAL), 6, "wrong stage items");
+  NS_TEST_ASSERT_MSG_EQ_TOL (profiler->GetTotalTime (WossProfiler::TIME_ARR_RETRIEVAL), 4.0E-6, 1.0E-15, "wrong stage time");
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetItems (WossProfiler::TX_SCHEDULING), 1, "wrong default items");
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetCount (WossProfiler::COHERENT_SUM), 0, "unrecorded stage counted");
+
+  std::ostringstream json;
+  profiler->WriteJson (json);
+  std::string text = json.str ();
+
+  NS_TEST_ASSERT_MSG_EQ (text.rfind ("{\n  \"stages\": [\n", 0), 0, "wrong JSON header");
+  NS_TEST_ASSERT_MSG_EQ (text.substr (text.size () - 6), "  ]\n}\n", "wrong JSON trailer");
+
+  std::string::size_type stageCount = 0;
+
+  for (std::string::size_type pos = text.find ("{\"name\": "); pos != std::string::npos; pos = text.find ("{\"name\": ", pos + 1))
+    {
+      stageCount++;
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (stageCount, (std::string::size_type) WossProfiler::STAGE_TOTAL, "wrong number of stage objects");
+
+  std::string::size_type stagePos = text.find ("{\"name\": \"TimeArrRetrieval\", \"count\": 2, \"items\": 6, ");
+  NS_TEST_ASSERT_MSG_NE (stagePos, std::string::npos, "stage counters not in the JSON");
+
+  std::string histogram = text.substr (text.find ("\"histogram_log2_ns\": [", stagePos));
+  histogram = histogram.substr (histogram.find ('[') + 1, histogram.find (']') - histogram.find ('[') - 1);
+
+  std::istringstream bins (histogram);
+  std::vector<uint64_t> binCounts;
+  std::string bin;
+
+  while (std::getline (bins, bin, ','))
+    {
+      binCounts.push_back (std::stoull (bin));
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (binCounts.size (), (size_t) WossProfiler::HISTOGRAM_BINS, "wrong number of histogram bins");
+  NS_TEST_ASSERT_MSG_EQ (binCounts[9], 1, "1 us latency in the wrong bin");
+  NS_TEST_ASSERT_MSG_EQ (binCounts[11], 1, "3 us latency in the wrong bin");
+
+  profiler->Reset ();
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetCount (WossProfiler::TIME_ARR_RETRIEVAL), 0, "counters not reset");
+
+  // the output is scheduled again by a run following Simulator::Destroy
+  std::string outputFile = CreateTempDirFilename ("woss-profiler.json");
+
+  for (uint32_t run = 0; run < 2; ++run)
+    {
+      std::remove (outputFile.c_str ());
+
+      profiler->SetOutputFile (outputFile);
+      Simulator::Run ();
+      Simulator::Destroy ();
+
+      std::ifstream output (outputFile);
+      NS_TEST_ASSERT_MSG_EQ (output.is_open (), true, "profiler output not written in run " << run);
+    }
+
+  std::remove (outputFile.c_str ());
+}
+
+
+/**
+ * \ingroup woss
+ *
+ * Noise model with a constant power spectral density, changed by the test
+ */
+class WossConstantNoiseModel : public UanNoiseModel
+{
+public:
+  /**
+   * \param fKhz frequency [kHz], not used
+   * \returns the noise power spectral density [dB/Hz]
+   */
+  virtual double GetNoiseDbHz (double fKhz) const override
+  {
+    return m_noiseDbHz;
+  }
+
+  double m_noiseDbHz = 40.0; //!< noise power spectral density [dB/Hz]
+};
+
+/**
+ * \ingroup woss
+ *
+ * WossChannel exposing GetTxModeNoise
+ */
+class WossTxModeNoiseChannel : public WossChannel
+{
+public:
+  using WossChannel::GetTxModeNoise;
+};
+
+/**
+ * \ingroup woss
+ *
+ * WOSS TxMode noise cache test
+ *
+ * The noise power and the thresholds of a mode are cached by WossChannel::GetTxModeNoise.
+ * It checks that the cached entry follows a new transmission power, a new noise model, a new
+ * ChannelEqSnrThresholdDb, and a noise model changed in place once InvalidateTxModeCache is called.
+ */
+class WossTxModeNoiseTest : public TestCase
+{
+public:
+  WossTxModeNoiseTest ();
+
+  virtual void DoRun (void);
+};
+
+WossTxModeNoiseTest::WossTxModeNoiseTest ()
+  : TestCase ("WOSS TxMode noise cache")
+{
+}
+
+void
+WossTxModeNoiseTest::DoRun (void)
+{
+  Ptr<WossTxModeNoiseChannel> channel = CreateObject<WossTxModeNoiseChannel> ();
+  channel->SetAttribute ("ChannelEqSnrThresholdDb", DoubleValue (10.0));
+
+  Ptr<WossConstantNoiseModel> firstNoise = CreateObject<WossConstantNoiseModel> ();
+  channel->SetNoiseModel (firstNoise);
+
+  // 1 kHz of bandwidth adds 30 dB to the noise spectral density
+  UanTxMode mode = UanTxModeFactory::CreateMode (UanTxMode::FSK, 1000, 1000, 25000, 1000, 2, "Noise test mode");
+
+  double noisePwrDb = channel->GetTxModeNoise (mode, 190.0).noisePwrDb;
+  double chAttThresDb = channel->GetTxModeNoise (mode, 190.0).chAttThresDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (noisePwrDb, 70.0, 1.0E-9, "wrong noise power");
+  NS_TEST_ASSERT_MSG_EQ_TOL (chAttThresDb, 110.0, 1.0E-9, "wrong attenuation threshold");
+  NS_TEST_ASSERT_MSG_EQ_TOL (channel->GetTxModeNoise (mode, 190.0).ampThres, std::pow (10.0, -110.0 / 20.0), 1.0E-15,
+                             "wrong amplitude threshold");
+
+  chAttThresDb = channel->GetTxModeNoise (mode, 200.0).chAttThresDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (chAttThresDb, 120.0, 1.0E-9, "new transmission power not followed");
+
+  Ptr<WossConstantNoiseModel> secondNoise = CreateObject<WossConstantNoiseModel> ();
+  secondNoise->m_noiseDbHz = 50.0;
+  channel->SetNoiseModel (secondNoise);
+
+  noisePwrDb = channel->GetTxModeNoise (mode, 200.0).noisePwrDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (noisePwrDb, 80.0, 1.0E-9, "new noise model not detected");
+  chAttThresDb = channel->GetTxModeNoise (mode, 200.0).chAttThresDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (chAttThresDb, 110.0, 1.0E-9, "threshold of the old noise model kept");
+
+  channel->SetAttribute ("ChannelEqSnrThresholdDb", DoubleValue (20.0));
+
+  chAttThresDb = channel->GetTxModeNoise (mode, 200.0).chAttThresDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (chAttThresDb, 100.0, 1.0E-9, "new SNR threshold not followed");
+
+  // a noise model changed in place is detected only through InvalidateTxModeCache
+  secondNoise->m_noiseDbHz = 60.0;
+
+  noisePwrDb = channel->GetTxModeNoise (mode, 200.0).noisePwrDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (noisePwrDb, 80.0, 1.0E-9, "noise power not cached");
+
+  channel->InvalidateTxModeCache ();
+
+  noisePwrDb = channel->GetTxModeNoise (mode, 200.0).noisePwrDb;
+  chAttThresDb = channel->GetTxModeNoise (mode, 200.0).chAttThresDb;
+  NS_TEST_ASSERT_MSG_EQ_TOL (noisePwrDb, 90.0, 1.0E-9, "noise power not recomputed after InvalidateTxModeCache");
+  NS_TEST_ASSERT_MSG_EQ_TOL (chAttThresDb, 90.0, 1.0E-9, "threshold not recomputed after InvalidateTxModeCache");
+
+  channel->Dispose ();
+}
+
+
 class WossTestSuite : public TestSuite
 {
 public:
@@ -435,6 +2652,31 @@ WossTestSuite::WossTestSuite ()
   :  TestSuite ("devices-woss", Type::UNIT)
 {
   AddTestCase (new WossTest, Duration::QUICK);
+  AddTestCase (new WossStubTest, Duration::QUICK);
+  AddTestCase (new WossPositionAllocatorTest, Duration::QUICK);
+  AddTestCase (new WossBathymetryPositionAllocatorTest, Duration::QUICK);
+  AddTestCase (new WossGridFieldTest, Duration::QUICK);
+  AddTestCase (new WossDelayTest, Duration::QUICK);
+  AddTestCase (new WossPdpKernelTest, Duration::QUICK);
+  AddTestCase (new WossGreatCircleTest, Duration::QUICK);
+  AddTestCase (new WossGeoWaypointMobilityTest, Duration::QUICK);
+  AddTestCase (new WossWaypointMobilityTest, Duration::QUICK);
+  AddTestCase (new WossTiledCustomDataTest, Duration::QUICK);
+  AddTestCase (new WossSnapshotTest, Duration::QUICK);
+  AddTestCase (new WossParserTest, Duration::QUICK);
+  AddTestCase (new WossGridFieldPrecedenceTest, Duration::QUICK);
+  AddTestCase (new WossTransectCacheTest, Duration::QUICK);
+  AddTestCase (new WossWidebandDelayTest, Duration::QUICK);
+  AddTestCase (new WossFreqResponseTest, Duration::QUICK);
+  AddTestCase (new WossDeliveryTest, Duration::QUICK);
+  AddTestCase (new WossSparsePdpTest, Duration::QUICK);
+  AddTestCase (new WossPdpTruncationTest, Duration::QUICK);
+  AddTestCase (new WossOverlapSinrTest, Duration::QUICK);
+  AddTestCase (new WossCoordZCacheTest, Duration::QUICK);
+  AddTestCase (new WossGeoCoordZTest, Duration::QUICK);
+  AddTestCase (new WossCpuListTest, Duration::QUICK);
+  AddTestCase (new WossProfilerTest, Duration::QUICK);
+  AddTestCase (new WossTxModeNoiseTest, Duration::QUICK);
 }
 
 static WossTestSuite g_uanWossTestSuite;